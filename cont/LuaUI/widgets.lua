@@ -720,6 +720,75 @@ local function SafeWrapWidget(widget)
 end
 
 
+--------------------------------------------------------------------------------
+--
+--  call-in profiler scopes
+--
+--  while the engine's call-in profiler is enabled, every widget call-in
+--  is swapped for a wrapper that opens a scope named after the widget;
+--  the call-in loops stay untouched and cost nothing extra otherwise
+--
+
+local PushCallInProfilerScope = Spring.PushCallInProfilerScope
+local PopCallInProfilerScope  = Spring.PopCallInProfilerScope
+
+local callInProfiling = Spring.IsCallInProfilerEnabled()
+local profiledWidgets = {} -- widget -> { ciName = { func, wrapper } }
+
+
+local function PopScope(...)
+  PopCallInProfilerScope()
+  return ...
+end
+
+
+local function ProfileWrap(func, name)
+  return function(w, ...)
+    PushCallInProfilerScope(name)
+    return PopScope(func(w, ...))
+  end
+end
+
+
+local function ProfileWrapCallIn(widget, ciName)
+  local funcs = profiledWidgets[widget]
+  local func = widget[ciName]
+  if (funcs == nil or type(func) ~= 'function') then
+    return
+  end
+  if (funcs[ciName] and funcs[ciName][2] == func) then
+    return -- already wrapped
+  end
+  local wrapper = ProfileWrap(func, widget.whInfo.name)
+  funcs[ciName] = { func, wrapper }
+  widget[ciName] = wrapper
+end
+
+
+local function ProfileWrapWidget(widget)
+  profiledWidgets[widget] = profiledWidgets[widget] or {}
+  for _,ciName in ipairs(callInLists) do
+    ProfileWrapCallIn(widget, ciName)
+  end
+end
+
+
+local function ProfileUnwrapWidget(widget)
+  local funcs = profiledWidgets[widget]
+  if (funcs == nil) then
+    return
+  end
+  for _,ciName in ipairs(callInLists) do
+    local f = funcs[ciName]
+    -- leave call-ins the widget has replaced since alone
+    if (f and widget[ciName] == f[2]) then
+      widget[ciName] = f[1]
+    end
+  end
+  profiledWidgets[widget] = nil
+end
+
+
 --------------------------------------------------------------------------------
 
 local function ArrayInsert(t, f, w)
@@ -755,6 +824,9 @@ function widgetHandler:InsertWidget(widget)
   end
 
   SafeWrapWidget(widget)
+  if (callInProfiling) then
+    ProfileWrapWidget(widget)
+  end
 
   ArrayInsert(self.widgets, true, widget)
   for _,listname in ipairs(callInLists) do
@@ -784,6 +856,7 @@ function widgetHandler:RemoveWidget(widget)
   if (widget.Shutdown) then
     widget:Shutdown()
   end
+  ProfileUnwrapWidget(widget)
   ArrayRemove(self.widgets, widget)
   self:RemoveWidgetGlobals(widget)
   self.actionHandler:RemoveWidgetActions(widget)
@@ -827,6 +900,9 @@ function widgetHandler:UpdateWidgetCallIn(name, w)
   local listName = name .. 'List'
   local ciList = self[listName]
   if (ciList) then
+    if (callInProfiling) then
+      ProfileWrapCallIn(w, name)
+    end
     local func = w[name]
     if (type(func) == 'function') then
       ArrayInsert(ciList, func, w)
@@ -859,6 +935,21 @@ function widgetHandler:UpdateCallIns()
 end
 
 
+function widgetHandler:SetCallInProfiling(enabled)
+  if (enabled == callInProfiling) then
+    return
+  end
+  callInProfiling = enabled
+  for _,w in ipairs(self.widgets) do
+    if (enabled) then
+      ProfileWrapWidget(w)
+    else
+      ProfileUnwrapWidget(w)
+    end
+  end
+end
+
+
 function widgetHandler:SelectorActive()
   for _,w in ipairs(self.widgets) do
     if (w.whInfo.basename == SELECTOR_BASENAME) then
@@ -2116,6 +2207,11 @@ end
 --------------------------------------------------------------------------------
 --------------------------------------------------------------------------------
 
+-- not a widget call-in, sent by /LuaCallInProfiler
+function CallInProfilerChanged(enabled)
+  widgetHandler:SetCallInProfiling(enabled)
+end
+
 widgetHandler:Initialize()
 
 --------------------------------------------------------------------------------
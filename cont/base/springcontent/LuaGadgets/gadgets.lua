@@ -434,6 +434,75 @@ local function SafeWrapGadget(gadget)
 end
 
 
+--------------------------------------------------------------------------------
+--
+--  call-in profiler scopes
+--
+--  while the engine's call-in profiler is enabled, every gadget call-in
+--  is swapped for a wrapper that opens a scope named after the gadget;
+--  the call-in loops stay untouched and cost nothing extra otherwise
+--
+
+local PushCallInProfilerScope = Spring.PushCallInProfilerScope
+local PopCallInProfilerScope  = Spring.PopCallInProfilerScope
+
+local callInProfiling = Spring.IsCallInProfilerEnabled()
+local profiledGadgets = {} -- gadget -> { ciName = { func, wrapper } }
+
+
+local function PopScope(...)
+  PopCallInProfilerScope()
+  return ...
+end
+
+
+local function ProfileWrap(func, name)
+  return function(g, ...)
+    PushCallInProfilerScope(name)
+    return PopScope(func(g, ...))
+  end
+end
+
+
+local function ProfileWrapCallIn(gadget, ciName)
+  local funcs = profiledGadgets[gadget]
+  local func = gadget[ciName]
+  if (funcs == nil or type(func) ~= 'function') then
+    return
+  end
+  if (funcs[ciName] and funcs[ciName][2] == func) then
+    return -- already wrapped
+  end
+  local wrapper = ProfileWrap(func, gadget.ghInfo.name)
+  funcs[ciName] = { func, wrapper }
+  gadget[ciName] = wrapper
+end
+
+
+local function ProfileWrapGadget(gadget)
+  profiledGadgets[gadget] = profiledGadgets[gadget] or {}
+  for _,ciName in ipairs(CALLIN_LIST) do
+    ProfileWrapCallIn(gadget, ciName)
+  end
+end
+
+
+local function ProfileUnwrapGadget(gadget)
+  local funcs = profiledGadgets[gadget]
+  if (funcs == nil) then
+    return
+  end
+  for _,ciName in ipairs(CALLIN_LIST) do
+    local f = funcs[ciName]
+    -- leave call-ins the gadget has replaced since alone
+    if (f and gadget[ciName] == f[2]) then
+      gadget[ciName] = f[1]
+    end
+  end
+  profiledGadgets[gadget] = nil
+end
+
+
 --------------------------------------------------------------------------------
 
 local function ArrayInsert(t, g)
@@ -479,6 +548,9 @@ function gadgetHandler:InsertGadget(gadget)
       ArrayInsert(self[listname .. 'List'], gadget)
     end
   end
+  if (callInProfiling) then
+    ProfileWrapGadget(gadget)
+  end
 
   self:UpdateCallIns()
   if (gadget.Initialize) then
@@ -499,6 +571,7 @@ function gadgetHandler:RemoveGadget(gadget)
     gadget:Shutdown()
   end
 
+  ProfileUnwrapGadget(gadget)
   ArrayRemove(self.gadgets, gadget)
   self:RemoveGadgetGlobals(gadget)
   actionHandler.RemoveGadgetActions(gadget)
@@ -544,6 +617,9 @@ function gadgetHandler:UpdateGadgetCallIn(name, g)
   local listName = name .. 'List'
   local ciList = self[listName]
   if (ciList) then
+    if (callInProfiling) then
+      ProfileWrapCallIn(g, name)
+    end
     local func = g[name]
     if (func ~= nil and type(func) == 'function') then
       ArrayInsert(ciList, g)
@@ -576,6 +652,21 @@ function gadgetHandler:UpdateCallIns()
 end
 
 
+function gadgetHandler:SetCallInProfiling(enabled)
+  if (enabled == callInProfiling) then
+    return
+  end
+  callInProfiling = enabled
+  for _,g in ipairs(self.gadgets) do
+    if (enabled) then
+      ProfileWrapGadget(g)
+    else
+      ProfileUnwrapGadget(g)
+    end
+  end
+end
+
+
 --------------------------------------------------------------------------------
 --------------------------------------------------------------------------------
 
@@ -2121,6 +2212,11 @@ end
 --------------------------------------------------------------------------------
 --------------------------------------------------------------------------------
 
+-- not a gadget call-in, sent by /LuaCallInProfiler
+function CallInProfilerChanged(enabled)
+  gadgetHandler:SetCallInProfiling(enabled)
+end
+
 gadgetHandler:Initialize()
 
 --------------------------------------------------------------------------------
@@ -111,7 +111,10 @@
 #include "System/SpringExitCode.h"
 #include "System/SpringMath.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/VFSHandler.h"
 #include "System/LoadSave/LoadSaveHandler.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
+#include "System/LoadSave/DemoReader.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Misc.h"
@@ -451,6 +454,9 @@ void CGame::LoadGame(const std::string& mapFileName)
 	Watchdog::DeregisterThread(WDT_LOAD);
 	AddTimedJobs();
 
+	// everything the game needed in bulk has been read by now
+	vfsHandler->ReleasePrefetchedArchives();
+
 	if (forcedQuit)
 		spring::exitCode = spring::EXIT_CODE_FORCED;
 
@@ -1876,6 +1882,67 @@ void CGame::SaveGame(std::string&& fileName, std::string&& saveArgs)
 	globalSaveFileData.args = std::move(saveArgs);
 }
 
+void CGame::SaveDemoKeyFrame()
+{
+	const unsigned int keyFrameInterval = gameSetup->demoKeyFrameInterval * GAME_SPEED;
+
+	if (keyFrameInterval == 0 || (gs->frameNum % keyFrameInterval) != 0)
+		return;
+
+	CDemoRecorder* record = clientNet->GetDemoRecorder();
+
+	// saving runs a full GC pass over the synced Lua states; clients that
+	// take no savestate (not recording, or watching a replay) still have
+	// to run it on the same frames to stay in sync
+	if (record == nullptr || !record->HasKeyFrames()) {
+		CCregLoadSaveHandler::CollectSyncedLuaGarbage();
+		return;
+	}
+
+	CCregLoadSaveHandler saveHandler;
+	std::stringstream saveData;
+
+	saveHandler.SaveInfo(gameSetup->mapName, gameSetup->modName);
+
+	try {
+		if (saveHandler.SaveGameData(saveData))
+			record->AddKeyFrame(saveData.str());
+	} catch (const std::exception& ex) {
+		LOG_L(L_ERROR, "[Game::%s] could not save keyframe %d: \"%s\"", __func__, gs->frameNum, ex.what());
+	}
+}
+
+bool CGame::LoadDemoKeyFrame(int frameNum)
+{
+	if (!gameSetup->hostDemo)
+		return false;
+
+	std::string saveData;
+
+	try {
+		// the server is reading the same file, open a second reader for the savestate
+		CDemoReader demoReader(gameSetup->demoName, 0.0f);
+
+		const DemoIndexedKeyFrame* keyFrame = demoReader.FindKeyFrame(frameNum - 1, frameNum);
+
+		if (keyFrame == nullptr || !demoReader.ReadKeyFrame(*keyFrame, saveData))
+			return false;
+	} catch (const std::exception& ex) {
+		LOG_L(L_ERROR, "[Game::%s] could not read keyframe %d: \"%s\"", __func__, frameNum, ex.what());
+		return false;
+	}
+
+	// same path as ReloadGame, the savestate replaces the running simulation
+	CCregLoadSaveHandler loadHandler;
+
+	if (!loadHandler.LoadGameData(std::move(saveData)))
+		return false;
+
+	assert(gs->frameNum == frameNum);
+	LOG("[Game::%s] loaded demo keyframe %d", __func__, frameNum);
+	return true;
+}
+
 
 
 
@@ -92,6 +92,9 @@ public:
 	void ReloadGame();
 	void SaveGame(std::string&& fileName, std::string&& saveArgs);
 
+	void SaveDemoKeyFrame();
+	bool LoadDemoKeyFrame(int frameNum);
+
 	void ResizeEvent() override;
 
 	void SetDrawMode(Game::DrawMode mode) { gameDrawMode = mode; }
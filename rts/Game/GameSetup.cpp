@@ -38,6 +38,7 @@ CR_REG_METADATA(CGameSetup, (
 	CR_IGNORED(mapSeed),
 
 	CR_IGNORED(gameStartDelay),
+	CR_IGNORED(demoKeyFrameInterval),
 
 	CR_IGNORED(numDemoPlayers),
 	CR_IGNORED(maxUnitsPerTeam),
@@ -181,6 +182,7 @@ void CGameSetup::ResetState()
 	mapSeed = 0;
 
 	gameStartDelay = 0;
+	demoKeyFrameInterval = 0;
 	numDemoPlayers = 0;
 	maxUnitsPerTeam = 1500;
 
@@ -588,6 +590,7 @@ bool CGameSetup::Init(const std::string& buf)
 	hostDemo    = !demoName.empty();
 
 	file.GetTDef(gameStartDelay, 4u, "GAME\\GameStartDelay");
+	file.GetTDef(demoKeyFrameInterval, 0u, "GAME\\DemoKeyFrameInterval");
 
 	file.GetDef(recordDemo,          "1", "GAME\\RecordDemo");
 	file.GetDef(useLuaGaia,          "1", "GAME\\ModOptions\\LuaGaia");
@@ -46,6 +46,7 @@ public:
 		mapSeed = gs.mapSeed;
 
 		gameStartDelay = gs.gameStartDelay;
+		demoKeyFrameInterval = gs.demoKeyFrameInterval;
 
 		numDemoPlayers = gs.numDemoPlayers;
 		maxUnitsPerTeam = gs.maxUnitsPerTeam;
@@ -198,6 +199,14 @@ public:
 	 * Default: 4 (seconds)
 	 */
 	unsigned int gameStartDelay;
+	/**
+	 * Number of seconds between savestates embedded into client demos.
+	 * Part of the script rather than client config since taking one runs
+	 * a full (synced) Lua GC pass, which has to happen on the same frames
+	 * for every client.
+	 * Default: 0 (no keyframes)
+	 */
+	unsigned int demoKeyFrameInterval;
 
 	int numDemoPlayers;
 	int maxUnitsPerTeam;
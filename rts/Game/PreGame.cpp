@@ -48,6 +48,7 @@
 #include "System/Net/UnpackPacket.h"
 #include "System/Platform/errorhandler.h"
 #include "System/Platform/Misc.h"
+#include "System/Platform/Watchdog.h"
 #include "System/Sync/SyncedPrimitiveBase.h"
 #include "lib/luasocket/src/restrictions.h"
 #ifdef SYNCDEBUG
@@ -202,6 +203,8 @@ void CPreGame::AddGameSetupArchivesToVFS(const CGameSetup* setup, bool mapOnly)
 
 	// Load Game archive
 	vfsHandler->AddArchiveWithDeps(setup->modName, false);
+	// decode solid archives in one go rather than block-by-block on demand
+	vfsHandler->PrefetchArchives([]() { Watchdog::ClearTimer(WDT_MAIN); });
 
 	modFileName = archiveScanner->ArchiveFromName(setup->modName);
 	LOG("[PreGame::%s] using game: %s (archive: %s)", __func__, setup->modName.c_str(), modFileName.c_str());
@@ -573,7 +576,7 @@ void CPreGame::GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet
 	if (clientNet != nullptr && wantDemo) {
 		assert(clientNet->GetDemoRecorder() == nullptr);
 
-		CDemoRecorder* recorder = new CDemoRecorder(gameSetup->mapName, gameSetup->modName, false);
+		CDemoRecorder* recorder = new CDemoRecorder(gameSetup->mapName, gameSetup->modName, false, gameSetup->demoKeyFrameInterval != 0);
 		recorder->WriteSetupText(gameData->GetSetupText());
 		recorder->SaveToDemo(packet->data, packet->length, clientNet->GetPacketTime(gs->frameNum));
 		clientNet->SetDemoRecorder(recorder);
@@ -26,9 +26,11 @@
 #include "Sim/Units/UnitLoader.h"
 #include "Sim/Units/Unit.h"
 #include "System/EventHandler.h"
+#include "System/Exceptions.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Log/ILog.h"
 #include "System/SafeUtil.h"
+#include "System/SpringFormat.h"
 
 #include <string>
 #include <vector>
@@ -531,6 +533,16 @@ public:
 			game->StartSkip(targetFrame);
 			LOG("Skipping to frame %i", targetFrame);
 		}
+		else if (action.GetArgs().find("keyframe ") == 0) {
+			std::istringstream buf(action.GetArgs().substr(9));
+			int keyFrame;
+			buf >> keyFrame;
+
+			// the server has already skipped the demo stream past the frames
+			// before the keyframe, the replay can not continue without it
+			if (!game->LoadDemoKeyFrame(keyFrame))
+				throw content_error(spring::format("Could not load demo keyframe %i", keyFrame));
+		}
 		else if (action.GetArgs() == "end") {
 			game->EndSkip();
 			LOG("Skip finished");
@@ -16,6 +16,7 @@
 #include "Sim/Features/FeatureMemPool.h"
 #include "Sim/Misc/GlobalConstants.h" // for GAME_SPEED
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/LosHandler.h"
 #include "Sim/Path/IPathManager.h"
 #include "Sim/Units/UnitMemPool.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
@@ -434,10 +435,10 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 
 	// background
 	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.02f - 10.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // tl
-	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.17f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // bl
-	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.17f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
+	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.19f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // bl
+	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.19f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
 
-	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.17f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
+	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.19f + 20.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // br
 	buffer->SafeAppend({{MIN_X_COOR - 0.05f + 10.0f * globalRendering->pixelX, 0.02f - 10.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // tr
 	buffer->SafeAppend({{             0.01f - 10.0f * globalRendering->pixelX, 0.02f - 10.0f * globalRendering->pixelY, 0.0f}, {bgColor}}); // tl
 
@@ -449,10 +450,11 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 	const char* avgFmtStr = "[3] {Sim,Update,Draw}FrameTime={%s%2.1f, %s%2.1f, %s%2.1f (GL=%2.1f)}ms";
 	const char* spdFmtStr = "[4] {Current,Wanted}SimSpeedMul={%2.2f, %2.2f}x";
 	const char* sfxFmtStr = "[5] {Synced,Unsynced}Projectiles={%u,%u} Particles=%u Saturation=%.1f";
-	const char* pfsFmtStr = "[6] (%s)PFS-updates queued: {%i, %i}";
+	const char* pfsFmtStr = "[6] (%s)PFS-updates queued: {%i, %i} requests {queued,solved}: {%i, %i}";
 	const char* luaFmtStr = "[7] Lua-allocated memory: %.1fMB (%.1fK allocs : %.5u usecs : %.1u states)";
 	const char* gpuFmtStr = "[8] GPU-allocated memory: %.1fMB / %.1fMB";
 	const char* sopFmtStr = "[9] SOP-allocated memory: {U,F,P,W}={%.1f/%.1f, %.1f/%.1f, %.1f/%.1f, %.1f/%.1f}KB";
+	const char* losFmtStr = "[10] LOS raycast cache-{hits,misses}={%u, %u} (%.1f%%)";
 
 	const CProjectileHandler* ph = &projectileHandler;
 	const IPathManager* pm = pathManager;
@@ -473,16 +475,17 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 
 	{
 		const int2 pfsUpdates = pm->GetNumQueuedUpdates();
+		const int2 pfsRequests = pm->GetNumQueuedRequests();
 
 		switch (pm->GetPathFinderType()) {
 			case NOPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "NO", pfsUpdates.x, pfsUpdates.y);
+				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "NO", pfsUpdates.x, pfsUpdates.y, pfsRequests.x, pfsRequests.y);
 			} break;
 			case HAPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y);
+				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y, pfsRequests.x, pfsRequests.y);
 			} break;
 			case QTPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "QT", pfsUpdates.x, pfsUpdates.y);
+				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "QT", pfsUpdates.x, pfsUpdates.y, pfsRequests.x, pfsRequests.y);
 			} break;
 			default: {
 			} break;
@@ -519,6 +522,14 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 		weaponMemPool.alloc_size() / 1024.0f,
 		weaponMemPool.freed_size() / 1024.0f
 	);
+
+	{
+		const size_t losCacheHits = losHandler->GetRaycastCacheHits();
+		const size_t losCacheMisses = losHandler->GetRaycastCacheMisses();
+		const float losCacheRate = (100.0f * losCacheHits) / std::max(losCacheHits + losCacheMisses, size_t(1));
+
+		font->glFormat(0.01f, 0.20f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, losFmtStr, unsigned(losCacheHits), unsigned(losCacheMisses), losCacheRate);
+	}
 }
 
 
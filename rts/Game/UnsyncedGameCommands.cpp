@@ -44,7 +44,10 @@
 #include "Game/UI/Groups/GroupHandler.h"
 #include "Game/UI/PlayerRoster.h"
 
+#include "Lua/LuaCallInProfiler.h"
+#include "Lua/LuaGaia.h"
 #include "Lua/LuaOpenGL.h"
+#include "Lua/LuaRules.h"
 #include "Lua/LuaUI.h"
 
 #include "Map/Ground.h"
@@ -1435,6 +1438,63 @@ public:
 };
 
 
+class LuaCallInProfilerActionExecutor: public IUnsyncedActionExecutor {
+public:
+	LuaCallInProfilerActionExecutor() : IUnsyncedActionExecutor(
+		"LuaCallInProfiler",
+		"Record per-handle Lua call-in timings; arguments: on, off, clear, or dump [allocs] [<filename>]"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		const std::vector<std::string>& args = _local_strSpaceTokenize(action.GetArgs());
+
+		if (args.empty()) {
+			SetProfilerEnabled(!luaCallInProfiler.IsEnabled());
+			LOG("Lua call-in profiler %s", (luaCallInProfiler.IsEnabled())? "enabled": "disabled");
+			return true;
+		}
+
+		switch (hashString(args[0].c_str())) {
+			case hashString("on"): {
+				SetProfilerEnabled(true);
+			} break;
+			case hashString("off"): {
+				SetProfilerEnabled(false);
+			} break;
+			case hashString("clear"): {
+				luaCallInProfiler.Clear();
+			} break;
+			case hashString("dump"): {
+				// collapsed stacks, e.g. for flamegraph.pl
+				const bool dumpAllocs = (args.size() > 1 && args[1] == "allocs");
+				const size_t nameIdx = 1 + dumpAllocs;
+
+				luaCallInProfiler.Dump((args.size() > nameIdx)? args[nameIdx]: (dumpAllocs? "luacallins-allocs.txt": "luacallins.txt"), dumpAllocs);
+			} break;
+			default: {
+				LOG_L(L_WARNING, "/LuaCallInProfiler: unknown argument \"%s\" (use \"on\", \"off\", \"clear\", or \"dump\")", args[0].c_str());
+			} break;
+		}
+
+		return true;
+	}
+
+private:
+	static void SetProfilerEnabled(bool enabled) {
+		luaCallInProfiler.SetEnabled(enabled);
+
+		// the base handlers only wrap their call-ins in scopes while enabled
+		if (luaUI != nullptr)
+			luaUI->CallInProfilerChanged(enabled);
+		if (luaRules != nullptr)
+			luaRules->CallInProfilerChanged(enabled);
+		if (luaGaia != nullptr)
+			luaGaia->CallInProfilerChanged(enabled);
+	}
+};
+
+
 
 
 class GameInfoActionExecutor : public IUnsyncedActionExecutor {
@@ -3354,6 +3414,7 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<NoLuaDrawActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<LuaUIActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<LuaGarbageCollectControlExecutor>());
+	AddActionExecutor(AllocActionExecutor<LuaCallInProfilerActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<MiniMapActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<GroundDecalsActionExecutor>());
 
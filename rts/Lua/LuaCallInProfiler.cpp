@@ -0,0 +1,206 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaCallInProfiler.h"
+#include "LuaContextData.h"
+#include "LuaInclude.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+
+CLuaCallInProfiler luaCallInProfiler;
+
+// call-ins can nest (e.g. UnitDestroyed inside GameFrame, or XCall's
+// into other handles), the open frames form the current stack
+static thread_local std::vector<CLuaCallInProfiler::Frame> frameStack;
+
+
+void CLuaCallInProfiler::SetEnabled(bool b)
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+
+	if (b && samples.empty())
+		samples.resize(MAX_SAMPLES);
+
+	enabled.store(b);
+}
+
+void CLuaCallInProfiler::Clear()
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+
+	sampleIdx = 0;
+	numSamples = 0;
+}
+
+
+unsigned short CLuaCallInProfiler::GetNameIndex(const char* name)
+{
+	const auto iter = nameIndices.find(name);
+
+	if (iter != nameIndices.end())
+		return iter->second;
+
+	// names are never released; call-in and scope names form a small set
+	// and anything beyond MAX_NAMES shares the last index
+	if (names.size() >= (MAX_NAMES - 1)) {
+		if (names.size() == (MAX_NAMES - 1))
+			names.emplace_back("[overflow]");
+
+		return (MAX_NAMES - 1);
+	}
+
+	names.emplace_back(name);
+	nameIndices.emplace(name, names.size() - 1);
+	return (names.size() - 1);
+}
+
+
+void CLuaCallInProfiler::BeginFrame(lua_State* L, const char* name, bool luaScope)
+{
+	const SLuaAllocState* allocState = &GetLuaContextData(L)->allocState;
+
+	Frame frame;
+	frame.luaScope = luaScope;
+	frame.startNanos = spring_gettime().toNanoSecsi();
+	frame.childNanos = 0;
+	frame.allocState = allocState;
+	frame.startAllocs = allocState->numLuaAllocs.load();
+	frame.childAllocs = 0;
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+		frame.nameIdx = GetNameIndex(name);
+	}
+
+	frameStack.push_back(frame);
+}
+
+void CLuaCallInProfiler::EndFrame(lua_State* L)
+{
+	const Frame frame = frameStack.back();
+
+	const long long totalNanos = spring_gettime().toNanoSecsi() - frame.startNanos;
+	const unsigned long long totalAllocs = frame.allocState->numLuaAllocs.load() - frame.startAllocs;
+
+	Sample sample;
+	sample.depth = std::min(frameStack.size(), size_t(MAX_DEPTH));
+	sample.timeNanos = std::max(totalNanos - frame.childNanos, 0LL);
+	sample.numAllocs = (totalAllocs > frame.childAllocs)? (totalAllocs - frame.childAllocs): 0;
+
+	// deeper stacks are truncated to their outermost frames
+	for (unsigned int i = 0; i < sample.depth; i++) {
+		sample.stack[i] = frameStack[i].nameIdx;
+	}
+
+	frameStack.pop_back();
+
+	if (!frameStack.empty()) {
+		Frame& parent = frameStack.back();
+
+		parent.childNanos += totalNanos;
+		parent.childAllocs += (totalAllocs * (parent.allocState == frame.allocState));
+	}
+
+	std::lock_guard<spring::mutex> lock(mutex);
+
+	// buffer is allocated on the first SetEnabled(true), which might have
+	// happened while this frame's call-in was already running
+	if (samples.empty())
+		return;
+
+	samples[sampleIdx] = sample;
+	sampleIdx = (sampleIdx + 1) % MAX_SAMPLES;
+	numSamples = std::min(numSamples + 1, MAX_SAMPLES);
+}
+
+
+int CLuaCallInProfiler::ProfileCall(lua_State* L, const std::string& handleName, const char* callInName, int nInArgs, int nOutArgs, int errFuncIdx)
+{
+	char name[256];
+	snprintf(name, sizeof(name), "%s;%s", handleName.c_str(), callInName);
+
+	const size_t depth = frameStack.size();
+
+	BeginFrame(L, name, false);
+	const int error = lua_pcall(L, nInArgs, nOutArgs, errFuncIdx);
+
+	// close scopes left open by Lua, e.g. when an error skipped the Pop
+	while (frameStack.size() > (depth + 1))
+		EndFrame(L);
+
+	EndFrame(L);
+	return error;
+}
+
+
+void CLuaCallInProfiler::PushScope(lua_State* L, const char* name)
+{
+	if (frameStack.empty())
+		return;
+
+	BeginFrame(L, name, true);
+}
+
+void CLuaCallInProfiler::PopScope(lua_State* L)
+{
+	// never pop a call-in frame, unbalanced Pop's are ignored
+	if (frameStack.empty() || !frameStack.back().luaScope)
+		return;
+
+	EndFrame(L);
+}
+
+
+bool CLuaCallInProfiler::Dump(const std::string& fileName, bool dumpAllocs)
+{
+	spring::unordered_map<std::string, long long> stacks;
+
+	unsigned int dumpedSamples = 0;
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+
+		dumpedSamples = numSamples;
+
+		std::string stack;
+
+		for (unsigned int i = 0; i < numSamples; i++) {
+			const Sample& sample = samples[i];
+
+			stack.clear();
+
+			for (unsigned int j = 0; j < sample.depth; j++) {
+				stack.append((j == 0)? "": ";");
+				stack.append(names[sample.stack[j]]);
+			}
+
+			stacks[stack] += (dumpAllocs)? sample.numAllocs: sample.timeNanos;
+		}
+	}
+
+	const std::string filePath = dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE);
+	std::ofstream file(filePath.c_str(), std::ios::out | std::ios::trunc);
+
+	if (!file.is_open()) {
+		LOG_L(L_ERROR, "[LuaCallInProfiler::%s] could not open \"%s\" for writing", __func__, filePath.c_str());
+		return false;
+	}
+
+	for (const auto& pair: stacks) {
+		const long long value = (dumpAllocs)? pair.second: (pair.second / 1000);
+
+		if (value <= 0)
+			continue;
+
+		file << pair.first << " " << value << "\n";
+	}
+
+	LOG("[LuaCallInProfiler::%s] wrote %u samples (%u stacks, %s) to \"%s\"", __func__, dumpedSamples, unsigned(stacks.size()), (dumpAllocs)? "allocs": "usecs", filePath.c_str());
+	return true;
+}
@@ -0,0 +1,101 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_CALLIN_PROFILER_H
+#define LUA_CALLIN_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "System/UnorderedMap.hpp"
+#include "System/Threading/SpringThreading.h"
+
+struct lua_State;
+struct SLuaAllocState;
+
+/**
+ * Records the wall-time and number of Lua allocations of every call-in
+ * (per handle) into a ring-buffer while enabled. Lua code can open nested
+ * scopes (e.g. one per gadget or widget in the handler's call-in loops) to
+ * break a call-in down further. Samples hold self-cost only, such that the
+ * dump is directly usable as collapsed-stack input for flamegraph tools:
+ *
+ *   LuaRules;GameFrame;unit_script.lua 1234
+ */
+class CLuaCallInProfiler {
+public:
+	static constexpr unsigned int MAX_SAMPLES = 1 << 16;
+	static constexpr unsigned int MAX_DEPTH = 16;
+	// names past this are all recorded as "[overflow]", e.g. when scopes
+	// are pushed with per-unit or otherwise unbounded names
+	static constexpr unsigned int MAX_NAMES = 1 << 16;
+
+	struct Sample {
+		std::array<unsigned short, MAX_DEPTH> stack;
+
+		unsigned int depth;
+		unsigned int numAllocs;
+		long long timeNanos;
+	};
+
+	struct Frame {
+		unsigned short nameIdx;
+		bool luaScope;
+
+		long long startNanos;
+		long long childNanos;
+
+		// allocations are counted per handle, children in other handles
+		// (reached through XCall) are not subtracted from the parent's
+		const SLuaAllocState* allocState;
+
+		unsigned long long startAllocs;
+		unsigned long long childAllocs;
+	};
+
+public:
+	bool IsEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	void SetEnabled(bool b);
+	void Clear();
+
+	// wraps a call-in; only called when IsEnabled() returned true
+	int ProfileCall(lua_State* L, const std::string& handleName, const char* callInName, int nInArgs, int nOutArgs, int errFuncIdx);
+
+	// Spring.{Push,Pop}CallInProfilerScope; no-ops outside a profiled call-in
+	void PushScope(lua_State* L, const char* name);
+	void PopScope(lua_State* L);
+
+	// writes the buffered samples in collapsed-stack format, summing
+	// either microseconds or allocations per unique stack
+	bool Dump(const std::string& fileName, bool dumpAllocs);
+
+	unsigned int GetNumSamples() const {
+		std::lock_guard<spring::mutex> lock(mutex);
+		return numSamples;
+	}
+
+private:
+	void BeginFrame(lua_State* L, const char* name, bool luaScope);
+	void EndFrame(lua_State* L);
+
+	unsigned short GetNameIndex(const char* name);
+
+private:
+	std::atomic<bool> enabled = {false};
+
+	mutable spring::mutex mutex;
+
+	spring::unordered_map<std::string, unsigned short> nameIndices;
+	std::vector<std::string> names;
+
+	std::vector<Sample> samples;
+
+	unsigned int sampleIdx = 0;
+	unsigned int numSamples = 0;
+};
+
+extern CLuaCallInProfiler luaCallInProfiler;
+
+#endif /* LUA_CALLIN_PROFILER_H */
@@ -7,6 +7,7 @@
 #include "LuaUI.h"
 
 #include "LuaCallInCheck.h"
+#include "LuaCallInProfiler.h"
 #include "LuaConfig.h"
 #include "LuaHashString.h"
 #include "LuaOpenGL.h"
@@ -323,7 +324,12 @@ int CLuaHandle::RunCallInTraceback(
 			// note1: disable GC outside of this scope to prevent sync errors and similar
 			// note2: we collect garbage now in its own callin "CollectGarbage"
 			// lua_gc(L, LUA_GCRESTART, 0);
-			error = lua_pcall(state, nInArgs, nOutArgs, errFuncIdx);
+			// profiler disabled costs only this branch
+			if (!luaCallInProfiler.IsEnabled()) {
+				error = lua_pcall(state, nInArgs, nOutArgs, errFuncIdx);
+			} else {
+				error = luaCallInProfiler.ProfileCall(state, handle->GetName(), luaFunc, nInArgs, nOutArgs, errFuncIdx);
+			}
 			// only run GC inside of "SetHandleRunning(L, true) ... SetHandleRunning(L, false)"!
 			lua_gc(state, LUA_GCSTOP, 0);
 
@@ -485,6 +491,22 @@ void CLuaHandle::Shutdown()
 }
 
 
+void CLuaHandle::CallInProfilerChanged(bool enabled)
+{
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 3, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	lua_pushboolean(L, enabled);
+
+	// call the routine
+	RunCallIn(L, cmdStr, 1, 0);
+}
+
+
 bool CLuaHandle::GotChatMsg(const string& msg, int playerID)
 {
 	LUA_CALL_IN_CHECK(L, true);
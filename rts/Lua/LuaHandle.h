@@ -271,6 +271,8 @@ class CLuaHandle : public CEventClient
 		void Shutdown();
 		bool GotChatMsg(const std::string& msg, int playerID);
 		bool RecvLuaMsg(const std::string& msg, int playerID);
+		// lets handlers swap in per-gadget/widget profiler scopes
+		void CallInProfilerChanged(bool enabled);
 
 	public: // custom call-in  (inter-script calls)
 		bool HasXCall(const std::string& funcName) const { return HasCallIn(L, funcName); }
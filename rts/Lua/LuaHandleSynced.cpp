@@ -53,6 +53,13 @@
 
 
 LuaRulesParams::Params  CSplitLuaHandle::gameParams;
+LuaRulesParams::ParamSlots  CSplitLuaHandle::unitParamSlots;
+
+
+void CSplitLuaHandle::SerializeUnitParamSlots(creg::ISerializer* s)
+{
+	creg::DeduceType<LuaRulesParams::ParamSlots>::Get()->Serialize(s, &unitParamSlots);
+}
 
 
 
@@ -182,6 +182,11 @@ class CSplitLuaHandle
 			return syncedLuaHandle.RecvLuaMsg(msg, playerID);
 		}
 
+		void CallInProfilerChanged(bool enabled) {
+			syncedLuaHandle.CallInProfilerChanged(enabled);
+			unsyncedLuaHandle.CallInProfilerChanged(enabled);
+		}
+
 	public:
 		void CheckStack() {
 			syncedLuaHandle.CheckStack();
@@ -263,12 +268,18 @@ class CSplitLuaHandle
 		CUnsyncedLuaHandle unsyncedLuaHandle;
 
 	public:
-		static void ClearGameParams() { spring::clear_unordered_map(gameParams); }
+		static void ClearGameParams() { spring::clear_unordered_map(gameParams); unitParamSlots.clear(); }
 		static const LuaRulesParams::Params& GetGameParams() { return gameParams; }
+		static const LuaRulesParams::ParamSlots& GetUnitParamSlots() { return unitParamSlots; }
+
+		// per-unit slot values are saved along with the units, the names
+		// they belong to have to be restored with them
+		static void SerializeUnitParamSlots(creg::ISerializer* s);
 
 	private:
 		//FIXME: add to CREG?
 		static LuaRulesParams::Params  gameParams;
+		static LuaRulesParams::ParamSlots  unitParamSlots;
 		friend class LuaSyncedCtrl;
 };
 
@@ -107,6 +107,10 @@ void LuaMemPool::KillStatic()
 LuaMemPool::LuaMemPool(bool isEnabled): LuaMemPool(size_t(-1)) { assert(isEnabled == LuaMemPool::enabled); }
 LuaMemPool::LuaMemPool(size_t lmpIndex): globalIndex(lmpIndex)
 {
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	slabImpl.Init();
+	#endif
+
 	if (!LuaMemPool::enabled)
 		return;
 
@@ -148,11 +152,42 @@ void LuaMemPool::LogStats(const char* handle, const char* lctype) const
 			allocStats[STAT_NBB]
 		);
 	#endif
+
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	{
+		char classAllocs[SlabImpl::NUM_CLASSES * 24] = {0};
+		size_t pos = 0;
+
+		for (uint32_t i = 0; i < SlabImpl::NUM_CLASSES; i++) {
+			pos += snprintf(&classAllocs[pos], sizeof(classAllocs) - pos, "%s" _STPF_, (i == 0)? "": ",", slabImpl.numAllocs[i]);
+		}
+
+		LOG(
+			"[LuaMemPool::%s][handle=%s (%s)] {slabs,slabBytes}={" _STPF_ "," _STPF_ "} {live,rec}SlabAllocs={" _STPF_ "," _STPF_ "} classAllocs[%u..%u]={%s}",
+			__func__,
+			handle,
+			lctype,
+			slabImpl.slabs.size(),
+			slabImpl.slabs.size() * SlabImpl::SLAB_SIZE,
+			slabImpl.numAllocs[SlabImpl::NUM_CLASSES],
+			slabImpl.numRecycled,
+			SlabImpl::CLASS_SIZE,
+			SlabImpl::MAX_ALLOC_SIZE,
+			classAllocs
+		);
+	}
+	#endif
 }
 
 
 void LuaMemPool::DeleteBlocks()
 {
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	// only called when no allocations are live; slabs are not reused
+	// across handles since a pool's next owner might be much smaller
+	slabImpl.Kill();
+	#endif
+
 	#if (LMP_USE_CHUNK_TABLE == 1)
 	#if 1
 	for (void* p: allocBlocks) {
@@ -174,6 +209,11 @@ void* LuaMemPool::Alloc(size_t size)
 	allocStats[STAT_NIA] += 1;
 	allocStats[STAT_NCB] += (size = std::max(size, size_t(MIN_ALLOC_SIZE)));
 
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	if (size <= SlabImpl::MAX_ALLOC_SIZE)
+		return (slabImpl.Alloc(size));
+	#endif
+
 	#if (LMP_USE_CHUNK_TABLE == 1)
 	auto freeChunksTablePair = std::make_pair(freeChunksTable.find(size), false);
 
@@ -224,6 +264,20 @@ void* LuaMemPool::Alloc(size_t size)
 
 void* LuaMemPool::Realloc(void* ptr, size_t nsize, size_t osize)
 {
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	// growing or shrinking within the same size-class needs no copy
+	if (ptr != nullptr && !AllocExternal(nsize) && !AllocExternal(osize)) {
+		const size_t nsz = std::max(nsize, size_t(MIN_ALLOC_SIZE));
+		const size_t osz = std::max(osize, size_t(MIN_ALLOC_SIZE));
+
+		if (nsz <= SlabImpl::MAX_ALLOC_SIZE && osz <= SlabImpl::MAX_ALLOC_SIZE && SlabImpl::CalcClassIndex(nsz) == SlabImpl::CalcClassIndex(osz)) {
+			allocStats[STAT_NCB] += nsz;
+			allocStats[STAT_NCB] -= osz;
+			return ptr;
+		}
+	}
+	#endif
+
 	void* ret = Alloc(nsize);
 
 	if (ptr == nullptr)
@@ -248,6 +302,13 @@ void LuaMemPool::Free(void* ptr, size_t size)
 
 	allocStats[STAT_NCB] -= (size = std::max(size, size_t(MIN_ALLOC_SIZE)));
 
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	if (size <= SlabImpl::MAX_ALLOC_SIZE) {
+		slabImpl.Free(ptr, size);
+		return;
+	}
+	#endif
+
 	#if (LMP_USE_CHUNK_TABLE == 1)
 	*(void**) ptr = freeChunksTable[size];
 	freeChunksTable[size] = ptr;
@@ -259,6 +320,73 @@ void LuaMemPool::Free(void* ptr, size_t size)
 
 
 
+#if (LMP_USE_SLAB_CLASSES == 1)
+void LuaMemPool::SlabImpl::Init() {
+	for (SizeClass& sc: sizeClasses) {
+		sc.freeList = nullptr;
+		sc.slabCur = nullptr;
+		sc.slabEnd = nullptr;
+	}
+
+	numAllocs.fill(0);
+}
+
+void LuaMemPool::SlabImpl::Kill() {
+	for (void* slab: slabs) {
+		::operator delete(slab);
+	}
+
+	slabs.clear();
+	Init();
+}
+
+
+void* LuaMemPool::SlabImpl::Alloc(uint32_t size) {
+	const uint32_t classIndex = CalcClassIndex(size);
+	const uint32_t chunkSize = (classIndex + 1) * CLASS_SIZE;
+
+	SizeClass& sc = sizeClasses[classIndex];
+
+	numAllocs[classIndex ] += 1;
+	numAllocs[NUM_CLASSES] += 1;
+
+	if (sc.freeList != nullptr) {
+		void* ptr = sc.freeList;
+
+		sc.freeList = *(void**) ptr;
+		numRecycled += 1;
+		return ptr;
+	}
+
+	if ((sc.slabCur + chunkSize) > sc.slabEnd) {
+		// tail of the previous slab (less than one chunk) is wasted
+		slabs.push_back(::operator new(SLAB_SIZE));
+
+		sc.slabCur = reinterpret_cast<uint8_t*>(slabs.back());
+		sc.slabEnd = sc.slabCur + SLAB_SIZE;
+	}
+
+	void* ptr = sc.slabCur;
+
+	sc.slabCur += chunkSize;
+	return ptr;
+}
+
+void LuaMemPool::SlabImpl::Free(void* ptr, uint32_t size) {
+	const uint32_t classIndex = CalcClassIndex(size);
+
+	SizeClass& sc = sizeClasses[classIndex];
+
+	numAllocs[classIndex ] -= 1;
+	numAllocs[NUM_CLASSES] -= 1;
+
+	*(void**) ptr = sc.freeList;
+	sc.freeList = ptr;
+}
+#endif
+
+
+
 void LuaMemPool::PoolImpl::Init() {
 	poolPtrs.fill(nullptr);
 	numAllocs.fill(0);
@@ -11,6 +11,7 @@
 #include "System/UnorderedMap.hpp"
 
 #define LMP_USE_CHUNK_TABLE 0
+#define LMP_USE_SLAB_CLASSES 1
 
 class CLuaHandle;
 class LuaMemPool {
@@ -79,6 +80,10 @@ public:
 		poolImpl.numAllocs.fill(0);
 		poolImpl.allocSums.fill(0);
 		#endif
+
+		#if (LMP_USE_SLAB_CLASSES == 1)
+		slabImpl.numRecycled *= (1 - b);
+		#endif
 	}
 
 	void ClearTables() {
@@ -168,6 +173,56 @@ private:
 	#endif
 
 
+	#if (LMP_USE_SLAB_CLASSES == 1)
+	// Lua objects (strings, tables, closures, upvalues) are mostly small;
+	// they are served from 16-byte size-classes carved out of large slabs
+	// rather than rounded up to the next power-of-two pool. Pools are not
+	// shared between threads (see AcquirePtr), so each handle's instance
+	// doubles as its thread-local cache and needs no locking.
+	//
+	// Like the power-of-two pools, this never returns memory while the
+	// pool is in use: a freed chunk goes onto its class's free-list and
+	// can only be reused by that class, slabs are released all at once
+	// by DeleteBlocks when the owning handle is killed or reloaded. The
+	// footprint is therefore the per-class peak of live chunks (at most
+	// one partially used slab per class extra), never more.
+	struct SlabImpl {
+	public:
+		static constexpr uint32_t MAX_ALLOC_SIZE = 256;
+		static constexpr uint32_t CLASS_SIZE = 16;
+		static constexpr uint32_t NUM_CLASSES = MAX_ALLOC_SIZE / CLASS_SIZE;
+		static constexpr uint32_t SLAB_SIZE = 64 * 1024;
+
+		struct SizeClass {
+			void* freeList;
+
+			// unused tail of the most recent slab
+			uint8_t* slabCur;
+			uint8_t* slabEnd;
+		};
+
+		std::array<SizeClass, NUM_CLASSES> sizeClasses;
+		// live chunks per class and in total
+		std::array<size_t, NUM_CLASSES + 1> numAllocs;
+
+		std::vector<void*> slabs;
+
+		size_t numRecycled = 0;
+
+	public:
+		static uint32_t CalcClassIndex(uint32_t size) { return ((size - 1) / CLASS_SIZE); }
+
+		void Init();
+		void Kill();
+
+		void* Alloc(uint32_t size);
+		void Free(void* ptr, uint32_t size);
+	};
+
+	SlabImpl slabImpl;
+	#endif
+
+
 	enum {
 		STAT_NIA = 0, // number of internal allocs
 		STAT_NEA = 1, // number of external allocs
@@ -25,6 +25,7 @@
 #include "System/ContainerUtil.h"
 #include "System/TimeProfiler.h"
 #include "System/ScopedFPUSettings.h"
+#include "System/Platform/Threading.h"
 #include "System/StringUtil.h"
 
 LuaParser* GetLuaParser(lua_State* L) {
@@ -522,6 +523,9 @@ int LuaParser::Random(lua_State* L)
 {
 	// both US and DS depend on LuaParser via MapParser, etc
 	#if (!defined(UNITSYNC) && !defined(DEDICATED))
+	// gsRNG is not thread-safe; parsers created on other threads (e.g. by the
+	// archive scanner) have to be unsynced and get DummyRandom instead
+	assert(Threading::IsMainThread() || Threading::IsGameLoadThread());
 	lua_pushnumber(L, gsRNG.NextFloat());
 	return 1;
 	#else
@@ -10,3 +10,9 @@ CR_REG_METADATA(Param, (
 	CR_MEMBER(valueInt),
 	CR_MEMBER(valueString)
 ))
+
+CR_BIND(ParamSlot,)
+CR_REG_METADATA(ParamSlot, (
+	CR_MEMBER(name),
+	CR_MEMBER(los)
+))
@@ -4,6 +4,7 @@
 #define LUA_RULESPARAMS_H
 
 #include <string>
+#include <vector>
 
 #include "System/UnorderedMap.hpp"
 #include "System/creg/creg_cond.h"
@@ -36,6 +37,21 @@ namespace LuaRulesParams
 	};
 
 	typedef spring::unordered_map<std::string, Param> Params;
+
+	// numeric-only params registered once under an integer slot; their
+	// values are stored per object in a plain float array (SlotValues)
+	// indexed by slot, which avoids the string lookups of Params
+	struct ParamSlot {
+		CR_DECLARE_STRUCT(ParamSlot)
+
+		std::string name;
+		int los = RULESPARAMLOS_PRIVATE;
+	};
+
+	typedef std::vector<ParamSlot> ParamSlots;
+	typedef std::vector<float> SlotValues;
+
+	static constexpr unsigned int MAX_PARAM_SLOTS = 256;
 }
 
 #endif // LUA_RULESPARAMS_H
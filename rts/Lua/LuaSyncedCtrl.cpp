@@ -1,5 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <cctype>
 
@@ -154,6 +156,8 @@ bool LuaSyncedCtrl::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(SetTeamRulesParam);
 	REGISTER_LUA_CFUNC(SetUnitRulesParam);
 	REGISTER_LUA_CFUNC(SetFeatureRulesParam);
+	REGISTER_LUA_CFUNC(AddUnitRulesParamSlot);
+	REGISTER_LUA_CFUNC(SetUnitRulesParamSlot);
 
 	REGISTER_LUA_CFUNC(CreateUnit);
 	REGISTER_LUA_CFUNC(DestroyUnit);
@@ -483,7 +487,11 @@ static int SetSolidObjectCollisionVolumeData(lua_State* L, CSolidObject* o)
 	if (o == nullptr)
 		return 0;
 
-	return LuaUtils::ParseColVolData(L, 2, &o->collisionVolume);
+	const int ret = LuaUtils::ParseColVolData(L, 2, &o->collisionVolume);
+
+	// affects the radius- and offset-checks of GetUnitsAndFeaturesColVol
+	quadField.ChangedColVol();
+	return ret;
 }
 
 static int SetSolidObjectBlocking(lua_State* L, CSolidObject* o)
@@ -1017,6 +1025,36 @@ int LuaSyncedCtrl::ShareTeamResource(lua_State* L)
 
 /******************************************************************************/
 
+static int ParseRulesParamLos(lua_State* L, int losIndex, int defLos)
+{
+	if (!lua_istable(L, losIndex))
+		return (luaL_optint(L, losIndex, defLos));
+
+	int losMask = LuaRulesParams::RULESPARAMLOS_PRIVATE;
+
+	for (lua_pushnil(L); lua_next(L, losIndex) != 0; lua_pop(L, 1)) {
+		// ignore if the value is false
+		if (!luaL_optboolean(L, -1, true))
+			continue;
+
+		// read the losType from the key
+		if (!lua_isstring(L, -2))
+			continue;
+
+		switch (hashString(lua_tostring(L, -2))) {
+			case hashString("public" ): { losMask |= LuaRulesParams::RULESPARAMLOS_PUBLIC;  } break;
+			case hashString("inlos"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_INLOS;   } break;
+			case hashString("typed"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_TYPED;   } break;
+			case hashString("inradar"): { losMask |= LuaRulesParams::RULESPARAMLOS_INRADAR; } break;
+			case hashString("allied" ): { losMask |= LuaRulesParams::RULESPARAMLOS_ALLIED;  } break;
+			// case hashString("private"): { losMask |= LuaRulesParams::RULESPARAMLOS_PRIVATE; } break;
+			default                   : {                                                   } break;
+		}
+	}
+
+	return losMask;
+}
+
 void SetRulesParam(lua_State* L, const char* caller, int offset,
 				LuaRulesParams::Params& params)
 {
@@ -1042,33 +1080,7 @@ void SetRulesParam(lua_State* L, const char* caller, int offset,
 	}
 
 	// set the los checking of the parameter
-	if (lua_istable(L, losIndex)) {
-		int losMask = LuaRulesParams::RULESPARAMLOS_PRIVATE;
-
-		for (lua_pushnil(L); lua_next(L, losIndex) != 0; lua_pop(L, 1)) {
-			// ignore if the value is false
-			if (!luaL_optboolean(L, -1, true))
-				continue;
-
-			// read the losType from the key
-			if (!lua_isstring(L, -2))
-				continue;
-
-			switch (hashString(lua_tostring(L, -2))) {
-				case hashString("public" ): { losMask |= LuaRulesParams::RULESPARAMLOS_PUBLIC;  } break;
-				case hashString("inlos"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_INLOS;   } break;
-				case hashString("typed"  ): { losMask |= LuaRulesParams::RULESPARAMLOS_TYPED;   } break;
-				case hashString("inradar"): { losMask |= LuaRulesParams::RULESPARAMLOS_INRADAR; } break;
-				case hashString("allied" ): { losMask |= LuaRulesParams::RULESPARAMLOS_ALLIED;  } break;
-				// case hashString("private"): { losMask |= LuaRulesParams::RULESPARAMLOS_PRIVATE; } break;
-				default                   : {                                                   } break;
-			}
-		}
-
-		param.los = losMask;
-	} else {
-		param.los = luaL_optint(L, losIndex, param.los);
-	}
+	param.los = ParseRulesParamLos(L, losIndex, param.los);
 }
 
 
@@ -1112,6 +1124,74 @@ int LuaSyncedCtrl::SetFeatureRulesParam(lua_State* L)
 	return 0;
 }
 
+
+/*
+ * Spring.AddUnitRulesParamSlot(name[, losAccess]) -> slot
+ *
+ * Registers a numeric unit rules-param under an integer slot which can be
+ * written with SetUnitRulesParamSlot and read in bulk with GetUnitRulesParamSlots.
+ * Adding an existing name returns its slot and updates its losAccess.
+ * Slot values are independent of Set/GetUnitRulesParam.
+ */
+int LuaSyncedCtrl::AddUnitRulesParamSlot(lua_State* L)
+{
+	LuaRulesParams::ParamSlots& slots = CSplitLuaHandle::unitParamSlots;
+
+	const char* name = luaL_checkstring(L, 1);
+	const auto iter = std::find_if(slots.begin(), slots.end(), [&](const LuaRulesParams::ParamSlot& s) { return (s.name == name); });
+
+	if (iter == slots.end()) {
+		if (slots.size() == LuaRulesParams::MAX_PARAM_SLOTS)
+			luaL_error(L, "[%s] too many slots (max %u)", __func__, LuaRulesParams::MAX_PARAM_SLOTS);
+
+		slots.emplace_back();
+		slots.back().name = name;
+		slots.back().los = ParseRulesParamLos(L, 2, LuaRulesParams::RULESPARAMLOS_PRIVATE);
+
+		lua_pushnumber(L, slots.size());
+		return 1;
+	}
+
+	iter->los = ParseRulesParamLos(L, 2, iter->los);
+
+	lua_pushnumber(L, (iter - slots.begin()) + 1);
+	return 1;
+}
+
+
+/*
+ * Spring.SetUnitRulesParamSlot(unitID, slot, value)
+ *
+ * A nil value unsets the slot (it will be read as nil).
+ */
+int LuaSyncedCtrl::SetUnitRulesParamSlot(lua_State* L)
+{
+	CUnit* unit = ParseUnit(L, __func__, 1);
+
+	if (unit == nullptr)
+		return 0;
+
+	const unsigned int slot = luaL_checkint(L, 2) - 1;
+
+	if (slot >= CSplitLuaHandle::unitParamSlots.size())
+		luaL_error(L, "[%s] invalid slot %d", __func__, slot + 1);
+
+	LuaRulesParams::SlotValues& values = unit->modParamSlots;
+
+	if (lua_isnoneornil(L, 3)) {
+		if (slot < values.size())
+			values[slot] = std::numeric_limits<float>::quiet_NaN();
+
+		return 0;
+	}
+
+	if (slot >= values.size())
+		values.resize(slot + 1, std::numeric_limits<float>::quiet_NaN());
+
+	values[slot] = luaL_checkfloat(L, 3);
+	return 0;
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -42,6 +42,8 @@ class LuaSyncedCtrl
 		static int SetTeamRulesParam(lua_State* L);
 		static int SetUnitRulesParam(lua_State* L);
 		static int SetFeatureRulesParam(lua_State* L);
+		static int AddUnitRulesParamSlot(lua_State* L);
+		static int SetUnitRulesParamSlot(lua_State* L);
 
 		static int GiveOrderToUnit(lua_State* L);
 		static int GiveOrderToUnitMap(lua_State* L);
@@ -73,8 +73,13 @@
 #include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/StringUtil.h"
+#include "System/StringHash.h"
+#include "System/UnorderedMap.hpp"
 
+#include <array>
 #include <cctype>
+#include <cstring>
+#include <deque>
 
 
 using std::min;
@@ -214,6 +219,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitDirection);
 	REGISTER_LUA_CFUNC(GetUnitHeading);
 	REGISTER_LUA_CFUNC(GetUnitVelocity);
+	REGISTER_LUA_CFUNC(GetUnitArrayState);
 	REGISTER_LUA_CFUNC(GetUnitBuildFacing);
 	REGISTER_LUA_CFUNC(GetUnitIsBuilding);
 	REGISTER_LUA_CFUNC(GetUnitCurrentBuildPower);
@@ -261,6 +267,8 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 
 	REGISTER_LUA_CFUNC(GetUnitRulesParam);
 	REGISTER_LUA_CFUNC(GetUnitRulesParams);
+	REGISTER_LUA_CFUNC(GetUnitRulesParamSlot);
+	REGISTER_LUA_CFUNC(GetUnitRulesParamSlots);
 
 	REGISTER_LUA_CFUNC(GetCEGID);
 
@@ -2118,6 +2126,154 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
 //  Spatial Unit Queries
 //
 
+// spatial queries can write into a caller-supplied table instead
+// of a new one; returns true if a new table has to be created
+static bool PushOutputTable(lua_State* L, int index)
+{
+	if (!lua_istable(L, index))
+		return true;
+
+	lua_pushvalue(L, index);
+	return false;
+}
+
+// removes the entries past <count> left over in a reused table
+static void ClearTableTail(lua_State* L, unsigned int count)
+{
+	for (unsigned int i = count + 1; ; i++) {
+		lua_rawgeti(L, -1, i);
+
+		const bool isNil = lua_isnil(L, -1);
+
+		lua_pop(L, 1);
+
+		if (isNil)
+			break;
+
+		lua_pushnil(L);
+		lua_rawseti(L, -2, i);
+	}
+}
+
+// as ClearTableTail, for flat tables (e.g. GetUnitArrayState's) which can
+// hold nil values anywhere, such that their tail is not a contiguous run
+static void ClearSparseTableTail(lua_State* L, int tableIdx, unsigned int count)
+{
+	lua_pushnil(L);
+
+	while (lua_next(L, tableIdx) != 0) {
+		lua_pop(L, 1);
+
+		if (lua_type(L, -1) != LUA_TNUMBER || lua_tonumber(L, -1) <= count)
+			continue;
+
+		// clearing existing fields during traversal is allowed
+		lua_pushvalue(L, -1);
+		lua_pushnil(L);
+		lua_rawset(L, tableIdx);
+	}
+}
+
+
+// Identical GetUnitsIn{Rectangle,Cylinder,Sphere} queries issued within
+// the same sim-frame while no unit has been added, removed or moved share
+// the units that pass the shape test. Allegiance and visibility are still
+// tested on every call, so the cached part does not depend on the caller's
+// access level. Synced and unsynced handles use separate caches such that
+// unsynced (e.g. widget) queries can never influence synced results.
+class SpatialQueryCache {
+public:
+	enum {
+		QUERY_RECTANGLE = 0,
+		QUERY_CYLINDER  = 1,
+		QUERY_SPHERE    = 2,
+	};
+
+	struct Query {
+		bool operator == (const Query& q) const { return (std::memcmp(this, &q, sizeof(Query)) == 0); }
+
+		int type;
+		float params[4];
+	};
+
+	struct QueryHash {
+		size_t operator () (const Query& q) const { return (HashString(reinterpret_cast<const char*>(&q), sizeof(Query))); }
+	};
+
+	template<typename CollectFunc>
+	const std::vector<const CUnit*>& GetUnits(const Query& query, CollectFunc&& collectUnits) {
+		if (frameNum != gs->frameNum || unitsModCount != quadField.GetUnitsModCount()) {
+			queries.clear();
+
+			frameNum = gs->frameNum;
+			unitsModCount = quadField.GetUnitsModCount();
+			numResults = 0;
+		}
+
+		const auto iter = queries.find(query);
+
+		if (iter != queries.end()) {
+			hits += 1;
+			return results[iter->second];
+		}
+
+		misses += 1;
+
+		// only bounds memory; a deque keeps references to earlier results valid
+		if (numResults == MAX_QUERIES) {
+			overflow.clear();
+			collectUnits(overflow);
+			return overflow;
+		}
+
+		if (numResults == results.size())
+			results.emplace_back();
+
+		std::vector<const CUnit*>& units = results[numResults];
+
+		units.clear();
+		collectUnits(units);
+
+		queries[query] = numResults++;
+		return units;
+	}
+
+public:
+	static constexpr unsigned int MAX_QUERIES = 1024;
+
+	// not synced, shared by both caches
+	static unsigned int hits;
+	static unsigned int misses;
+
+private:
+	spring::unordered_map<Query, unsigned int, QueryHash> queries;
+
+	std::deque< std::vector<const CUnit*> > results;
+	std::vector<const CUnit*> overflow;
+
+	int frameNum = -1;
+
+	unsigned int unitsModCount = 0;
+	unsigned int numResults = 0;
+};
+
+unsigned int SpatialQueryCache::hits = 0;
+unsigned int SpatialQueryCache::misses = 0;
+
+static SpatialQueryCache spatialQueryCaches[2];
+
+static SpatialQueryCache& GetSpatialQueryCache(lua_State* L)
+{
+	return spatialQueryCaches[CLuaHandle::GetHandleSynced(L)];
+}
+
+void LuaSyncedRead::GetSpatialQueryCacheStats(unsigned int& hits, unsigned int& misses)
+{
+	hits = SpatialQueryCache::hits;
+	misses = SpatialQueryCache::misses;
+}
+
+
 // Macro Requirements:
 //   L, units
 
@@ -2135,6 +2291,9 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
 			lua_pushnumber(L, unit->id);                            \
 			lua_rawseti(L, -2, ++count);                            \
 		}                                                           \
+                                                                    \
+		if (!(NEWTABLE))                                            \
+			ClearTableTail(L, count);                               \
 	}
 
 // Macro Requirements:
@@ -2197,32 +2356,34 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 	const float3 maxs(xmax, 0.0f, zmax);
 
 	const int allegiance = ParseAllegiance(L, __func__, 5);
+	const bool newTable = PushOutputTable(L, 6);
 
-#define RECTANGLE_TEST ; // no test, GetUnitsExact is sufficient
-
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	const SpatialQueryCache::Query query = {SpatialQueryCache::QUERY_RECTANGLE, {xmin, zmin, xmax, zmax}};
+	const auto& units = GetSpatialQueryCache(L).GetUnits(query, [&](std::vector<const CUnit*>& queryUnits) {
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+		queryUnits.assign(qfQuery.units->begin(), qfQuery.units->end());
+	});
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, RECTANGLE_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, NULL_TEST, newTable);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, RECTANGLE_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, NULL_TEST, newTable);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, NULL_TEST, newTable);
 	}
 
 	return 1;
@@ -2289,6 +2450,7 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 	const float3 maxs(x + radius, 0.0f, z + radius);
 
 	const int allegiance = ParseAllegiance(L, __func__, 4);
+	const bool newTable = PushOutputTable(L, 5);
 
 #define CYLINDER_TEST                         \
 	const float3& p = unit->midPos;             \
@@ -2299,29 +2461,36 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 		continue;                               \
 	}                                           \
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	const SpatialQueryCache::Query query = {SpatialQueryCache::QUERY_CYLINDER, {x, z, radius, 0.0f}};
+	const auto& units = GetSpatialQueryCache(L).GetUnits(query, [&](std::vector<const CUnit*>& queryUnits) {
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+
+		for (const CUnit* unit: *qfQuery.units) {
+			CYLINDER_TEST;
+			queryUnits.push_back(unit);
+		}
+	});
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, CYLINDER_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, NULL_TEST, newTable);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, CYLINDER_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, NULL_TEST, newTable);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, NULL_TEST, newTable);
 	}
 
 	return 1;
@@ -2341,6 +2510,7 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 	const float3 maxs(x + radius, 0.0f, z + radius);
 
 	const int allegiance = ParseAllegiance(L, __func__, 5);
+	const bool newTable = PushOutputTable(L, 6);
 
 #define SPHERE_TEST                           \
 	const float3& p = unit->midPos;             \
@@ -2353,29 +2523,36 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 		continue;                                 \
 	}                                           \
 
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, mins, maxs);
-	const auto& units = (*qfQuery.units);
+	const SpatialQueryCache::Query query = {SpatialQueryCache::QUERY_SPHERE, {x, y, z, radius}};
+	const auto& units = GetSpatialQueryCache(L).GetUnits(query, [&](std::vector<const CUnit*>& queryUnits) {
+		QuadFieldQuery qfQuery;
+		quadField.GetUnitsExact(qfQuery, mins, maxs);
+
+		for (const CUnit* unit: *qfQuery.units) {
+			SPHERE_TEST;
+			queryUnits.push_back(unit);
+		}
+	});
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, SPHERE_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, NULL_TEST, newTable);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, SPHERE_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, NULL_TEST, newTable);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, NULL_TEST, newTable);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, NULL_TEST, newTable);
 	}
 
 	return 1;
@@ -3155,6 +3332,212 @@ int LuaSyncedRead::GetUnitVelocity(lua_State* L)
 }
 
 
+/*
+ * Spring.GetUnitArrayState(unitIDs, fields[, output]) -> output, stride
+ *
+ * Batched form of GetUnitPosition, GetUnitVelocity, etc. The values of each
+ * requested field for every unit in <unitIDs> are stored consecutively into
+ * one flat table, unit i (1-based) starting at index (i - 1) * stride + 1.
+ * Passing the previous result as <output> avoids allocating a new table each
+ * frame; values past the new result are removed from it. Each field is subject
+ * to the same access checks as its single-unit counterpart; values that may
+ * not be read (or of invalid units) are nil.
+ */
+int LuaSyncedRead::GetUnitArrayState(lua_State* L)
+{
+	enum {
+		FIELD_POSITION     = 0, // GetUnitPosition
+		FIELD_MID_POSITION = 1, // GetUnitPosition(id, true)
+		FIELD_AIM_POSITION = 2, // GetUnitPosition(id, false, true)
+		FIELD_VELOCITY     = 3, // GetUnitVelocity
+		FIELD_DIRECTION    = 4, // GetUnitDirection
+		FIELD_HEADING      = 5, // GetUnitHeading
+		FIELD_HEALTH       = 6, // GetUnitHealth
+		FIELD_TEAM         = 7, // GetUnitTeam
+		FIELD_COUNT        = 8,
+	};
+
+	constexpr const char* fieldNames[FIELD_COUNT] = {"position", "midPosition", "aimPosition", "velocity", "direction", "heading", "health", "team"};
+	constexpr int fieldWidths[FIELD_COUNT] = {3, 3, 3, 4, 3, 1, 5, 1};
+
+	if (!lua_istable(L, 1) || !lua_istable(L, 2))
+		luaL_error(L, "Incorrect arguments to GetUnitArrayState(unitIDs, fields[, output])");
+
+	// parse the fields
+	std::array<int, FIELD_COUNT> fields;
+
+	int numFields = 0;
+	int stride = 0;
+
+	for (int i = 1, n = lua_objlen(L, 2); i <= n; i++) {
+		lua_rawgeti(L, 2, i);
+
+		const char* name = lua_tostring(L, -1);
+		const auto iter = std::find_if(fieldNames, fieldNames + FIELD_COUNT, [&](const char* f) { return (name != nullptr && strcmp(name, f) == 0); });
+
+		if (iter == (fieldNames + FIELD_COUNT))
+			luaL_error(L, "[%s] unknown field \"%s\" (#%d)", __func__, (name != nullptr)? name: "", i);
+		if (numFields == FIELD_COUNT)
+			luaL_error(L, "[%s] too many fields", __func__);
+
+		stride += fieldWidths[ fields[numFields++] = iter - fieldNames ];
+		lua_pop(L, 1);
+	}
+
+	const int numUnits = lua_objlen(L, 1);
+
+	if (lua_istable(L, 3)) {
+		lua_pushvalue(L, 3);
+	} else {
+		lua_createtable(L, numUnits * stride, 0);
+	}
+
+	const int tableIdx = lua_gettop(L);
+	int valueIdx = 1;
+
+	// bits in <nilMask> mark values that are not readable
+	const auto SetValues = [&](const float* values, int count, unsigned int nilMask) {
+		for (int k = 0; k < count; k++) {
+			if ((nilMask & (1 << k)) != 0) {
+				lua_pushnil(L);
+			} else {
+				lua_pushnumber(L, values[k]);
+			}
+
+			lua_rawseti(L, tableIdx, valueIdx++);
+		}
+	};
+
+	for (int i = 1; i <= numUnits; i++) {
+		lua_rawgeti(L, 1, i);
+
+		if (!lua_isnumber(L, -1))
+			luaL_error(L, "[%s] unitID (entry #%d) not a number", __func__, i);
+
+		const CUnit* unit = unitHandler.GetUnit(lua_toint(L, -1));
+
+		lua_pop(L, 1);
+
+		const bool isVisible = (unit != nullptr && IsUnitVisible(L, unit));
+		const bool isInLos = (isVisible && ::IsUnitInLos(L, unit));
+
+		float3 errorVec;
+
+		if (isVisible && !IsAllyUnit(L, unit))
+			errorVec = unit->GetLuaErrorVector(CLuaHandle::GetHandleReadAllyTeam(L), CLuaHandle::GetHandleFullRead(L));
+
+		for (int j = 0; j < numFields; j++) {
+			const int field = fields[j];
+
+			float values[5] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+			unsigned int nilMask = 0;
+
+			switch (field) {
+				case FIELD_POSITION:
+				case FIELD_MID_POSITION:
+				case FIELD_AIM_POSITION: {
+					if (!isVisible) {
+						nilMask = ~0u;
+						break;
+					}
+
+					float3 pos = unit->pos;
+
+					if (field == FIELD_MID_POSITION)
+						pos = unit->midPos;
+					if (field == FIELD_AIM_POSITION)
+						pos = unit->aimPos;
+
+					pos += errorVec;
+
+					values[0] = pos.x;
+					values[1] = pos.y;
+					values[2] = pos.z;
+				} break;
+
+				case FIELD_VELOCITY: {
+					if (!isInLos) {
+						nilMask = ~0u;
+						break;
+					}
+
+					values[0] = unit->speed.x;
+					values[1] = unit->speed.y;
+					values[2] = unit->speed.z;
+					values[3] = unit->speed.w;
+				} break;
+
+				case FIELD_DIRECTION: {
+					if (!isInLos) {
+						nilMask = ~0u;
+						break;
+					}
+
+					values[0] = unit->frontdir.x;
+					values[1] = unit->frontdir.y;
+					values[2] = unit->frontdir.z;
+				} break;
+
+				case FIELD_HEADING: {
+					if (!isInLos) {
+						nilMask = ~0u;
+						break;
+					}
+
+					values[0] = unit->heading;
+				} break;
+
+				case FIELD_HEALTH: {
+					if (!isInLos) {
+						nilMask = ~0u;
+						break;
+					}
+
+					const UnitDef* ud = unit->unitDef;
+					const bool enemyUnit = IsEnemyUnit(L, unit);
+
+					float scale = 1.0f;
+
+					if (ud->hideDamage && enemyUnit) {
+						nilMask = 1 | 2 | 4;
+					} else if (enemyUnit && (ud->decoyDef != nullptr)) {
+						scale = (ud->decoyDef->health / ud->health);
+					}
+
+					values[0] = scale * unit->health;
+					values[1] = scale * unit->maxHealth;
+					values[2] = scale * unit->paralyzeDamage;
+					values[3] = unit->captureProgress;
+					values[4] = unit->buildProgress;
+				} break;
+
+				case FIELD_TEAM: {
+					if (!isVisible) {
+						nilMask = ~0u;
+						break;
+					}
+
+					values[0] = unit->team;
+				} break;
+
+				default: {
+					assert(false);
+				} break;
+			}
+
+			SetValues(values, fieldWidths[field], nilMask);
+		}
+	}
+
+	// a reused output may hold more values from an earlier, larger query
+	if (lua_istable(L, 3))
+		ClearSparseTableTail(L, tableIdx, valueIdx - 1);
+
+	lua_pushnumber(L, stride);
+	return 2;
+}
+
+
 int LuaSyncedRead::GetUnitBuildFacing(lua_State* L)
 {
 	const CUnit* unit = ParseInLosUnit(L, __func__, 1);
@@ -4558,6 +4941,101 @@ int LuaSyncedRead::GetUnitRulesParam(lua_State* L)
 }
 
 
+int LuaSyncedRead::GetUnitRulesParamSlot(lua_State* L)
+{
+	const LuaRulesParams::ParamSlots& slots = CSplitLuaHandle::GetUnitParamSlots();
+
+	const char* name = luaL_checkstring(L, 1);
+	const auto iter = std::find_if(slots.begin(), slots.end(), [&](const LuaRulesParams::ParamSlot& s) { return (s.name == name); });
+
+	if (iter == slots.end())
+		return 0;
+
+	lua_pushnumber(L, (iter - slots.begin()) + 1);
+	return 1;
+}
+
+
+/*
+ * Spring.GetUnitRulesParamSlots(unitIDs, slots[, output]) -> output, stride
+ *
+ * Bulk read of slot-registered unit rules-params (see AddUnitRulesParamSlot).
+ * Laid out like GetUnitArrayState: the values of unit i (1-based) start at
+ * index (i - 1) * stride + 1, in the order of <slots>. Values that are unset
+ * or not readable with the caller's access (same rules as GetUnitRulesParam)
+ * are nil. Values past the result in a reused <output> are removed.
+ */
+int LuaSyncedRead::GetUnitRulesParamSlots(lua_State* L)
+{
+	if (!lua_istable(L, 1) || !lua_istable(L, 2))
+		luaL_error(L, "Incorrect arguments to GetUnitRulesParamSlots(unitIDs, slots[, output])");
+
+	const LuaRulesParams::ParamSlots& paramSlots = CSplitLuaHandle::GetUnitParamSlots();
+
+	std::array<unsigned short, LuaRulesParams::MAX_PARAM_SLOTS> slots;
+
+	const int numSlots = lua_objlen(L, 2);
+	const int numUnits = lua_objlen(L, 1);
+
+	if (numSlots > int(slots.size()))
+		luaL_error(L, "[%s] too many slots", __func__);
+
+	for (int i = 1; i <= numSlots; i++) {
+		lua_rawgeti(L, 2, i);
+
+		const unsigned int slot = luaL_checkint(L, -1) - 1;
+
+		if (slot >= paramSlots.size())
+			luaL_error(L, "[%s] invalid slot %d (#%d)", __func__, slot + 1, i);
+
+		slots[i - 1] = slot;
+		lua_pop(L, 1);
+	}
+
+	if (lua_istable(L, 3)) {
+		lua_pushvalue(L, 3);
+	} else {
+		lua_createtable(L, numUnits * numSlots, 0);
+	}
+
+	const int tableIdx = lua_gettop(L);
+	int valueIdx = 1;
+
+	for (int i = 1; i <= numUnits; i++) {
+		lua_rawgeti(L, 1, i);
+
+		if (!lua_isnumber(L, -1))
+			luaL_error(L, "[%s] unitID (entry #%d) not a number", __func__, i);
+
+		const CUnit* unit = unitHandler.GetUnit(lua_toint(L, -1));
+
+		lua_pop(L, 1);
+
+		// same checks as GetUnitRulesParam; a zero mask makes every slot nil
+		const bool isVisible = (unit != nullptr && game != nullptr && IsUnitVisible(L, unit));
+		const int losMask = isVisible? GetUnitRulesParamLosMask(L, unit): 0;
+
+		for (int j = 0; j < numSlots; j++) {
+			const unsigned int slot = slots[j];
+
+			if ((paramSlots[slot].los & losMask) == 0 || slot >= unit->modParamSlots.size() || math::isnan(unit->modParamSlots[slot])) {
+				lua_pushnil(L);
+			} else {
+				lua_pushnumber(L, unit->modParamSlots[slot]);
+			}
+
+			lua_rawseti(L, tableIdx, valueIdx++);
+		}
+	}
+
+	if (lua_istable(L, 3))
+		ClearSparseTableTail(L, tableIdx, valueIdx - 1);
+
+	lua_pushnumber(L, numSlots);
+	return 2;
+}
+
+
 /******************************************************************************/
 
 int LuaSyncedRead::GetUnitCmdDescs(lua_State* L)
@@ -14,6 +14,9 @@ class LuaSyncedRead {
 
 		static void AllowGameChanges(bool value);
 
+		// hit and miss counts of the GetUnitsIn* query cache (unsynced)
+		static void GetSpatialQueryCacheStats(unsigned int& hits, unsigned int& misses);
+
 	public: // also used with LuaParser clients
 		static int GetMapOptions(lua_State* L);
 		static int GetModOptions(lua_State* L);
@@ -123,6 +126,7 @@ class LuaSyncedRead {
 		static int GetUnitDirection(lua_State* L);
 		static int GetUnitHeading(lua_State* L);
 		static int GetUnitVelocity(lua_State* L);
+		static int GetUnitArrayState(lua_State* L);
 		static int GetUnitBuildFacing(lua_State* L);
 		static int GetUnitIsBuilding(lua_State* L);
 		static int GetUnitCurrentBuildPower(lua_State* L);
@@ -167,6 +171,8 @@ class LuaSyncedRead {
 
 		static int GetUnitRulesParam(lua_State* L);
 		static int GetUnitRulesParams(lua_State* L);
+		static int GetUnitRulesParamSlot(lua_State* L);
+		static int GetUnitRulesParamSlots(lua_State* L);
 
 		static int GetUnitLosState(lua_State* L);
 		static int GetUnitSeparation(lua_State* L);
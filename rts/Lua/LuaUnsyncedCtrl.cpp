@@ -2,6 +2,7 @@
 
 #include "LuaUnsyncedCtrl.h"
 
+#include "LuaCallInProfiler.h"
 #include "LuaConfig.h"
 #include "LuaInclude.h"
 #include "LuaHandle.h"
@@ -258,6 +259,9 @@ bool LuaUnsyncedCtrl::PushEntries(lua_State* L)
 
 	REGISTER_LUA_CFUNC(ClearWatchDogTimer);
 	REGISTER_LUA_CFUNC(GarbageCollectCtrl);
+	REGISTER_LUA_CFUNC(IsCallInProfilerEnabled);
+	REGISTER_LUA_CFUNC(PushCallInProfilerScope);
+	REGISTER_LUA_CFUNC(PopCallInProfilerScope);
 
 	REGISTER_LUA_CFUNC(PreloadUnitDefModel);
 	REGISTER_LUA_CFUNC(PreloadFeatureDefModel);
@@ -3041,6 +3045,28 @@ int LuaUnsyncedCtrl::GarbageCollectCtrl(lua_State* L) {
 	return 0;
 }
 
+int LuaUnsyncedCtrl::IsCallInProfilerEnabled(lua_State* L) {
+	lua_pushboolean(L, luaCallInProfiler.IsEnabled());
+	return 1;
+}
+
+int LuaUnsyncedCtrl::PushCallInProfilerScope(lua_State* L) {
+	// e.g. called by handlers around each gadget's or widget's call-in
+	if (!luaCallInProfiler.IsEnabled())
+		return 0;
+
+	luaCallInProfiler.PushScope(L, luaL_checkstring(L, 1));
+	return 0;
+}
+
+int LuaUnsyncedCtrl::PopCallInProfilerScope(lua_State* L) {
+	if (!luaCallInProfiler.IsEnabled())
+		return 0;
+
+	luaCallInProfiler.PopScope(L);
+	return 0;
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -164,6 +164,9 @@ class LuaUnsyncedCtrl {
 
 		static int ClearWatchDogTimer(lua_State* L);
 		static int GarbageCollectCtrl(lua_State* L);
+		static int IsCallInProfilerEnabled(lua_State* L);
+		static int PushCallInProfilerScope(lua_State* L);
+		static int PopCallInProfilerScope(lua_State* L);
 
 		static int PreloadUnitDefModel(lua_State* L);
 		static int PreloadFeatureDefModel(lua_State* L);
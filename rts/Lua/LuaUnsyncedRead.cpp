@@ -6,6 +6,7 @@
 #include "LuaInclude.h"
 #include "LuaHandle.h"
 #include "LuaHashString.h"
+#include "LuaSyncedRead.h"
 #include "LuaUtils.h"
 #include "Game/Camera.h"
 #include "Game/CameraHandler.h"
@@ -94,6 +95,8 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 
 	REGISTER_LUA_CFUNC(GetLuaMemUsage);
 	REGISTER_LUA_CFUNC(GetVidMemUsage);
+	REGISTER_LUA_CFUNC(GetLosCacheStats);
+	REGISTER_LUA_CFUNC(GetSpatialQueryCacheStats);
 
 	REGISTER_LUA_CFUNC(GetDrawFrame);
 	REGISTER_LUA_CFUNC(GetFrameTimeOffset);
@@ -454,6 +457,29 @@ int LuaUnsyncedRead::GetVidMemUsage(lua_State* L)
 	return 2;
 }
 
+int LuaUnsyncedRead::GetLosCacheStats(lua_State* L)
+{
+	// terrain-keyed raycast results, then shared LOS-instances
+	lua_pushnumber(L, losHandler->GetRaycastCacheHits());
+	lua_pushnumber(L, losHandler->GetRaycastCacheMisses());
+	lua_pushnumber(L, ILosType::cacheHits);
+	lua_pushnumber(L, ILosType::cacheFails);
+	return 4;
+}
+
+int LuaUnsyncedRead::GetSpatialQueryCacheStats(lua_State* L)
+{
+	unsigned int hits = 0;
+	unsigned int misses = 0;
+
+	// GetUnitsIn{Rectangle,Cylinder,Sphere} results reused within a frame
+	LuaSyncedRead::GetSpatialQueryCacheStats(hits, misses);
+
+	lua_pushnumber(L, hits);
+	lua_pushnumber(L, misses);
+	return 2;
+}
+
 
 /******************************************************************************/
 
@@ -24,6 +24,8 @@ class LuaUnsyncedRead {
 
 		static int GetLuaMemUsage(lua_State* L);
 		static int GetVidMemUsage(lua_State* L);
+		static int GetLosCacheStats(lua_State* L);
+		static int GetSpatialQueryCacheStats(lua_State* L);
 
 		static int GetDrawFrame(lua_State* L);
 		static int GetFrameTimeOffset(lua_State* L);
@@ -442,6 +442,9 @@ void CGameServer::SkipTo(int targetFrameNum)
 	CommandMessage endMsg("skip end", SERVER_PLAYER);
 	Broadcast(std::shared_ptr<const netcode::RawPacket>(startMsg.Pack()));
 
+	// only the frames after the closest keyframe (if any) need simulating
+	SkipToKeyFrame(targetFrameNum);
+
 	// fast-read and send demo data
 	//
 	// note that we must maintain <modGameTime> ourselves
@@ -467,6 +470,38 @@ void CGameServer::SkipTo(int targetFrameNum)
 	isPaused = wasPaused;
 }
 
+bool CGameServer::SkipToKeyFrame(int targetFrameNum)
+{
+	const DemoIndexedKeyFrame* keyFrame = demoReader->FindKeyFrame(serverFrameNum, targetFrameNum);
+
+	if (keyFrame == nullptr)
+		return false;
+
+	// clients load the savestate from their own copy of the demo,
+	// which remote spectators of a hosted replay might not have
+	for (const GameParticipant& p: players) {
+		if (p.clientLink != nullptr && !p.isLocal)
+			return false;
+	}
+
+	// a keyframe clients can not load is fatal for them once the stream
+	// has moved past the frames they would otherwise simulate, so check
+	// its savestate is intact first
+	std::string keyFrameData;
+
+	if (!demoReader->ReadKeyFrame(*keyFrame, keyFrameData))
+		return false;
+	if (!demoReader->SeekToKeyFrame(*keyFrame))
+		return false;
+
+	serverFrameNum = keyFrame->frameNum;
+	modGameTime = demoReader->GetModGameTime() + 0.001f;
+
+	CommandMessage keyFrameMsg(spring::format("skip keyframe %d", keyFrame->frameNum), SERVER_PLAYER);
+	Broadcast(std::shared_ptr<const netcode::RawPacket>(keyFrameMsg.Pack()));
+	return true;
+}
+
 std::string CGameServer::GetPlayerNames(const std::vector<int>& indices) const
 {
 	std::string playerstring;
@@ -182,6 +182,8 @@ private:
 	 * targetFrame to all clients
 	 */
 	void SkipTo(int targetFrameNum);
+	/// jump to the last savestate embedded in the demo before targetFrame
+	bool SkipToKeyFrame(int targetFrameNum);
 
 	void Message(const std::string& message, bool broadcast = true, bool internal = false);
 	void PrivateMessage(int playerNum, const std::string& message);
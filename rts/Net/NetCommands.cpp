@@ -559,6 +559,7 @@ void CGame::ClientReadNet()
 				lastSimFrameNetPacketTime = spring_gettime();
 
 				SimFrame();
+				SaveDemoKeyFrame();
 
 #ifdef SYNCCHECK
 				// both NETMSG_SYNCRESPONSE and NETMSG_NEWFRAME are used for ping calculation by server
@@ -473,11 +473,12 @@ bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 	if (!file.IsBuffered()) {
 		buffer.resize(file.FileSize(), 0);
 		file.Read(buffer.data(), buffer.size());
-	} else {
-		// steal if file was loaded from VFS
-		buffer = std::move(file.GetBuffer());
 	}
 
+	// if file was loaded from VFS, decode straight from its (possibly mapped) contents
+	const uint8_t* fileData = (file.IsBuffered())? file.GetBufferData(): buffer.data();
+	const size_t fileSize = (file.IsBuffered())? file.FileSize(): buffer.size();
+
 
 	{
 		std::lock_guard<spring::mutex> lck(texMemPool.GetMutex());
@@ -495,7 +496,7 @@ bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 			// do not signal floating point exceptions in devil library
 			ScopedDisableFpuExceptions fe;
 
-			isLoaded = !!ilLoadL(IL_TYPE_UNKNOWN, buffer.data(), buffer.size());
+			isLoaded = !!ilLoadL(IL_TYPE_UNKNOWN, fileData, fileSize);
 			isValid = (isLoaded && IsValidImageFormat(ilGetInteger(IL_IMAGE_FORMAT)));
 			noAlpha = (isValid && (ilGetInteger(IL_IMAGE_BYTES_PER_PIXEL) != 4));
 
@@ -1,5 +1,8 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
+#include <cstring>
+
 #include "LosHandler.h"
 
 #include "Sim/Units/Unit.h"
@@ -91,6 +94,10 @@ void ILosType::Init(const int mipLevel_, LosType type_)
 	freeIDs.reserve(4096);
 	losMaps.resize(teamHandler.ActiveAllyTeams());
 
+	raycastCacheHits = 0;
+	raycastCacheMisses = 0;
+	useRaycastCache = (algoType == LOS_ALGO_RAYCAST && modInfo.losRaycastCache);
+
 	const float* ctrHeightMap = readMap->GetCenterHeightMapSynced();
 	const float* mipHeightMap = readMap->GetMIPHeightMapSynced(mipLevel_);
 
@@ -103,6 +110,8 @@ void ILosType::Kill()
 {
 	// iterated in UpdateHeightMapSynced
 	spring::clear_unordered_map(instanceHashes);
+	spring::clear_unordered_map(raycastResults);
+	spring::clear_unordered_map(raycastBatch);
 
 	// reuse inner vectors when reloading
 	// losMaps.clear();
@@ -123,6 +132,10 @@ void ILosType::Kill()
 	losDeleted.clear();
 	losRecalc.clear();
 
+	raycastResultKeys.clear();
+	raycastJobs.clear();
+	raycastDupes.clear();
+
 	// mark as invalid
 	size = {0, 0};
 }
@@ -552,14 +565,8 @@ void ILosType::Update()
 	}
 
 	// raycast terrain
-	if (algoType == LOS_ALGO_RAYCAST)  {
-		for_mt(0, losRecalc.size(), [&](const int idx) {
-			auto li = losRecalc[idx];
-			assert(li->refCount > 0);
-			li->squares.clear();
-			losMaps[li->allyteam].PrepareRaycast(li);
-		});
-	}
+	if (algoType == LOS_ALGO_RAYCAST)
+		RaycastInstances();
 
 	// add sight
 	for (SLosInstance* li: losAdd) {
@@ -591,14 +598,118 @@ void ILosType::Update()
 }
 
 
+ILosType::RaycastKey ILosType::GetRaycastKey(const SLosInstance* li) const
+{
+	RaycastKey key;
+	key.basePos = li->basePos;
+	key.radius = li->radius;
+
+	// exact (bitwise) height; CLosMap::LosAdd uses it unrounded, so
+	// anything coarser would make results depend on cache history
+	std::memcpy(&key.baseHeight, &li->baseHeight, sizeof(key.baseHeight));
+	return key;
+}
+
+
+void ILosType::AddRaycastResult(const RaycastKey& key, const SLosInstance* li)
+{
+	// keys are only added when absent and removed from the FIFO together
+	// with their result (see UpdateHeightMapSynced), so each is unique here
+	assert(raycastResults.find(key) == raycastResults.end());
+
+	while (raycastResultKeys.size() >= RAYCAST_CACHE_SIZE) {
+		raycastResults.erase(raycastResultKeys.front());
+		raycastResultKeys.pop_front();
+	}
+
+	raycastResults[key].squares = li->squares;
+
+	raycastResultKeys.push_back(key);
+}
+
+
+void ILosType::RaycastInstances()
+{
+	// runs on a pool thread, ILosType::Update is called via for_mt
+	SCOPED_MT_TIMER("Sim::Los::Raycast");
+
+	raycastJobs.clear();
+	raycastJobs.reserve(losRecalc.size());
+	raycastDupes.clear();
+	raycastBatch.clear();
+
+	if (!useRaycastCache) {
+		for_mt(0, losRecalc.size(), [&](const int idx) {
+			SLosInstance* li = losRecalc[idx];
+			assert(li->refCount > 0);
+			li->squares.clear();
+			losMaps[li->allyteam].PrepareRaycast(li);
+		});
+		return;
+	}
+
+	// resolve against the cache first; instances in this batch that
+	// share a key with an earlier one only get raycast once
+	for (SLosInstance* li: losRecalc) {
+		assert(li->refCount > 0);
+		li->squares.clear();
+
+		const RaycastKey key = GetRaycastKey(li);
+		const auto resultIt = raycastResults.find(key);
+
+		if (resultIt != raycastResults.end()) {
+			raycastJobs.push_back({li, &resultIt->second, key});
+			raycastCacheHits++;
+			continue;
+		}
+
+		const auto batchIt = raycastBatch.find(key);
+
+		if (batchIt != raycastBatch.end()) {
+			raycastDupes.emplace_back(li, batchIt->second);
+			raycastCacheHits++;
+			continue;
+		}
+
+		raycastBatch.insert(key, li);
+		raycastJobs.push_back({li, nullptr, key});
+		raycastCacheMisses++;
+	}
+
+	// no insertions happen here, so result pointers remain valid
+	for_mt(0, raycastJobs.size(), [&](const int idx) {
+		const RaycastJob& job = raycastJobs[idx];
+
+		if (job.result != nullptr) {
+			job.instance->squares = job.result->squares;
+			return;
+		}
+
+		losMaps[job.instance->allyteam].PrepareRaycast(job.instance);
+	});
+
+	// store fresh results in (deterministic) batch order
+	for (const RaycastJob& job: raycastJobs) {
+		if (job.result != nullptr)
+			continue;
+
+		AddRaycastResult(job.key, job.instance);
+	}
+
+	for (const auto& p: raycastDupes) {
+		p.first->squares = p.second->squares;
+	}
+}
+
+
 void ILosType::UpdateHeightMapSynced(SRectangle rect)
 {
 	if (algoType == LOS_ALGO_CIRCLE)
 		return;
 
-	auto CheckOverlap = [&](SLosInstance* li, SRectangle rect) -> bool {
-		int2 pos = li->basePos * mipDiv;
-		const int radius = li->radius * mipDiv;
+	auto CheckOverlap = [&](int2 basePos, int baseRadius, SRectangle rect) -> bool {
+		int2 pos = basePos * mipDiv;
+		const int radius = baseRadius * mipDiv;
 
 		const int hw = rect.GetWidth() * (SQUARE_SIZE / 2);
 		const int hh = rect.GetHeight() * (SQUARE_SIZE / 2);
@@ -618,7 +729,7 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 	// delete unused instances that overlap with the changed rectangle
 	for (auto it = losCache.begin(); it != losCache.end();) {
 		SLosInstance* li = *it;
-		if (li->refCount > 0 || !CheckOverlap(li, rect)) {
+		if (li->refCount > 0 || !CheckOverlap(li->basePos, li->radius, rect)) {
 			++it;
 			continue;
 		}
@@ -633,12 +744,27 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 		for (SLosInstance* li: p.second) {
 			if (li->status & SLosInstance::TLosStatus::RECALC)
 				continue;
-			if (!CheckOverlap(li, rect))
+			if (!CheckOverlap(li->basePos, li->radius, rect))
 				continue;
 
 			UpdateInstanceStatus(li, SLosInstance::TLosStatus::RECALC);
 		}
 	}
+
+	if (raycastResults.empty())
+		return;
+
+	// forget raycast results that are no longer valid for the new terrain;
+	// their keys leave the FIFO as well so it never holds duplicates
+	const auto IsInvalidResult = [&](const RaycastKey& key) {
+		if (!CheckOverlap(key.basePos, key.radius, rect))
+			return false;
+
+		raycastResults.erase(key);
+		return true;
+	};
+
+	raycastResultKeys.erase(std::remove_if(raycastResultKeys.begin(), raycastResultKeys.end(), IsInvalidResult), raycastResultKeys.end());
 }
 
 
@@ -708,6 +834,17 @@ void CLosHandler::Init()
 	eventHandler.AddClient(this);
 }
 
+size_t CLosHandler::GetRaycastCacheHits() const
+{
+	return (los.raycastCacheHits + radar.raycastCacheHits);
+}
+
+size_t CLosHandler::GetRaycastCacheMisses() const
+{
+	return (los.raycastCacheMisses + radar.raycastCacheMisses);
+}
+
+
 void CLosHandler::Kill()
 {
 	los.Kill();
@@ -736,6 +873,9 @@ void CLosHandler::Kill()
 		100.0f * float(ILosType::cacheHits - ILosType::cacheRefs) / (ILosType::cacheHits + ILosType::cacheFails),
 		100.0f * float(ILosType::cacheRefs) / (ILosType::cacheHits + ILosType::cacheFails)
 	);
+	LOG("[LosHandler::%s] raycast result cache-{hits,misses}={%u,%u}",
+		__func__, unsigned(GetRaycastCacheHits()), unsigned(GetRaycastCacheMisses())
+	);
 
 	losTypes.fill(nullptr);
 }
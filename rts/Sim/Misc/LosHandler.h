@@ -3,6 +3,7 @@
 #ifndef LOS_HANDLER_H
 #define LOS_HANDLER_H
 
+#include <cinttypes>
 #include <vector>
 #include <deque>
 
@@ -14,6 +15,7 @@
 #include "System/Rectangle.h"
 #include "System/EventClient.h"
 #include "System/UnorderedMap.hpp"
+#include "System/Sync/HsiehHash.h"
 
 
 /**
@@ -99,6 +101,13 @@ public:
  * LOS is not removed immediately when a unit gets killed. Instead,
  * DelayedFreeInstance is called. This keeps the LosInstance (including the
  * actual sight) alive until 1.5 game seconds after the unit got killed.
+ *
+ * Raycast results do not depend on the ally-team, so if enabled through the
+ * sensors.los.raycastCache modrule they are additionally kept in a cache
+ * (raycastResults) shared by all instances with the same position, radius
+ * and exact height. Entries are dropped when the heightmap changes within
+ * their radius, so a cached result is always identical to a fresh raycast
+ * and the (unsaved) cache contents never affect the simulation.
  */
 class ILosType
 {
@@ -133,6 +142,22 @@ public:
 	void RemoveUnit(CUnit* unit, bool delayed = false);
 	void UpdateUnit(CUnit* unit, bool ignore = false);
 
+private:
+	struct RaycastKey {
+		bool operator == (const RaycastKey& k) const {
+			return (basePos == k.basePos && radius == k.radius && baseHeight == k.baseHeight);
+		}
+
+		int2 basePos;
+		int radius;
+		std::uint32_t baseHeight; // bits of SLosInstance::baseHeight
+	};
+	struct RaycastKeyHash {
+		std::uint32_t operator () (const RaycastKey& k) const {
+			return (HsiehHash(&k, sizeof(k), 0));
+		}
+	};
+
 private:
 	//void PostLoad();
 
@@ -150,7 +175,12 @@ private:
 	SLosInstance* CreateInstance();
 	void DeleteInstance(SLosInstance* instance);
 
+	void RaycastInstances();
+	void AddRaycastResult(const RaycastKey& key, const SLosInstance* instance);
+
 private:
+	RaycastKey GetRaycastKey(const SLosInstance* instance) const;
+
 	int GetHashNum(const int allyteam, const int2 baseLos, const float radius) const;
 
 	float GetRadius(const CUnit* unit) const;
@@ -170,6 +200,10 @@ public:
 	static size_t cacheHits;
 	static size_t cacheRefs;
 
+	// not static, types are updated concurrently
+	size_t raycastCacheHits = 0;
+	size_t raycastCacheMisses = 0;
+
 	spring::unordered_map<int, std::vector<SLosInstance*> > instanceHashes;
 
 	std::vector<CLosMap> losMaps;
@@ -192,7 +226,26 @@ private:
 	std::vector<SLosInstance*> losDeleted;
 	std::vector<SLosInstance*> losRecalc;
 
+	struct RaycastResult {
+		std::vector<SLosInstance::RLE> squares;
+	};
+	struct RaycastJob {
+		SLosInstance* instance;
+		const RaycastResult* result;
+		RaycastKey key;
+	};
+
+	spring::unordered_map<RaycastKey, RaycastResult, RaycastKeyHash> raycastResults;
+	spring::unordered_map<RaycastKey, SLosInstance*, RaycastKeyHash> raycastBatch;
+
+	std::deque<RaycastKey> raycastResultKeys;
+	std::vector<RaycastJob> raycastJobs;
+	std::vector< std::pair<SLosInstance*, const SLosInstance*> > raycastDupes;
+
 	static constexpr int CACHE_SIZE = 4096;
+	static constexpr int RAYCAST_CACHE_SIZE = 8192;
+
+	bool useRaycastCache = false;
 };
 
 
@@ -294,6 +347,10 @@ public:
 	void Update() override;
 	void UpdateHeightMapSynced(SRectangle rect);
 
+	// summed over all raycasting LOS-types
+	size_t GetRaycastCacheHits() const;
+	size_t GetRaycastCacheMisses() const;
+
 public:
 	/**
 	* @brief global line-of-sight
@@ -4,6 +4,7 @@
 #include <array>
 
 #include "LosMap.h"
+#include "LosMapKernels.h"
 #include "LosHandler.h"
 #include "Map/ReadMap.h"
 #include "System/SpringMath.h"
@@ -15,7 +16,7 @@
 	#include "Game/GlobalUnsynced.h" // for myAllyTeam
 #endif
 
-constexpr float LOS_BONUS_HEIGHT = 5.0f;
+constexpr float LOS_BONUS_HEIGHT = LosMapKernels::LOS_BONUS_HEIGHT;
 
 
 
@@ -125,6 +126,10 @@ public:
 		return losTables[losSize][rayIndex][squareIdx];
 	}
 
+	const int2* GetLosTableRay(size_t losSize, size_t rayIndex) {
+		return (losTables[losSize][rayIndex].data());
+	}
+
 	size_t GetLosTableRaySize(size_t losSize, size_t rayIndex) {
 		return losTables[losSize][rayIndex].size();
 	}
@@ -417,9 +422,7 @@ void CLosMap::AddCircle(SLosInstance* instance, int amount)
 			const unsigned sx = Clamp(instance->basePos.x - width,     0, size.x);
 			const unsigned ex = Clamp(instance->basePos.x + width + 1, 0, size.x);
 
-			for (unsigned x_ = sx; x_ < ex; ++x_) {
-				losmap[(y_ * size.x) + x_] += amount;
-			}
+			LosMapKernels::AddToRow(&losmap[(y_ * size.x) + sx], ex - sx, amount);
 		}
 	});
 }
@@ -460,9 +463,7 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 #endif
 
 	for (const SLosInstance::RLE rle: losSquares) {
-		for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
-			losmap[idx] += amount;
-		}
+		LosMapKernels::AddToRow(&losmap[rle.start], rle.length, amount);
 	}
 }
 
@@ -653,22 +654,18 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	// cast the rays
 	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
 
+	// all four rotations of each ray are walked together, see LosMapKernels
 	const size_t numRays = helper.GetLosTableSize(radius);
 
 	for (size_t i = 0; i < numRays; ++i) {
-		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-
-		const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-		for (size_t n = 0; n < numSquares; n++) {
-			const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-			CastLos(&prvAngles[0], &maxAngles[0],       square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[1], &maxAngles[1],      -square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[2], &maxAngles[2], int2( square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y,  square.x), losRaySquares, raycastAngles, radius, threadNum);
-		}
+		LosMapKernels::CastRay(
+			helper.GetLosTableRay(radius, i),
+			helper.GetLosTableRaySize(radius, i),
+			raycastAngles.data(),
+			losRaySquares.data(),
+			RADIUS_ISQRT_TABLES[threadNum].data(),
+			radius
+		);
 	}
 
 	// translate visible square indices to map square idx + RLE
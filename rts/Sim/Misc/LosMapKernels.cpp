@@ -0,0 +1,245 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "LosMapKernels.h"
+
+#if (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
+	#define LOS_SIMD_KERNELS 1
+	#include <immintrin.h>
+	#define LOS_TARGET(isa) __attribute__((target(isa)))
+#else
+	#define LOS_SIMD_KERNELS 0
+#endif
+
+
+namespace LosMapKernels {
+
+typedef void (*AddToRowFunc)(unsigned short*, unsigned, int);
+typedef void (*CastRayFunc)(const int2*, size_t, const float*, char*, const float*, int);
+
+
+static inline void GetRotatedIndices(const int2 s, const int center, const int stride, int* idx)
+{
+	// square, -square, (s.y, -s.x), (-s.y, s.x); same order as CLosMap::SafeLosAdd
+	idx[0] = center + s.y * stride + s.x;
+	idx[1] = center - s.y * stride - s.x;
+	idx[2] = center - s.x * stride + s.y;
+	idx[3] = center + s.x * stride - s.y;
+}
+
+
+static void AddToRowScalar(unsigned short* row, unsigned count, int amount)
+{
+	for (unsigned i = 0; i < count; ++i) {
+		row[i] += amount;
+	}
+}
+
+static void CastRayScalar(
+	const int2* raySquares,
+	size_t numSquares,
+	const float* angles,
+	char* visible,
+	const float* isqrtTable,
+	int radius
+) {
+	const int stride = 2 * radius + 1;
+	const int center = radius * stride + radius;
+
+	float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+	float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+
+	int idx[4];
+
+	for (size_t n = 0; n < numSquares; n++) {
+		const int2 s = raySquares[n];
+
+		GetRotatedIndices(s, center, stride, idx);
+
+		for (int k = 0; k < 4; k++) {
+			const float angle = angles[idx[k]];
+
+			// angle to square is smaller than current max-angle, so not visible
+			if (angle < maxAngles[k]) {
+				visible[idx[k]] = false;
+				continue;
+			}
+
+			if (angle < prvAngles[k]) {
+				const float invR = isqrtTable[s.x * s.x + s.y * s.y];
+
+				if (angle < (maxAngles[k] = prvAngles[k] - LOS_BONUS_HEIGHT * invR)) {
+					visible[idx[k]] = false;
+					continue;
+				}
+			}
+
+			prvAngles[k] = angle;
+		}
+	}
+}
+
+
+#if (LOS_SIMD_KERNELS == 1)
+LOS_TARGET("sse2")
+static void AddToRowSSE2(unsigned short* row, unsigned count, int amount)
+{
+	const __m128i inc = _mm_set1_epi16(short(amount));
+
+	unsigned i = 0;
+
+	for (; (i + 8) <= count; i += 8) {
+		__m128i* ptr = reinterpret_cast<__m128i*>(row + i);
+		_mm_storeu_si128(ptr, _mm_add_epi16(_mm_loadu_si128(ptr), inc));
+	}
+	for (; i < count; ++i) {
+		row[i] += amount;
+	}
+}
+
+LOS_TARGET("avx2")
+static void AddToRowAVX2(unsigned short* row, unsigned count, int amount)
+{
+	const __m256i inc = _mm256_set1_epi16(short(amount));
+
+	unsigned i = 0;
+
+	for (; (i + 16) <= count; i += 16) {
+		__m256i* ptr = reinterpret_cast<__m256i*>(row + i);
+		_mm256_storeu_si256(ptr, _mm256_add_epi16(_mm256_loadu_si256(ptr), inc));
+	}
+	for (; i < count; ++i) {
+		row[i] += amount;
+	}
+}
+
+
+// the four rotations of a ray are independent, so each gets a lane;
+// compares and blends are exact, the one subtraction matches scalar
+LOS_TARGET("sse2")
+static void CastRaySSE2(
+	const int2* raySquares,
+	size_t numSquares,
+	const float* angles,
+	char* visible,
+	const float* isqrtTable,
+	int radius
+) {
+	const int stride = 2 * radius + 1;
+	const int center = radius * stride + radius;
+
+	const __m128 bonusHeight = _mm_set1_ps(LOS_BONUS_HEIGHT);
+
+	__m128 maxAngles = _mm_set1_ps(-1e7f);
+	__m128 prvAngles = _mm_set1_ps(-1e7f);
+
+	int idx[4];
+
+	for (size_t n = 0; n < numSquares; n++) {
+		const int2 s = raySquares[n];
+
+		GetRotatedIndices(s, center, stride, idx);
+
+		const __m128 curAngles = _mm_set_ps(angles[idx[3]], angles[idx[2]], angles[idx[1]], angles[idx[0]]);
+		const __m128 belowMax = _mm_cmplt_ps(curAngles, maxAngles);
+		const __m128 belowPrv = _mm_andnot_ps(belowMax, _mm_cmplt_ps(curAngles, prvAngles));
+
+		if (_mm_movemask_ps(belowPrv) != 0) {
+			// all rotations share the same distance
+			const __m128 invR = _mm_set1_ps(isqrtTable[s.x * s.x + s.y * s.y]);
+			const __m128 newMax = _mm_sub_ps(prvAngles, _mm_mul_ps(bonusHeight, invR));
+
+			maxAngles = _mm_or_ps(_mm_and_ps(belowPrv, newMax), _mm_andnot_ps(belowPrv, maxAngles));
+		}
+
+		const __m128 hidden = _mm_or_ps(belowMax, _mm_and_ps(belowPrv, _mm_cmplt_ps(curAngles, maxAngles)));
+		const int hiddenMask = _mm_movemask_ps(hidden);
+
+		prvAngles = _mm_or_ps(_mm_and_ps(hidden, prvAngles), _mm_andnot_ps(hidden, curAngles));
+
+		if (hiddenMask == 0)
+			continue;
+
+		for (int k = 0; k < 4; k++) {
+			if ((hiddenMask & (1 << k)) != 0)
+				visible[idx[k]] = false;
+		}
+	}
+}
+#endif
+
+
+
+static KernelType DetectType()
+{
+	#if (LOS_SIMD_KERNELS == 1)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		return KERNEL_TYPE_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return KERNEL_TYPE_SSE2;
+	#endif
+
+	return KERNEL_TYPE_SCALAR;
+}
+
+
+static KernelType kernelType = KERNEL_TYPE_SCALAR;
+
+static AddToRowFunc addToRowFunc = AddToRowScalar;
+static CastRayFunc castRayFunc = CastRayScalar;
+
+// select the best kernels before any LosMap is used
+static const KernelType initType = Init();
+
+
+KernelType Init(KernelType maxType)
+{
+	kernelType = std::min(DetectType(), maxType);
+
+	addToRowFunc = AddToRowScalar;
+	castRayFunc = CastRayScalar;
+
+	#if (LOS_SIMD_KERNELS == 1)
+	switch (kernelType) {
+		case KERNEL_TYPE_AVX2: {
+			addToRowFunc = AddToRowAVX2;
+			castRayFunc = CastRaySSE2; // a ray only has four lanes
+		} break;
+		case KERNEL_TYPE_SSE2: {
+			addToRowFunc = AddToRowSSE2;
+			castRayFunc = CastRaySSE2;
+		} break;
+		default: {
+		} break;
+	}
+	#endif
+
+	return kernelType;
+}
+
+KernelType GetType() { return kernelType; }
+
+const char* GetTypeName(KernelType type)
+{
+	constexpr const char* names[] = {"scalar", "sse2", "avx2", "unknown"};
+	return names[std::min(type, KERNEL_TYPE_COUNT)];
+}
+
+
+void AddToRow(unsigned short* row, unsigned count, int amount) { addToRowFunc(row, count, amount); }
+
+void CastRay(
+	const int2* raySquares,
+	size_t numSquares,
+	const float* angles,
+	char* visible,
+	const float* isqrtTable,
+	int radius
+) {
+	castRayFunc(raySquares, numSquares, angles, visible, isqrtTable, radius);
+}
+
+}
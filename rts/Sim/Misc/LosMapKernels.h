@@ -0,0 +1,53 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_MAP_KERNELS_H
+#define LOS_MAP_KERNELS_H
+
+#include <cstddef>
+
+#include "System/type2.h"
+
+/**
+ * Inner loops of CLosMap, with SIMD variants selected at runtime.
+ * All variants produce bit-identical results to the scalar code.
+ *
+ * The engine is compiled without SSE2+ (see SSE_FLAGS), so wider
+ * kernels are built per-function and only used if the CPU has them.
+ */
+namespace LosMapKernels {
+	enum KernelType {
+		KERNEL_TYPE_SCALAR = 0,
+		KERNEL_TYPE_SSE2   = 1,
+		KERNEL_TYPE_AVX2   = 2,
+		KERNEL_TYPE_COUNT  = 3,
+	};
+
+	constexpr float LOS_BONUS_HEIGHT = 5.0f;
+
+	// selects the widest kernels supported by the CPU, at most <maxType>
+	KernelType Init(KernelType maxType = KERNEL_TYPE_AVX2);
+	KernelType GetType();
+
+	const char* GetTypeName(KernelType type);
+
+
+	// row[i] += amount for i in [0, count), wrapping like unsigned short
+	void AddToRow(unsigned short* row, unsigned count, int amount);
+
+	/**
+	 * Walks one ray (all four rotations of <raySquares>) outward from
+	 * the center of a (2*radius+1)^2 angle-map and clears <visible> for
+	 * every square hidden by terrain; see CLosMap::UnsafeLosAdd. None of
+	 * the rotated squares may lie outside the angle-map.
+	 */
+	void CastRay(
+		const int2* raySquares,
+		size_t numSquares,
+		const float* angles,
+		char* visible,
+		const float* isqrtTable,
+		int radius
+	);
+}
+
+#endif // LOS_MAP_KERNELS_H
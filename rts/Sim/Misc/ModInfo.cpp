@@ -86,6 +86,7 @@ void CModInfo::ResetState()
 		requireSonarUnderWater = true;
 		alwaysVisibleOverridesCloaked = false;
 		separateJammers = true;
+		losRaycastCache = false;
 	}
 	{
 		featureVisibility = FEATURELOS_NONE;
@@ -94,8 +95,11 @@ void CModInfo::ResetState()
 		pathFinderSystem = NOPFS_TYPE;
 		pfRawDistMult    = 1.25f;
 		pfUpdateRate     = 0.007f;
+		pfAsyncRequests  = false;
 
 		allowTake = true;
+
+		threadedUnitUpdates = false;
 	}
 }
 
@@ -133,8 +137,11 @@ void CModInfo::Init(const std::string& modFileName)
 		pathFinderSystem = Clamp(system.GetInt("pathFinderSystem", HAPFS_TYPE), int(NOPFS_TYPE), int(QTPFS_TYPE));
 		pfRawDistMult = system.GetFloat("pathFinderRawDistMult", pfRawDistMult);
 		pfUpdateRate = system.GetFloat("pathFinderUpdateRate", pfUpdateRate);
+		pfAsyncRequests = system.GetBool("pathFinderAsyncRequests", pfAsyncRequests);
 
 		allowTake = system.GetBool("allowTake", allowTake);
+
+		threadedUnitUpdates = system.GetBool("threadedUnitUpdates", threadedUnitUpdates);
 	}
 
 	{
@@ -261,6 +268,7 @@ void CModInfo::Init(const std::string& modFileName)
 		// used in various bitshifts with signed integers
 		airMipLevel = los.GetInt("airMipLevel", 1);
 		radarMipLevel = los.GetInt("radarMipLevel", 2);
+		losRaycastCache = los.GetBool("raycastCache", losRaycastCache);
 
 		if ((losMipLevel < 0) || (losMipLevel > 6))
 			throw content_error("Sensors\\Los\\LosMipLevel out of bounds. The minimum value is 0. The maximum value is 6.");
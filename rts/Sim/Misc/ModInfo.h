@@ -140,6 +140,8 @@ public:
 	bool alwaysVisibleOverridesCloaked;
 	/// should _all_ allyteams share the same jammermap
 	bool separateJammers;
+	/// share LOS and radar raycast results between instances with identical parameters
+	bool losRaycastCache;
 
 
 	enum {
@@ -159,8 +161,15 @@ public:
 
 	float pfRawDistMult;
 	float pfUpdateRate;
+	/// if true, HAPFS unit path-requests are queued and solved in parallel
+	/// during the next path-manager update instead of immediately
+	bool pfAsyncRequests;
 
 	bool allowTake;
+
+	/// if true, read-only parts of the unit update (e.g. LOS-status recalculation)
+	/// run on the thread-pool and commit their results in deterministic order
+	bool threadedUnitUpdates;
 };
 
 extern CModInfo modInfo;
@@ -29,12 +29,16 @@ CR_REG_METADATA(CQuadField, (
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
 	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempQuads),
+
+	CR_IGNORED(solidsModCount),
+	CR_IGNORED(unitsModCount)
 ))
 
 CR_BIND(CQuadField::Quad, )
 CR_REG_METADATA_SUB(CQuadField, Quad, (
 	CR_MEMBER(units),
+	CR_IGNORED(unitPositions),
 	CR_IGNORED(teamUnits),
 	CR_MEMBER(features),
 	CR_MEMBER(projectiles),
@@ -98,13 +102,47 @@ void CQuadField::Quad::PostLoad()
 {
 #ifndef UNIT_TEST
 	Resize(teamHandler.ActiveAllyTeams());
+	unitPositions.Clear();
 
 	for (CUnit* unit: units) {
+		unitPositions.Push(unit->pos, unit->radius);
 		spring::VectorInsertUnique(teamUnits[unit->allyteam], unit, false);
 	}
 #endif
 }
 
+#ifndef UNIT_TEST
+int CQuadField::Quad::AddUnit(CUnit* unit)
+{
+	spring::VectorInsertUnique(units, unit, false);
+	spring::VectorInsertUnique(teamUnits[unit->allyteam], unit, false);
+	unitPositions.Push(unit->pos, unit->radius);
+	return (units.size() - 1);
+}
+
+void CQuadField::Quad::RemoveUnit(CUnit* unit, int unitIdx, int quadIdx)
+{
+	assert(unsigned(unitIdx) < units.size());
+	assert(units[unitIdx] == unit);
+
+	// swap-with-last, the moved unit's index into this quad has to follow
+	CUnit* lastUnit = units.back();
+
+	units[unitIdx] = lastUnit;
+	units.pop_back();
+	unitPositions.Erase(unitIdx);
+
+	if (lastUnit != unit) {
+		const auto iter = std::find(lastUnit->quads.begin(), lastUnit->quads.end(), quadIdx);
+
+		assert(iter != lastUnit->quads.end());
+		lastUnit->quadUnitIndices[iter - lastUnit->quads.begin()] = unitIdx;
+	}
+
+	spring::VectorErase(teamUnits[unit->allyteam], unit);
+}
+#endif
+
 void CQuadField::Init(int2 mapDims, int quadSize)
 {
 	quadSizeX = quadSize;
@@ -161,10 +199,16 @@ int CQuadField::WorldPosToQuadFieldIdx(const float3 p) const
 
 #ifndef UNIT_TEST
 void CQuadField::GetQuads(QuadFieldQuery& qfq, float3 pos, float radius)
+{
+	qfq.quads = tempQuads.ReserveVector();
+
+	GetQuads(*qfq.quads, pos, radius);
+}
+
+void CQuadField::GetQuads(std::vector<int>& quads, float3 pos, float radius) const
 {
 	pos.AssertNaNs();
 	pos.ClampInBounds();
-	qfq.quads = tempQuads.ReserveVector();
 
 	const int2 min = WorldPosToQuadField(pos - radius);
 	const int2 max = WorldPosToQuadField(pos + radius);
@@ -181,12 +225,10 @@ void CQuadField::GetQuads(QuadFieldQuery& qfq, float3 pos, float radius)
 			assert(z < numQuadsZ);
 			const float3 quadPos = float3(x * quadSizeX + quadSizeX * 0.5f, 0, z * quadSizeZ + quadSizeZ * 0.5f);
 			if (pos.SqDistance2D(quadPos) < maxSqLength) {
-				qfq.quads->push_back(z * numQuadsX + x);
+				quads.push_back(z * numQuadsX + x);
 			}
 		}
 	}
-
-	return;
 }
 
 
@@ -294,35 +336,46 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 #ifndef UNIT_TEST
 void CQuadField::MovedUnit(CUnit* unit)
 {
+	solidsModCount += 1;
+	unitsModCount += 1;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, unit->pos, unit->radius);
 
 	// compare if the quads have changed, if not stop here
 	if (qfQuery.quads->size() == unit->quads.size()) {
 		if (std::equal(qfQuery.quads->begin(), qfQuery.quads->end(), unit->quads.begin())) {
+			MovedUnitPos(unit);
 			return;
 		}
 	}
 
-	for (const int qi: unit->quads) {
-		spring::VectorErase(baseQuads[qi].units, unit);
-		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
-	}
+	UnlinkUnit(unit);
 
 	for (const int qi: *qfQuery.quads) {
-		spring::VectorInsertUnique(baseQuads[qi].units, unit, false);
-		spring::VectorInsertUnique(baseQuads[qi].teamUnits[unit->allyteam], unit, false);
+		unit->quadUnitIndices.push_back(baseQuads[qi].AddUnit(unit));
 	}
 
 	unit->quads = std::move(*qfQuery.quads);
 }
 
-void CQuadField::RemoveUnit(CUnit* unit)
+void CQuadField::MovedUnitPos(const CUnit* unit)
 {
-	for (const int qi: unit->quads) {
-		spring::VectorErase(baseQuads[qi].units, unit);
-		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
+	unitsModCount += 1;
+
+	assert(unit->quads.size() == unit->quadUnitIndices.size());
+
+	for (size_t i = 0, n = unit->quads.size(); i < n; i++) {
+		baseQuads[ unit->quads[i] ].unitPositions.Set(unit->quadUnitIndices[i], unit->pos);
 	}
+}
+
+void CQuadField::RemoveUnit(CUnit* unit)
+{
+	solidsModCount += 1;
+	unitsModCount += 1;
+
+	UnlinkUnit(unit);
 
 	unit->quads.clear();
 
@@ -337,9 +390,21 @@ void CQuadField::RemoveUnit(CUnit* unit)
 	#endif
 }
 
+void CQuadField::UnlinkUnit(CUnit* unit)
+{
+	assert(unit->quads.size() == unit->quadUnitIndices.size());
+
+	for (size_t i = 0, n = unit->quads.size(); i < n; i++) {
+		baseQuads[ unit->quads[i] ].RemoveUnit(unit, unit->quadUnitIndices[i], unit->quads[i]);
+	}
+
+	unit->quadUnitIndices.clear();
+}
 
 void CQuadField::MovedRepulser(CPlasmaRepulser* repulser)
 {
+	solidsModCount += 1;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, repulser->weaponMuzzlePos, repulser->GetRadius());
 
@@ -365,6 +430,8 @@ void CQuadField::MovedRepulser(CPlasmaRepulser* repulser)
 
 void CQuadField::RemoveRepulser(CPlasmaRepulser* repulser)
 {
+	solidsModCount += 1;
+
 	for (const int qi: repulser->GetQuads()) {
 		spring::VectorErase(baseQuads[qi].repulsers, repulser);
 	}
@@ -383,6 +450,8 @@ void CQuadField::RemoveRepulser(CPlasmaRepulser* repulser)
 
 void CQuadField::AddFeature(CFeature* feature)
 {
+	solidsModCount += 1;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, feature->pos, feature->radius);
 
@@ -393,6 +462,8 @@ void CQuadField::AddFeature(CFeature* feature)
 
 void CQuadField::RemoveFeature(CFeature* feature)
 {
+	solidsModCount += 1;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, feature->pos, feature->radius);
 
@@ -490,22 +561,24 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 	qfq.units = tempUnits.ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
-		for (CUnit* u: baseQuads[qi].units) {
-			if (u->tempNum == tempNum)
-				continue;
-
-			u->tempNum = tempNum;
+		const Quad& quad = baseQuads[qi];
 
-			const float totRad       = radius + u->radius;
-			const float totRadSq     = totRad * totRad;
-			const float posUnitDstSq = spherical?
-				pos.SqDistance(u->pos):
-				pos.SqDistance2D(u->pos);
+		// test distances first so only units in range get touched
+		const auto addUnit = [&](size_t i) {
+			CUnit* u = quad.units[i];
 
-			if (posUnitDstSq >= totRadSq)
-				continue;
+			if (u->tempNum == tempNum)
+				return true;
 
+			u->tempNum = tempNum;
 			qfq.units->push_back(u);
+			return true;
+		};
+
+		if (spherical) {
+			quad.unitPositions.ForEachInSphere(pos, radius, addUnit);
+		} else {
+			quad.unitPositions.ForEachInCylinder(pos, radius, addUnit);
 		}
 	}
 
@@ -520,21 +593,18 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 	qfq.units = tempUnits.ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
-		for (CUnit* unit: baseQuads[qi].units) {
+		const Quad& quad = baseQuads[qi];
+
+		quad.unitPositions.ForEachInRectangle(mins, maxs, [&](size_t i) {
+			CUnit* unit = quad.units[i];
 
 			if (unit->tempNum == tempNum)
-				continue;
+				return true;
 
 			unit->tempNum = tempNum;
-
-			const float3& pos = unit->pos;
-			if (pos.x < mins.x || pos.x > maxs.x)
-				continue;
-			if (pos.z < mins.z || pos.z > maxs.z)
-				continue;
-
 			qfq.units->push_back(unit);
-		}
+			return true;
+		});
 	}
 
 	return;
@@ -666,23 +736,26 @@ void CQuadField::GetSolidsExact(
 	qfq.solids = tempSolids.ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
-		for (CUnit* u: baseQuads[qi].units) {
+		const Quad& quad = baseQuads[qi];
+
+		quad.unitPositions.ForEachInSphere(pos, radius, [&](size_t i) {
+			CUnit* u = quad.units[i];
+
 			if (u->tempNum == tempNum)
-				continue;
+				return true;
 
 			u->tempNum = tempNum;
 
 			if (!u->HasPhysicalStateBit(physicalStateBits))
-				continue;
+				return true;
 			if (!u->HasCollidableStateBit(collisionStateBits))
-				continue;
-			if ((pos - u->pos).SqLength() >= Square(radius + u->radius))
-				continue;
+				return true;
 
 			qfq.solids->push_back(u);
-		}
+			return true;
+		});
 
-		for (CFeature* f: baseQuads[qi].features) {
+		for (CFeature* f: quad.features) {
 			if (f->tempNum == tempNum)
 				continue;
 
@@ -714,23 +787,29 @@ bool CQuadField::NoSolidsExact(
 	const int tempNum = gs->GetTempNum();
 
 	for (const int qi: *qfQuery.quads) {
-		for (CUnit* u: baseQuads[qi].units) {
+		const Quad& quad = baseQuads[qi];
+
+		const bool noUnits = quad.unitPositions.ForEachInSphere(pos, radius, [&](size_t i) {
+			CUnit* u = quad.units[i];
+
 			if (u->tempNum == tempNum)
-				continue;
+				return true;
 
 			u->tempNum = tempNum;
 
 			if (!u->HasPhysicalStateBit(physicalStateBits))
-				continue;
+				return true;
 			if (!u->HasCollidableStateBit(collisionStateBits))
-				continue;
-			if ((pos - u->pos).SqLength() >= Square(radius + u->radius))
-				continue;
+				return true;
 
+			// found one, stop
 			return false;
-		}
+		});
 
-		for (CFeature* f: baseQuads[qi].features) {
+		if (!noUnits)
+			return false;
+
+		for (CFeature* f: quad.features) {
 			if (f->tempNum == tempNum)
 				continue;
 
@@ -818,4 +897,73 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 		}
 	}
 }
+
+void CQuadField::GetUnitsAndFeaturesColVolMT(
+	const float3& pos,
+	const float radius,
+	std::vector<int>& tempQuads,
+	std::vector<CUnit*>& units,
+	std::vector<CFeature*>& features,
+	std::vector<CPlasmaRepulser*>* repulsers
+) const {
+	// results are appended, only entries added by this call are checked for duplicates
+	const auto isNewEntry = [](const auto& vec, size_t first, const auto* obj) {
+		return (std::find(vec.begin() + first, vec.end(), obj) == vec.end());
+	};
+
+	tempQuads.clear();
+	GetQuads(tempQuads, pos, radius);
+
+	const size_t firstUnit = units.size();
+	const size_t firstFeature = features.size();
+	const size_t firstRepulser = (repulsers != nullptr)? repulsers->size(): 0;
+
+	// objects can only be seen more than once if the query touches multiple
+	// quads; in that case duplicates are filtered by searching the (small)
+	// result-sets instead of writing to the shared tempNum markers
+	const bool multiQuad = (tempQuads.size() > 1);
+
+	for (const int qi: tempQuads) {
+		const Quad& quad = baseQuads[qi];
+
+		for (CUnit* u: quad.units) {
+			const auto* colvol = &u->collisionVolume;
+			const float totRad = radius + colvol->GetBoundingRadius();
+
+			if (pos.SqDistance(colvol->GetWorldSpacePos(u)) >= (totRad * totRad))
+				continue;
+			if (multiQuad && !isNewEntry(units, firstUnit, u))
+				continue;
+
+			units.push_back(u);
+		}
+
+		for (CFeature* f: quad.features) {
+			const auto* colvol = &f->collisionVolume;
+			const float totRad = radius + colvol->GetBoundingRadius();
+
+			if (pos.SqDistance(colvol->GetWorldSpacePos(f)) >= (totRad * totRad))
+				continue;
+			if (multiQuad && !isNewEntry(features, firstFeature, f))
+				continue;
+
+			features.push_back(f);
+		}
+
+		if (repulsers == nullptr)
+			continue;
+
+		for (CPlasmaRepulser* r: quad.repulsers) {
+			const auto* colvol = &r->collisionVolume;
+			const float totRad = radius + colvol->GetBoundingRadius();
+
+			if (pos.SqDistance(r->weaponMuzzlePos) >= (totRad * totRad))
+				continue;
+			if (multiQuad && !isNewEntry(*repulsers, firstRepulser, r))
+				continue;
+
+			repulsers->push_back(r);
+		}
+	}
+}
 #endif // UNIT_TEST
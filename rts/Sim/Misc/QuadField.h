@@ -12,6 +12,10 @@
 #include "System/float3.h"
 #include "System/type2.h"
 
+#ifndef DEDICATED_NOSSE
+#include <xmmintrin.h>
+#endif
+
 class CUnit;
 class CFeature;
 class CProjectile;
@@ -93,6 +97,7 @@ public:
 	void Kill();
 
 	void GetQuads(QuadFieldQuery& qfq, float3 pos, float radius);
+	void GetQuads(std::vector<int>& quads, float3 pos, float radius) const;
 	void GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, const float3& maxs);
 	void GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const float3& dir, float length);
 
@@ -103,6 +108,20 @@ public:
 		std::vector<CFeature*>& features,
 		std::vector<CPlasmaRepulser*>* repulsers = nullptr
 	);
+	/**
+	 * Same as GetUnitsAndFeaturesColVol (identical results and order), but
+	 * does not touch any shared state so it can be called concurrently from
+	 * multiple threads as long as nothing modifies the field meanwhile
+	 * @c tempQuads is scratch space owned by the calling thread
+	 */
+	void GetUnitsAndFeaturesColVolMT(
+		const float3& pos,
+		const float radius,
+		std::vector<int>& tempQuads,
+		std::vector<CUnit*>& units,
+		std::vector<CFeature*>& features,
+		std::vector<CPlasmaRepulser*>* repulsers = nullptr
+	) const;
 
 	/**
 	 * Returns all units within @c radius of @c pos,
@@ -152,6 +171,10 @@ public:
 
 	void MovedUnit(CUnit* unit);
 	void RemoveUnit(CUnit* unit);
+	/// refreshes the unit's entries in the quads it is part of, does not relink it
+	void MovedUnitPos(const CUnit* unit);
+	/// midPos changed but pos did not (e.g. on rotation); only invalidates cached queries
+	void MovedUnitMidPos() { unitsModCount += 1; }
 
 	void AddFeature(CFeature* feature);
 	void RemoveFeature(CFeature* feature);
@@ -163,12 +186,182 @@ public:
 	void MovedRepulser(CPlasmaRepulser* repulser);
 	void RemoveRepulser(CPlasmaRepulser* repulser);
 
+	/**
+	 * Incremented whenever a unit, feature or repulser is inserted, moved or
+	 * removed, so that cached query results can be checked for staleness
+	 */
+	unsigned int GetSolidsModCount() const { return solidsModCount; }
+	/**
+	 * Incremented whenever a unit is inserted or removed, or its position
+	 * or midPos changes (including changes that do not relink it)
+	 */
+	unsigned int GetUnitsModCount() const { return unitsModCount; }
+
+	/**
+	 * Must be called when the collision-volume of an object changes while
+	 * it stays linked, so cached ColVol query results are not reused
+	 */
+	void ChangedColVol() { solidsModCount += 1; }
+
 	void ReleaseVector(std::vector<CUnit*>* v       ) { tempUnits.ReleaseVector(v); }
 	void ReleaseVector(std::vector<CFeature*>* v    ) { tempFeatures.ReleaseVector(v); }
 	void ReleaseVector(std::vector<CProjectile*>* v ) { tempProjectiles.ReleaseVector(v); }
 	void ReleaseVector(std::vector<CSolidObject*>* v) { tempSolids.ReleaseVector(v); }
 	void ReleaseVector(std::vector<int>* v          ) { tempQuads.ReleaseVector(v); }
 
+	/**
+	 * Structure-of-arrays copy of the positions and radii of the units
+	 * in a quad, stored in the same order as Quad::units so that the
+	 * distance tests done by the Get*Exact queries scan contiguous
+	 * floats instead of dereferencing every CUnit in the quad
+	 * Kept current by MovedUnit, RemoveUnit and MovedUnitPos (the latter
+	 * is called whenever a unit's position changes via CSolidObject::Move)
+	 */
+	struct UnitPositions {
+	public:
+		void Clear() {
+			posX.clear();
+			posY.clear();
+			posZ.clear();
+			radii.clear();
+		}
+		void Push(const float3& pos, float radius) {
+			posX.push_back(pos.x);
+			posY.push_back(pos.y);
+			posZ.push_back(pos.z);
+			radii.push_back(radius);
+		}
+		void Set(size_t i, const float3& pos) {
+			posX[i] = pos.x;
+			posY[i] = pos.y;
+			posZ[i] = pos.z;
+		}
+		// same swap-with-last semantics as spring::VectorErase
+		void Erase(size_t i) {
+			posX[i] = posX.back(); posX.pop_back();
+			posY[i] = posY.back(); posY.pop_back();
+			posZ[i] = posZ.back(); posZ.pop_back();
+			radii[i] = radii.back(); radii.pop_back();
+		}
+
+		size_t Size() const { return posX.size(); }
+
+		// these match the float3-based tests of the Get*Exact queries bit-for-bit
+		bool InSphere(size_t i, const float3& pos, float radius) const {
+			const float dx = pos.x - posX[i];
+			const float dy = pos.y - posY[i];
+			const float dz = pos.z - posZ[i];
+			const float totRad = radius + radii[i];
+			return (!((dx*dx + dy*dy + dz*dz) >= (totRad * totRad)));
+		}
+		bool InCylinder(size_t i, const float3& pos, float radius) const {
+			const float dx = pos.x - posX[i];
+			const float dz = pos.z - posZ[i];
+			const float totRad = radius + radii[i];
+			return (!((dx*dx + dz*dz) >= (totRad * totRad)));
+		}
+		bool InRectangle(size_t i, const float3& mins, const float3& maxs) const {
+			return (!(posX[i] < mins.x || posX[i] > maxs.x || posZ[i] < mins.z || posZ[i] > maxs.z));
+		}
+
+		/**
+		 * Call f(i) in ascending order for every i passing the respective
+		 * In* test, four units at a time; the packed SSE operations are the
+		 * same (and in the same order) as the scalar ones, so the results
+		 * are identical. Iteration stops early when f returns false.
+		 * @return false if stopped by f
+		 */
+		template<typename F> bool ForEachInSphere(const float3& pos, float radius, F&& f) const {
+			#ifndef DEDICATED_NOSSE
+			const __m128 px = _mm_set1_ps(pos.x);
+			const __m128 py = _mm_set1_ps(pos.y);
+			const __m128 pz = _mm_set1_ps(pos.z);
+			const __m128 pr = _mm_set1_ps(radius);
+
+			return (ForEach([&](size_t i) {
+				const __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(&posX[i]));
+				const __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(&posY[i]));
+				const __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(&posZ[i]));
+				const __m128 tr = _mm_add_ps(pr, _mm_loadu_ps(&radii[i]));
+				const __m128 sd = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				return (_mm_movemask_ps(_mm_cmpnge_ps(sd, _mm_mul_ps(tr, tr))));
+			}, [&](size_t i) { return (InSphere(i, pos, radius)); }, f));
+			#else
+			return (ForEach(nullptr, [&](size_t i) { return (InSphere(i, pos, radius)); }, f));
+			#endif
+		}
+		template<typename F> bool ForEachInCylinder(const float3& pos, float radius, F&& f) const {
+			#ifndef DEDICATED_NOSSE
+			const __m128 px = _mm_set1_ps(pos.x);
+			const __m128 pz = _mm_set1_ps(pos.z);
+			const __m128 pr = _mm_set1_ps(radius);
+
+			return (ForEach([&](size_t i) {
+				const __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(&posX[i]));
+				const __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(&posZ[i]));
+				const __m128 tr = _mm_add_ps(pr, _mm_loadu_ps(&radii[i]));
+				const __m128 sd = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+				return (_mm_movemask_ps(_mm_cmpnge_ps(sd, _mm_mul_ps(tr, tr))));
+			}, [&](size_t i) { return (InCylinder(i, pos, radius)); }, f));
+			#else
+			return (ForEach(nullptr, [&](size_t i) { return (InCylinder(i, pos, radius)); }, f));
+			#endif
+		}
+		template<typename F> bool ForEachInRectangle(const float3& mins, const float3& maxs, F&& f) const {
+			#ifndef DEDICATED_NOSSE
+			const __m128 x0 = _mm_set1_ps(mins.x);
+			const __m128 x1 = _mm_set1_ps(maxs.x);
+			const __m128 z0 = _mm_set1_ps(mins.z);
+			const __m128 z1 = _mm_set1_ps(maxs.z);
+
+			return (ForEach([&](size_t i) {
+				const __m128 x = _mm_loadu_ps(&posX[i]);
+				const __m128 z = _mm_loadu_ps(&posZ[i]);
+				const __m128 ox = _mm_or_ps(_mm_cmplt_ps(x, x0), _mm_cmpgt_ps(x, x1));
+				const __m128 oz = _mm_or_ps(_mm_cmplt_ps(z, z0), _mm_cmpgt_ps(z, z1));
+				return ((~_mm_movemask_ps(_mm_or_ps(ox, oz))) & 0xF);
+			}, [&](size_t i) { return (InRectangle(i, mins, maxs)); }, f));
+			#else
+			return (ForEach(nullptr, [&](size_t i) { return (InRectangle(i, mins, maxs)); }, f));
+			#endif
+		}
+
+	private:
+		// blocks of four via maskFunc (bit k set if unit i+k passes), the rest via testFunc
+		template<typename M, typename T, typename F> bool ForEach(M&& maskFunc, T&& testFunc, F&& f) const {
+			const size_t n = posX.size();
+
+			size_t i = 0;
+
+			#ifndef DEDICATED_NOSSE
+			for (; (i + 4) <= n; i += 4) {
+				const int mask = maskFunc(i);
+
+				if (mask == 0)
+					continue;
+
+				for (int k = 0; k < 4; k++) {
+					if ((mask & (1 << k)) != 0 && !f(i + k))
+						return false;
+				}
+			}
+			#endif
+
+			for (; i < n; i++) {
+				if (testFunc(i) && !f(i))
+					return false;
+			}
+
+			return true;
+		}
+
+	private:
+		std::vector<float> posX;
+		std::vector<float> posY;
+		std::vector<float> posZ;
+		std::vector<float> radii;
+	};
+
 	struct Quad {
 	public:
 		CR_DECLARE_STRUCT(Quad)
@@ -180,6 +373,7 @@ public:
 		Quad& operator = (const Quad& q) = delete;
 		Quad& operator = (Quad&& q) {
 			units = std::move(q.units);
+			unitPositions = std::move(q.unitPositions);
 			teamUnits = std::move(q.teamUnits);
 			features = std::move(q.features);
 			projectiles = std::move(q.projectiles);
@@ -189,8 +383,13 @@ public:
 
 		void PostLoad();
 		void Resize(int numAllyTeams) { teamUnits.resize(numAllyTeams); }
+
+		// return / take the unit's position in units, see CUnit::quadUnitIndices
+		int AddUnit(CUnit* unit);
+		void RemoveUnit(CUnit* unit, int unitIdx, int quadIdx);
 		void Clear() {
 			units.clear();
+			unitPositions.Clear();
 			// reuse inner vectors when reloading
 			// teamUnits.clear();
 			for (auto& v: teamUnits) {
@@ -203,6 +402,8 @@ public:
 
 	public:
 		std::vector<CUnit*> units;
+		// parallel to units, see UnitPositions
+		UnitPositions unitPositions;
 		std::vector< std::vector<CUnit*> > teamUnits;
 		std::vector<CFeature*> features;
 		std::vector<CProjectile*> projectiles;
@@ -228,6 +429,9 @@ public:
 	constexpr static unsigned int BASE_QUAD_SIZE = 128;
 
 private:
+	// removes the unit from all its quads, keeps unit->quads
+	void UnlinkUnit(CUnit* unit);
+
 	int2 WorldPosToQuadField(const float3 p) const;
 	int WorldPosToQuadFieldIdx(const float3 p) const;
 
@@ -246,6 +450,9 @@ private:
 
 	int quadSizeX;
 	int quadSizeZ;
+
+	unsigned int solidsModCount = 0;
+	unsigned int unitsModCount = 0;
 };
 
 extern CQuadField quadField;
@@ -169,6 +169,7 @@ void CScriptMoveType::CheckLimits()
 	if (owner->pos.z < mins.z) { owner->pos.z = mins.z; owner->speed.z = 0.0f; }
 	if (owner->pos.z > maxs.z) { owner->pos.z = maxs.z; owner->speed.z = 0.0f; }
 
+	owner->MovedPos();
 	owner->UpdateMidAndAimPos();
 }
 
@@ -74,6 +74,7 @@ CR_REG_METADATA(CSolidObject,
 
 	CR_MEMBER(buildFacing),
 	CR_MEMBER(modParams),
+	CR_MEMBER(modParamSlots),
 
 	CR_POSTLOAD(PostLoad)
 
@@ -110,6 +110,10 @@ public:
 
 	virtual void ForcedMove(const float3& newPos) {}
 	virtual void ForcedSpin(const float3& newDir);
+	/// called after every change of pos, see CQuadField::UnitPositions
+	virtual void MovedPos() {}
+	// called when midPos and aimPos change independently of pos
+	virtual void MovedMidPos() {}
 
 	virtual void UpdatePhysicalState(float eps);
 
@@ -122,6 +126,8 @@ public:
 		pos += dv;
 		midPos += dv;
 		aimPos += dv;
+
+		MovedPos();
 	}
 
 	// this should be called whenever the direction
@@ -130,10 +136,14 @@ public:
 	void UpdateMidAndAimPos() {
 		midPos = GetMidPos();
 		aimPos = GetAimPos();
+
+		MovedMidPos();
 	}
 	void SetMidAndAimPos(const float3& mp, const float3& ap, bool relative) {
 		SetMidPos(mp, relative);
 		SetAimPos(ap, relative);
+
+		MovedMidPos();
 	}
 
 
@@ -412,6 +422,11 @@ public:
 	 * Parameters may or may not have a name.
 	 */
 	LuaRulesParams::Params  modParams;
+	/**
+	 * values of numeric params registered as slots, indexed by slot;
+	 * slots past the end have not been set (see SetUnitRulesParamSlot)
+	 */
+	LuaRulesParams::SlotValues modParamSlots;
 
 public:
 	static constexpr float DEFAULT_MASS = 1e5f;
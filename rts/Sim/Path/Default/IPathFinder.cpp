@@ -158,7 +158,7 @@ IPath::SearchResult IPathFinder::InitSearch(const MoveDef& moveDef, const CPathF
 	int2 square = mStartBlock;
 
 	if (BLOCK_SIZE != 1)
-		square = blockStates.peNodeOffsets[moveDef.pathType][mStartBlockIdx];
+		square = GetBlockSquare(moveDef.pathType, mStartBlockIdx);
 
 	const bool isStartGoal = pfDef.IsGoal(square.x, square.y);
 	const bool startInGoal = pfDef.startInGoalRadius;
@@ -70,6 +70,9 @@ public:
 
 	virtual IPathFinder* GetParent() { return nullptr; }
 
+	/// square (in heightmap coordinates) that searches enter block <blockIdx> through
+	virtual int2 GetBlockSquare(unsigned int pathType, unsigned int blockIdx) const { return (BlockIdxToPos(blockIdx)); }
+
 protected:
 	IPath::SearchResult InitSearch(const MoveDef&, const CPathFinderDef&, const CSolidObject* owner);
 
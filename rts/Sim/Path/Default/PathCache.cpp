@@ -73,23 +73,34 @@ const CPathCache::CacheItem& CPathCache::GetCachedPath(
 	float goalRadius,
 	int pathType
 ) {
-	const std::uint64_t hash = GetHash(strtBlock, goalBlock, goalRadius, pathType);
-	const auto iter = cachedPaths.find(hash);
+	const CacheItem& ci = PeekCachedPath(strtBlock, goalBlock, goalRadius, pathType);
 
-	if (iter == cachedPaths.end()) {
-		++numCacheMisses; return dummyCacheItem;
-	}
-	if ((iter->second).strtBlock != strtBlock) {
-		++numCacheMisses; return dummyCacheItem;
-	}
-	if ((iter->second).goalBlock != goalBlock) {
-		++numCacheMisses; return dummyCacheItem;
-	}
-	if ((iter->second).pathType != pathType) {
-		++numCacheMisses; return dummyCacheItem;
+	if (&ci == &dummyCacheItem) {
+		++numCacheMisses; return ci;
 	}
 
 	++numCacheHits;
+	return ci;
+}
+
+const CPathCache::CacheItem& CPathCache::PeekCachedPath(
+	const int2 strtBlock,
+	const int2 goalBlock,
+	float goalRadius,
+	int pathType
+) const {
+	const std::uint64_t hash = GetHash(strtBlock, goalBlock, goalRadius, pathType);
+	const auto iter = cachedPaths.find(hash);
+
+	if (iter == cachedPaths.end())
+		return dummyCacheItem;
+	if ((iter->second).strtBlock != strtBlock)
+		return dummyCacheItem;
+	if ((iter->second).goalBlock != goalBlock)
+		return dummyCacheItem;
+	if ((iter->second).pathType != pathType)
+		return dummyCacheItem;
+
 	return (iter->second);
 }
 
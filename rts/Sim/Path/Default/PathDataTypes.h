@@ -219,6 +219,26 @@ struct PathNodeStateBuffer {
 		er[synced].y = sz;
 	}
 
+	// makes GetNodeExtraCost return the same values as for <pnsb>,
+	// by pointing our overlays at its overlay or extra-cost vector
+	// (for the latter, the overlay resolution equals br, so lookups
+	// resolve to the same element); must be redone whenever <pnsb>'s
+	// costs are (re)allocated
+	void ShareNodeExtraCosts(const PathNodeStateBuffer& pnsb) {
+		for (const bool synced: {false, true}) {
+			extraCostsOverlay[synced] = pnsb.extraCostsOverlay[synced];
+			er[synced] = pnsb.er[synced];
+
+			if (extraCostsOverlay[synced] != nullptr)
+				continue;
+			if (pnsb.extraCosts[synced].empty())
+				continue;
+
+			extraCostsOverlay[synced] = pnsb.extraCosts[synced].data();
+			er[synced] = pnsb.br;
+		}
+	}
+
 public:
 	std::vector<float> fCost;
 	std::vector<float> gCost;
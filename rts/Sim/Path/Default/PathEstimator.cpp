@@ -2,8 +2,6 @@
 
 #include "System/Platform/Win/win32.h"
 
-#include "minizip/zip.h"
-
 #include "PathEstimator.h"
 #include "PathFinder.h"
 #include "PathFinderDef.h"
@@ -31,6 +29,8 @@
 #include "System/Sync/HsiehHash.h"
 #include "System/Sync/SHA512.hpp"
 
+#include <fstream>
+
 #define ENABLE_NETLOG_CHECKSUM 1
 
 CONFIG(int, PathingThreadCount).defaultValue(0).safemodeValue(1).minimumValue(0);
@@ -44,6 +44,13 @@ static const std::string GetPathCacheDir() {
 	return (FileSystem::GetCacheDir() + "/paths/");
 }
 
+static constexpr char PE_CACHE_FILE_MAGIC[8] = {'S', 'P', 'R', 'I', 'N', 'G', 'P', 'E'};
+
+
+static constexpr std::uint64_t AlignUp(std::uint64_t n, std::uint64_t a) {
+	return (((n + a - 1) / a) * a);
+}
+
 static size_t GetNumThreads() {
 	const size_t numThreads = std::max(0, configHandler->GetInt("PathingThreadCount"));
 	const size_t numCores = Threading::GetLogicalCpuCores();
@@ -79,6 +86,7 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 		maxSpeedMods.resize(moveDefHandler.GetNumMoveDefs(), 0.001f);
 
 		updatedBlocks.clear();
+		priorityBlocks.clear();
 		consumedBlocks.clear();
 		offsetBlocksSortedByCost.clear();
 	}
@@ -132,8 +140,45 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 }
 
 
+void CPathEstimator::InitSearchWorker(const CPathEstimator* source, IPathFinder* pf)
+{
+	IPathFinder::Init(source->BLOCK_SIZE);
+
+	{
+		BLOCKS_TO_UPDATE = 0;
+
+		pathChecksum = source->pathChecksum;
+		fileHashCode = source->fileHashCode;
+
+		parentPathFinder = pf;
+		nextPathEstimator = nullptr;
+
+		pathCache[0] = source->pathCache[0];
+		pathCache[1] = source->pathCache[1];
+
+		sharedData = source;
+		deferredCacheItems = nullptr;
+	}
+	{
+		// searches read these through sharedData
+		vertexCosts.clear();
+		maxSpeedMods.clear();
+
+		updatedBlocks.clear();
+		consumedBlocks.clear();
+		offsetBlocksSortedByCost.clear();
+	}
+}
+
+
 void CPathEstimator::Kill()
 {
+	// caches are owned by the source estimator
+	if (IsSearchWorker())
+		return;
+
+	KillUpdateHelpers();
+
 	pcMemPool.free(pathCache[0]);
 	pcMemPool.free(pathCache[1]);
 }
@@ -157,63 +202,87 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 	// Not much point in multithreading these...
 	InitBlocks();
 
-	if (!ReadFile(cacheFileName, mapName)) {
-		// start extra threads if applicable, but always keep the total
-		// memory-footprint made by CPathFinder instances within bounds
-		const unsigned int minMemFootPrint = sizeof(CPathFinder) + parentPathFinder->GetMemFootPrint();
-		const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint") * 1024 * 1024;
-		const unsigned int numExtraThreads = Clamp(int(maxMemFootPrint / minMemFootPrint) - 1, 0, int(numThreads) - 1);
-		const unsigned int reqMemFootPrint = minMemFootPrint * (numExtraThreads + 1);
+	bool rawFileRead = false;
+	bool zipFileRead = false;
 
-		char calcMsg[512];
-		const char* fmtStrs[4] = {
-			"[%s] creating PE%u cache with %u PF threads (%u MB)",
-			"[%s] creating PE%u cache with %u PF thread (%u MB)",
-			"[%s] writing PE%u cache-file %s-%x",
-			"[%s] written PE%u cache-file %s-%x",
-		};
+	// prefer the raw format, older zip-caches are still accepted (and converted)
+	if (!(rawFileRead = ReadRawFile(cacheFileName, mapName)) && !(zipFileRead = ReadZipFile(cacheFileName, mapName)))
+		CalcBlockData(numThreads);
 
-		{
-			sprintf(calcMsg, fmtStrs[numExtraThreads == 0], __func__, BLOCK_SIZE, numExtraThreads + 1, reqMemFootPrint / (1024 * 1024));
-			loadscreen->SetLoadMessage(calcMsg);
-		}
+	// Calculate PreCached PathData Checksum
+	pathChecksum = CalcChecksum();
 
+	// raw files only get their header checked on reading, the data itself
+	// is validated here (as a side-effect of the checksum calculation)
+	if (rawFileRead && pathChecksum != fileChecksum) {
+		LOG_L(L_WARNING, "[PathEstimator::%s] PE%u cache-file checksum mismatch (%x vs. %x), recalculating", __func__, BLOCK_SIZE, pathChecksum, fileChecksum);
 
-		// note: only really needed if numExtraThreads > 0
-		spring::barrier pathBarrier(numExtraThreads + 1);
+		CalcBlockData(numThreads);
 
-		for (unsigned int i = 1; i <= numExtraThreads; i++) {
-			pathFinders[i] = pfMemPool.alloc<CPathFinder>(true);
-			threads[i] = std::move(spring::thread(&CPathEstimator::CalcOffsetsAndPathCosts, this, i, &pathBarrier));
-		}
+		pathChecksum = CalcChecksum();
+		rawFileRead = false;
+	}
 
-		// Use the current thread as thread zero
-		CalcOffsetsAndPathCosts(0, &pathBarrier);
+	// an old-style zip-cache is only superseded once its raw replacement exists
+	if (!rawFileRead && WriteRawFile(cacheFileName, mapName) && zipFileRead)
+		FileSystem::Remove(GetCacheFileName(cacheFileName, mapName, ".zip"));
 
-		for (unsigned int i = 1; i <= numExtraThreads; i++) {
-			threads[i].join();
-			pfMemPool.free(pathFinders[i]);
+	// switch to runtime wanted IPathFinder (maybe PF or PE)
+	pfMemPool.free(pathFinders[0]);
+	pathFinders[0] = parentPathFinder;
+
+	pathCache[0] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
+	pathCache[1] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
+
+	InitUpdateHelpers();
+}
+
+
+void CPathEstimator::InitUpdateHelpers()
+{
+	CPathEstimator* parentPE = dynamic_cast<CPathEstimator*>(parentPathFinder);
+
+	updateHelpers.clear();
+
+	if (parentPE != nullptr) {
+		// borrow the parent's PF's, estimators are never updated concurrently
+		updateHelpers.reserve(parentPE->updateHelpers.size());
+
+		for (const UpdateHelper& parentHelper: parentPE->updateHelpers) {
+			updateHelpers.push_back({parentHelper.pf, peMemPool.alloc<CPathEstimator>()});
+			updateHelpers.back().pe->InitSearchWorker(parentPE, parentHelper.pf);
 		}
 
+		return;
+	}
 
-		sprintf(calcMsg, fmtStrs[2], __func__, BLOCK_SIZE, cacheFileName.c_str(), fileHashCode);
-		loadscreen->SetLoadMessage(calcMsg, true);
+	// same memory bounds as for the load-time helper threads
+	const unsigned int minMemFootPrint = sizeof(CPathFinder) + parentPathFinder->GetMemFootPrint();
+	const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint") * 1024 * 1024;
+	const unsigned int numHelpers = Clamp(int(maxMemFootPrint / minMemFootPrint), 1, int(std::min(GetNumThreads(), size_t(ThreadPool::GetNumThreads()))));
 
-		WriteFile(cacheFileName, mapName);
+	updateHelpers.reserve(numHelpers);
 
-		sprintf(calcMsg, fmtStrs[3], __func__, BLOCK_SIZE, cacheFileName.c_str(), fileHashCode);
-		loadscreen->SetLoadMessage(calcMsg, true);
+	for (unsigned int i = 0; i < numHelpers; i++) {
+		updateHelpers.push_back({pfMemPool.alloc<CPathFinder>(true), nullptr});
 	}
+}
 
-	// Calculate PreCached PathData Checksum
-	pathChecksum = CalcChecksum();
+void CPathEstimator::KillUpdateHelpers()
+{
+	const bool ownsPFs = (dynamic_cast<CPathEstimator*>(parentPathFinder) == nullptr);
 
-	// switch to runtime wanted IPathFinder (maybe PF or PE)
-	pfMemPool.free(pathFinders[0]);
-	pathFinders[0] = parentPathFinder;
+	for (UpdateHelper& helper: updateHelpers) {
+		if (helper.pe != nullptr) {
+			helper.pe->Kill();
+			peMemPool.free(helper.pe);
+		}
 
-	pathCache[0] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
-	pathCache[1] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
+		if (ownsPFs)
+			pfMemPool.free(helper.pf);
+	}
+
+	updateHelpers.clear();
 }
 
 
@@ -225,6 +294,50 @@ void CPathEstimator::InitBlocks()
 	}
 }
 
+void CPathEstimator::CalcBlockData(unsigned int numThreads)
+{
+	// start extra threads if applicable, but always keep the total
+	// memory-footprint made by CPathFinder instances within bounds
+	const unsigned int minMemFootPrint = sizeof(CPathFinder) + parentPathFinder->GetMemFootPrint();
+	const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint") * 1024 * 1024;
+	const unsigned int numExtraThreads = Clamp(int(maxMemFootPrint / minMemFootPrint) - 1, 0, int(numThreads) - 1);
+	const unsigned int reqMemFootPrint = minMemFootPrint * (numExtraThreads + 1);
+
+	{
+		char calcMsg[512];
+		const char* fmtStrs[2] = {
+			"[%s] creating PE%u cache with %u PF threads (%u MB)",
+			"[%s] creating PE%u cache with %u PF thread (%u MB)",
+		};
+
+		sprintf(calcMsg, fmtStrs[numExtraThreads == 0], __func__, BLOCK_SIZE, numExtraThreads + 1, reqMemFootPrint / (1024 * 1024));
+		loadscreen->SetLoadMessage(calcMsg);
+	}
+
+	offsetBlockNum = {nbrOfBlocks.x * nbrOfBlocks.y};
+	costBlockNum = {nbrOfBlocks.x * nbrOfBlocks.y};
+
+	nextOffsetMessageIdx = 0;
+	nextCostMessageIdx = 0;
+
+
+	// note: only really needed if numExtraThreads > 0
+	spring::barrier pathBarrier(numExtraThreads + 1);
+
+	for (unsigned int i = 1; i <= numExtraThreads; i++) {
+		pathFinders[i] = pfMemPool.alloc<CPathFinder>(true);
+		threads[i] = std::move(spring::thread(&CPathEstimator::CalcOffsetsAndPathCosts, this, i, &pathBarrier));
+	}
+
+	// Use the current thread as thread zero
+	CalcOffsetsAndPathCosts(0, &pathBarrier);
+
+	for (unsigned int i = 1; i <= numExtraThreads; i++) {
+		threads[i].join();
+		pfMemPool.free(pathFinders[i]);
+	}
+}
+
 
 __FORCE_ALIGN_STACK__
 void CPathEstimator::CalcOffsetsAndPathCosts(unsigned int threadNum, spring::barrier* pathBarrier)
@@ -288,7 +401,7 @@ void CPathEstimator::EstimatePathCosts(unsigned int blockIdx, unsigned int threa
 	for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
 		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
 
-		CalcVertexPathCosts(*md, blockPos, threadNum);
+		CalcVertexPathCosts(*md, blockPos, pathFinders[threadNum]);
 	}
 }
 
@@ -356,22 +469,22 @@ int2 CPathEstimator::FindBlockPosOffset(const MoveDef& moveDef, unsigned int blo
 /**
  * Calculate costs of paths to all vertices connected from the given block
  */
-void CPathEstimator::CalcVertexPathCosts(const MoveDef& moveDef, int2 block, unsigned int threadNum)
+void CPathEstimator::CalcVertexPathCosts(const MoveDef& moveDef, int2 block, IPathFinder* pf)
 {
 	// see GetBlockVertexOffset(); costs are bi-directional and only
 	// calculated for *half* the outgoing edges (while costs for the
 	// other four directions are stored at the adjacent vertices)
-	CalcVertexPathCost(moveDef, block, PATHDIR_LEFT,     threadNum);
-	CalcVertexPathCost(moveDef, block, PATHDIR_LEFT_UP,  threadNum);
-	CalcVertexPathCost(moveDef, block, PATHDIR_UP,       threadNum);
-	CalcVertexPathCost(moveDef, block, PATHDIR_RIGHT_UP, threadNum);
+	CalcVertexPathCost(moveDef, block, PATHDIR_LEFT,     pf);
+	CalcVertexPathCost(moveDef, block, PATHDIR_LEFT_UP,  pf);
+	CalcVertexPathCost(moveDef, block, PATHDIR_UP,       pf);
+	CalcVertexPathCost(moveDef, block, PATHDIR_RIGHT_UP, pf);
 }
 
 void CPathEstimator::CalcVertexPathCost(
 	const MoveDef& moveDef,
 	int2 parentBlockPos,
 	unsigned int pathDir,
-	unsigned int threadNum
+	IPathFinder* pf
 ) {
 	const int2 childBlockPos = parentBlockPos + PE_DIRECTION_VECTORS[pathDir];
 
@@ -416,9 +529,8 @@ void CPathEstimator::CalcVertexPathCost(
 	// find path from parent to child block
 	//
 	// since CPathFinder::GetPath() is not thread-safe, use
-	// this thread's "private" CPathFinder instance (rather
-	// than locking parentPathFinder->GetPath()) if we are
-	// invoked in one
+	// the caller's "private" pathfinder instance (rather
+	// than locking parentPathFinder->GetPath())
 	pfDef.skipSubSearches = true;
 	pfDef.testMobile      = false;
 	pfDef.needPath        = false;
@@ -426,7 +538,7 @@ void CPathEstimator::CalcVertexPathCost(
 	pfDef.dirIndependent  = true;
 
 	IPath::Path path;
-	IPath::SearchResult result = pathFinders[threadNum]->GetPath(moveDef, pfDef, nullptr, startPos, path, MAX_SEARCHED_NODES_PF >> 2);
+	IPath::SearchResult result = pf->GetPath(moveDef, pfDef, nullptr, startPos, path, MAX_SEARCHED_NODES_PF >> 2);
 
 	// store the result
 	if (result == IPath::Ok) {
@@ -467,6 +579,29 @@ void CPathEstimator::MapChanged(unsigned int x1, unsigned int z1, unsigned int x
 	}
 }
 
+void CPathEstimator::PrioritizeBlocks(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2)
+{
+	assert(x2 >= x1);
+	assert(z2 >= z1);
+
+	const int lowerX = Clamp(int(x1 / BLOCK_SIZE), 0, int(nbrOfBlocks.x - 1));
+	const int upperX = Clamp(int(x2 / BLOCK_SIZE), 0, int(nbrOfBlocks.x - 1));
+	const int lowerZ = Clamp(int(z1 / BLOCK_SIZE), 0, int(nbrOfBlocks.y - 1));
+	const int upperZ = Clamp(int(z2 / BLOCK_SIZE), 0, int(nbrOfBlocks.y - 1));
+
+	for (int z = lowerZ; z <= upperZ; z++) {
+		for (int x = lowerX; x <= upperX; x++) {
+			const int idx = BlockPosToIdx(int2(x, z));
+
+			// only blocks that are still queued
+			if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0)
+				continue;
+
+			priorityBlocks.push_back(idx);
+		}
+	}
+}
+
 
 /**
  * Update some obsolete blocks using the FIFO-principle
@@ -500,28 +635,15 @@ void CPathEstimator::Update()
 		blockUpdatePenalty += consumeBlocks;
 	}
 
-	if (blocksToUpdate == 0)
-		return;
-
-	if (updatedBlocks.empty())
+	if (blocksToUpdate == 0 || updatedBlocks.empty()) {
+		priorityBlocks.clear();
 		return;
+	}
 
 	consumedBlocks.clear();
 	consumedBlocks.reserve(consumeBlocks);
 
-	// get blocks to update
-	while (!updatedBlocks.empty()) {
-		const int2& pos = updatedBlocks.front();
-		const int idx = BlockPosToIdx(pos);
-
-		if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0) {
-			updatedBlocks.pop_front();
-			continue;
-		}
-
-		if (consumedBlocks.size() >= blocksToUpdate)
-			break;
-
+	const auto ConsumeBlock = [&](const int2 pos, const int idx) {
 		// issue repathing for all active movedefs
 		for (unsigned int i = 0; i < numMoveDefs; i++) {
 			const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
@@ -537,8 +659,43 @@ void CPathEstimator::Update()
 		if (true && nextPathEstimator != nullptr)
 			nextPathEstimator->MapChanged(pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE, pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE);
 
-		updatedBlocks.pop_front(); // must happen _after_ last usage of the `pos` reference!
+		// their FIFO entries are skipped once reached
 		blockStates.nodeMask[idx] &= ~PATHOPT_OBSOLETE;
+	};
+
+	// get prioritized blocks to update, in index order
+	{
+		std::sort(priorityBlocks.begin(), priorityBlocks.end());
+		priorityBlocks.erase(std::unique(priorityBlocks.begin(), priorityBlocks.end()), priorityBlocks.end());
+
+		for (const int idx: priorityBlocks) {
+			if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0)
+				continue;
+
+			if (consumedBlocks.size() >= blocksToUpdate)
+				break;
+
+			ConsumeBlock(BlockIdxToPos(idx), idx);
+		}
+
+		priorityBlocks.clear();
+	}
+
+	// get remaining blocks to update
+	while (!updatedBlocks.empty()) {
+		const int2 pos = updatedBlocks.front();
+		const int idx = BlockPosToIdx(pos);
+
+		if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0) {
+			updatedBlocks.pop_front();
+			continue;
+		}
+
+		if (consumedBlocks.size() >= blocksToUpdate)
+			break;
+
+		ConsumeBlock(pos, idx);
+		updatedBlocks.pop_front();
 	}
 
 	// FindOffset (threadsafe)
@@ -553,23 +710,57 @@ void CPathEstimator::Update()
 		});
 	}
 
-	// CalcVertexPathCosts (not threadsafe)
+	// CalcVertexPathCosts (threadsafe when each helper has its own pathfinder)
 	{
 		SCOPED_TIMER("Sim::Path::Estimator::CalcVertexPathCosts");
-		for (unsigned int n = 0; n < consumedBlocks.size(); ++n) {
-			CalcVertexPathCosts(*consumedBlocks[n].moveDef, consumedBlocks[n].blockPos);
+
+		// the main instances might have (re)allocated their cost-overlays
+		for (UpdateHelper& helper: updateHelpers) {
+			if (helper.pe == nullptr) {
+				helper.pf->GetNodeStateBuffer().ShareNodeExtraCosts(parentPathFinder->GetNodeStateBuffer());
+				continue;
+			}
+
+			helper.pe->GetNodeStateBuffer().ShareNodeExtraCosts(parentPathFinder->GetNodeStateBuffer());
+			helper.pf->GetNodeStateBuffer().ShareNodeExtraCosts(parentPathFinder->GetParent()->GetNodeStateBuffer());
 		}
+
+		// every entry writes a disjoint set of vertexCosts and reads only
+		// data that stays constant during this loop (helper PE's also only
+		// peek at the parent cache), so the results do not depend on which
+		// helper handles which entry or in what order
+		std::atomic<size_t> nextBlockIdx = {0};
+
+		for_mt(0, std::min(updateHelpers.size(), consumedBlocks.size()), [&](const int helperIdx) {
+			IPathFinder* pf = updateHelpers[helperIdx].GetPathFinder();
+
+			for (size_t n = nextBlockIdx++; n < consumedBlocks.size(); n = nextBlockIdx++) {
+				CalcVertexPathCosts(*consumedBlocks[n].moveDef, consumedBlocks[n].blockPos, pf);
+			}
+		});
 	}
 }
 
 
 const CPathCache::CacheItem& CPathEstimator::GetCache(const int2 strtBlock, const int2 goalBlock, float goalRadius, int pathType, const bool synced) const
 {
+	// workers share the cache with other threads, so can not touch its hit-counters
+	if (IsSearchWorker())
+		return pathCache[synced]->PeekCachedPath(strtBlock, goalBlock, goalRadius, pathType);
+
 	return pathCache[synced]->GetCachedPath(strtBlock, goalBlock, goalRadius, pathType);
 }
 
 void CPathEstimator::AddCache(const IPath::Path* path, const IPath::SearchResult result, const int2 strtBlock, const int2 goalBlock, float goalRadius, int pathType, const bool synced)
 {
+	if (IsSearchWorker()) {
+		// {result, path, strtBlock, goalBlock, goalRadius, pathType}
+		if (deferredCacheItems != nullptr)
+			deferredCacheItems->push_back({result, *path, strtBlock, goalBlock, goalRadius, pathType});
+
+		return;
+	}
+
 	pathCache[synced]->AddPath(path, result, strtBlock, goalBlock, goalRadius, pathType);
 }
 
@@ -618,7 +809,7 @@ IPath::SearchResult CPathEstimator::DoSearch(const MoveDef& moveDef, const CPath
 
 	// get the goal square offset
 	const int2 goalSqrOffset = peDef.GoalSquareOffset(BLOCK_SIZE);
-	const float maxSpeedMod = maxSpeedMods[moveDef.pathType];
+	const float maxSpeedMod = sharedData->maxSpeedMods[moveDef.pathType];
 
 	while (!openBlocks.empty() && (openBlockBuffer.GetSize() < maxBlocksToBeSearched)) {
 		// get the open block with lowest cost
@@ -630,7 +821,7 @@ IPath::SearchResult CPathEstimator::DoSearch(const MoveDef& moveDef, const CPath
 			continue;
 
 		// no, check if the goal is already reached
-		const int2 bSquare = blockStates.peNodeOffsets[moveDef.pathType][ob->nodeNum];
+		const int2 bSquare = GetBlockSquare(moveDef.pathType, ob->nodeNum);
 		const int2 gSquare = ob->nodePos * BLOCK_SIZE + goalSqrOffset;
 
 		bool runBlkSearch = false;
@@ -728,15 +919,15 @@ bool CPathEstimator::TestBlock(
 		openBlockIdx * PATH_DIRECTION_VERTICES +
 		GetBlockVertexOffset(pathDir, nbrOfBlocks.x);
 
-	assert(testBlockIdx < blockStates.peNodeOffsets[moveDef.pathType].size());
-	assert(vertexCostIdx < vertexCosts.size());
+	assert(testBlockIdx < sharedData->blockStates.peNodeOffsets[moveDef.pathType].size());
+	assert(vertexCostIdx < sharedData->vertexCosts.size());
 
 	// best accessible heightmap-coordinate within tested block
-	// [DBG] const int2 openBlockSquare = blockStates.peNodeOffsets[moveDef.pathType][openBlockIdx];
-	const int2 testBlockSquare = blockStates.peNodeOffsets[moveDef.pathType][testBlockIdx];
+	// [DBG] const int2 openBlockSquare = GetBlockSquare(moveDef.pathType, openBlockIdx);
+	const int2 testBlockSquare = GetBlockSquare(moveDef.pathType, testBlockIdx);
 
 	// transition-cost from parent to tested child
-	float testVertexCost = vertexCosts[vertexCostIdx];
+	float testVertexCost = sharedData->vertexCosts[vertexCostIdx];
 
 
 	// inf-cost means we can not get from the parent VERTEX to the child
@@ -903,7 +1094,7 @@ void CPathEstimator::FinishSearch(const MoveDef& moveDef, const CPathFinderDef&
 
 		while (true) {
 			// use offset defined by the block
-			const int2 square = blockStates.peNodeOffsets[moveDef.pathType][blockIdx];
+			const int2 square = GetBlockSquare(moveDef.pathType, blockIdx);
 
 			// foundPath.squares.push_back(square);
 			foundPath.path.emplace_back(square.x * SQUARE_SIZE, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE);
@@ -926,15 +1117,88 @@ void CPathEstimator::FinishSearch(const MoveDef& moveDef, const CPathFinderDef&
 }
 
 
+std::string CPathEstimator::GetCacheFileName(const std::string& baseFileName, const std::string& mapName, const char* fileExt) const
+{
+	return (GetPathCacheDir() + mapName + "." + baseFileName + "-" + IntToString(fileHashCode, "%x") + fileExt);
+}
+
+
 /**
- * Try to read offset and vertices data from file, return false on failure
+ * Try to read offset and vertex data from a raw cache-file, return false on failure.
+ * Sections are read straight into their destination buffers (vertexCosts is modified
+ * at runtime, so the file could not be used in place anyway). Only the header is
+ * validated here; the data itself is verified against the stored checksum by
+ * InitEstimator once CalcChecksum has run (which touches every byte anyway).
  */
-bool CPathEstimator::ReadFile(const std::string& baseFileName, const std::string& mapName)
+bool CPathEstimator::ReadRawFile(const std::string& baseFileName, const std::string& mapName)
 {
-	const std::string hashHexString = IntToString(fileHashCode, "%x");
-	const std::string cacheFileName = GetPathCacheDir() + mapName + "." + baseFileName + "-" + hashHexString + ".zip";
+	const std::string cacheFileName = GetCacheFileName(baseFileName, mapName, ".bin");
 
-	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+	LOG("[PathEstimator::%s] hash=%x file=\"%s\" (exists=%d)", __func__, fileHashCode, cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
+
+	std::ifstream ifs(dataDirsAccess.LocateFile(cacheFileName), std::ios::in | std::ios::binary);
+
+	PECacheFileHeader header;
+	PECacheFileHeader expected = MakeCacheFileHeader();
+
+	if (!ifs.is_open() || !ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		ifs.close();
+		FileSystem::Remove(cacheFileName);
+		return false;
+	}
+
+	ifs.seekg(0, std::ios::end);
+
+	const std::uint64_t fileSize = ifs.tellg();
+
+	// everything except the data-checksum has to match exactly
+	expected.dataChecksum = header.dataChecksum;
+
+	if (std::memcmp(&header, &expected, sizeof(header)) != 0 || fileSize < header.fileSize) {
+		LOG_L(L_WARNING, "[PathEstimator::%s] discarding stale or truncated PE%u cache-file (version=%u hash=%x)", __func__, BLOCK_SIZE, header.version, header.hashCode);
+
+		ifs.close();
+		FileSystem::Remove(cacheFileName);
+		return false;
+	}
+
+	char calcMsg[512];
+	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
+	loadscreen->SetLoadMessage(calcMsg);
+
+	ifs.seekg(header.offsetsOffset);
+
+	for (unsigned int pathType = 0; pathType < header.numPathTypes; ++pathType) {
+		ifs.read(reinterpret_cast<char*>(blockStates.peNodeOffsets[pathType].data()), header.offsetsStride);
+	}
+
+	ifs.seekg(header.costsOffset);
+	ifs.read(reinterpret_cast<char*>(vertexCosts.data()), header.costsStride * header.numPathTypes);
+
+	if (ifs.fail()) {
+		LOG_L(L_WARNING, "[PathEstimator::%s] failed to read PE%u cache-file", __func__, BLOCK_SIZE);
+
+		ifs.close();
+		FileSystem::Remove(cacheFileName);
+		return false;
+	}
+
+	fileChecksum = header.dataChecksum;
+	return true;
+}
+
+
+/**
+ * Try to read offset and vertex data from an old-style (zipped) cache-file, return false on failure
+ */
+bool CPathEstimator::ReadZipFile(const std::string& baseFileName, const std::string& mapName)
+{
+	const std::string cacheFileName = GetCacheFileName(baseFileName, mapName, ".zip");
+
+	LOG("[PathEstimator::%s] hash=%x file=\"%s\" (exists=%d)", __func__, fileHashCode, cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
 	if (!FileSystem::FileExists(cacheFileName))
 		return false;
@@ -956,9 +1220,6 @@ bool CPathEstimator::ReadFile(const std::string& baseFileName, const std::string
 		return false;
 	}
 
-	// pointless; gets reassigned the output of CalcChecksum and CRC is not otherwise used
-	// pathChecksum = upfile->GetCrc32(fid);
-
 	std::vector<std::uint8_t> buffer;
 
 	if (!upfile->GetFile(fid, buffer) || buffer.size() < 4) {
@@ -998,53 +1259,88 @@ bool CPathEstimator::ReadFile(const std::string& baseFileName, const std::string
 
 
 /**
- * Try to write offset and vertex data to file.
+ * Try to write offset and vertex data to a raw cache-file, return false on failure.
  */
-void CPathEstimator::WriteFile(const std::string& baseFileName, const std::string& mapName)
+bool CPathEstimator::WriteRawFile(const std::string& baseFileName, const std::string& mapName)
 {
 	// we need this directory to exist
 	if (!FileSystem::CreateDirectory(GetPathCacheDir()))
-		return;
+		return false;
+
+	const std::string cacheFileName = GetCacheFileName(baseFileName, mapName, ".bin");
+
+	char calcMsg[512];
+	sprintf(calcMsg, "[%s] writing PE%u cache-file %s-%x", __func__, BLOCK_SIZE, baseFileName.c_str(), fileHashCode);
+	loadscreen->SetLoadMessage(calcMsg, true);
 
-	const std::string hashHexString = IntToString(fileHashCode, "%x");
-	const std::string cacheFileName = GetPathCacheDir() + mapName + "." + baseFileName + "-" + hashHexString + ".zip";
+	LOG("[PathEstimator::%s] hash=%x file=\"%s\" (exists=%d)", __func__, fileHashCode, cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
-	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+	PECacheFileHeader header = MakeCacheFileHeader();
+	header.dataChecksum = pathChecksum;
 
 	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
+	std::ofstream ofs(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE), std::ios::out | std::ios::binary | std::ios::trunc);
 
-	if (file == nullptr)
-		return;
+	if (!ofs.is_open())
+		return false;
 
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
+	const auto WritePadding = [&](std::uint64_t sectionOffset) {
+		for (std::uint64_t pos = ofs.tellp(); pos < sectionOffset; pos++) {
+			ofs.put(0);
+		}
+	};
 
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
 	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
+	WritePadding(header.offsetsOffset);
+
+	for (const auto& pathTypeOffsets: blockStates.peNodeOffsets) {
+		ofs.write(reinterpret_cast<const char*>(pathTypeOffsets.data()), header.offsetsStride);
 	}
 
 	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
+	WritePadding(header.costsOffset);
+	ofs.write(reinterpret_cast<const char*>(vertexCosts.data()), header.costsStride * header.numPathTypes);
+	ofs.close();
 
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
-
-
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
-
-	if (upfile == nullptr || !upfile->IsOpen()) {
+	if (ofs.fail()) {
 		FileSystem::Remove(cacheFileName);
-		return;
+		return false;
 	}
 
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
-	// pointless; gets reassigned the output of CalcChecksum and CRC is not otherwise used
-	// pathChecksum = upfile->GetCrc32(upfile->FindFile("pathinfo"));
+	sprintf(calcMsg, "[%s] written PE%u cache-file %s-%x", __func__, BLOCK_SIZE, baseFileName.c_str(), fileHashCode);
+	loadscreen->SetLoadMessage(calcMsg, true);
+	return true;
+}
+
+
+CPathEstimator::PECacheFileHeader CPathEstimator::MakeCacheFileHeader() const
+{
+	PECacheFileHeader header;
+
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, PE_CACHE_FILE_MAGIC, sizeof(header.magic));
+
+	header.version = PATHESTIMATOR_VERSION;
+	header.hashCode = fileHashCode;
+	header.mapChecksum = mapChecksum;
+	header.modChecksum = modChecksum;
+
+	header.blockSize = BLOCK_SIZE;
+	header.numBlocksX = nbrOfBlocks.x;
+	header.numBlocksZ = nbrOfBlocks.y;
+	header.numPathTypes = moveDefHandler.GetNumMoveDefs();
+	header.pageSize = PE_CACHE_FILE_ALIGN;
+
+	// each section starts on a page boundary so it can be mapped or read directly
+	header.offsetsOffset = AlignUp(sizeof(header), PE_CACHE_FILE_ALIGN);
+	header.offsetsStride = blockStates.GetSize() * sizeof(short2);
+	header.costsOffset = AlignUp(header.offsetsOffset + header.offsetsStride * header.numPathTypes, PE_CACHE_FILE_ALIGN);
+	header.costsStride = (vertexCosts.size() / std::max(1u, header.numPathTypes)) * sizeof(float);
+	header.fileSize = header.costsOffset + header.costsStride * header.numPathTypes;
+
+	return header;
 }
 
 
@@ -1094,7 +1390,7 @@ std::uint32_t CPathEstimator::CalcChecksum() const
 /**
  * Returns a hash-code identifying the dataset of this estimator.
  */
-std::uint32_t CPathEstimator::CalcHash(const char* caller) const
+std::uint32_t CPathEstimator::CalcHash(const char* caller)
 {
 	const unsigned int hmChecksum = readMap->CalcHeightmapChecksum();
 	const unsigned int tmChecksum = readMap->CalcTypemapChecksum();
@@ -1110,5 +1406,8 @@ std::uint32_t CPathEstimator::CalcHash(const char* caller) const
 	LOG("[PathEstimator::%s][%s] blockMapChecksum=%x", __func__, caller, bmChecksum);
 	LOG("[PathEstimator::%s][%s] estimatorHashCode=%x", __func__, caller, peHashCode);
 
+	mapChecksum = hmChecksum + tmChecksum;
+	modChecksum = mdChecksum;
+
 	return peHashCode;
 }
@@ -41,6 +41,17 @@ public:
 	 *   Ex. PE-name "pe" + Mapname "Desert" => "Desert.pe"
 	 */
 	void Init(IPathFinder*, unsigned int BSIZE, const std::string& cacheFileName, const std::string& mapFileName);
+	/**
+	 * Sets this estimator up as a search-only copy of <source>, sharing
+	 * its block offsets, vertex costs and path-cache but with its own
+	 * search state s.t. both can run GetPath concurrently. Cache entries
+	 * found by such a worker are not added directly, but stored in the
+	 * list pointed to by <deferredCacheItems> when that is non-null.
+	 *
+	 * @param pf
+	 *   The (equally private) pathfinder used for block sub-searches.
+	 */
+	void InitSearchWorker(const CPathEstimator* source, IPathFinder* pf);
 	void Kill();
 
 
@@ -52,12 +63,22 @@ public:
 	 */
 	void MapChanged(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2);
 
+	/**
+	 * Lets the obsolete blocks overlapping the rectangular area (x1, z1)-(x2, z2)
+	 * skip ahead of the FIFO update-queue during the next Update, e.g. because
+	 * paths are about to be searched from there.
+	 */
+	void PrioritizeBlocks(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2);
+
 	/**
 	 * called every frame
 	 */
 	void Update();
 
 	IPathFinder* GetParent() override { return parentPathFinder; }
+	int2 GetBlockSquare(unsigned int pathType, unsigned int blockIdx) const final {
+		return (sharedData->blockStates.peNodeOffsets[pathType][blockIdx]);
+	}
 
 	/**
 	 * Returns a checksum that can be used to check if every player has the same
@@ -107,20 +128,57 @@ protected: // IPathFinder impl
 private:
 	void InitEstimator(const std::string& cacheFileName, const std::string& mapName);
 	void InitBlocks();
+	void CalcBlockData(unsigned int numThreads);
+	void InitUpdateHelpers();
+	void KillUpdateHelpers();
 
 	void CalcOffsetsAndPathCosts(unsigned int threadNum, spring::barrier* pathBarrier);
 	void CalculateBlockOffsets(unsigned int, unsigned int);
 	void EstimatePathCosts(unsigned int, unsigned int);
 
 	int2 FindBlockPosOffset(const MoveDef&, unsigned int, unsigned int) const;
-	void CalcVertexPathCosts(const MoveDef&, int2, unsigned int threadNum = 0);
-	void CalcVertexPathCost(const MoveDef&, int2, unsigned int pathDir, unsigned int threadNum = 0);
+	void CalcVertexPathCosts(const MoveDef&, int2, IPathFinder* pf);
+	void CalcVertexPathCost(const MoveDef&, int2, unsigned int pathDir, IPathFinder* pf);
+
+	bool IsSearchWorker() const { return (sharedData != this); }
 
-	bool ReadFile(const std::string& baseFileName, const std::string& mapName);
-	void WriteFile(const std::string& baseFileName, const std::string& mapName);
+	std::string GetCacheFileName(const std::string& baseFileName, const std::string& mapName, const char* fileExt) const;
+
+	bool ReadRawFile(const std::string& baseFileName, const std::string& mapName);
+	bool ReadZipFile(const std::string& baseFileName, const std::string& mapName);
+	bool WriteRawFile(const std::string& baseFileName, const std::string& mapName);
 
 	std::uint32_t CalcChecksum() const;
-	std::uint32_t CalcHash(const char* caller) const;
+	std::uint32_t CalcHash(const char* caller);
+
+private:
+	static constexpr std::uint32_t PE_CACHE_FILE_ALIGN = 4096;
+
+	// raw cache-file layout: header, per-pathtype offsets, per-pathtype vertex-costs
+	struct PECacheFileHeader {
+		char magic[8];
+
+		std::uint32_t version;
+		std::uint32_t hashCode;
+		std::uint32_t mapChecksum;
+		std::uint32_t modChecksum;
+
+		std::uint32_t blockSize;
+		std::uint32_t numBlocksX;
+		std::uint32_t numBlocksZ;
+		std::uint32_t numPathTypes;
+
+		std::uint32_t dataChecksum;
+		std::uint32_t pageSize;
+
+		std::uint64_t offsetsOffset;
+		std::uint64_t offsetsStride;
+		std::uint64_t costsOffset;
+		std::uint64_t costsStride;
+		std::uint64_t fileSize;
+	};
+
+	PECacheFileHeader MakeCacheFileHeader() const;
 
 private:
 	friend class CPathManager;
@@ -135,6 +193,12 @@ private:
 
 	std::uint32_t pathChecksum = 0;
 	std::uint32_t fileHashCode = 0;
+	/// expected pathChecksum of the data read from a raw cache-file
+	std::uint32_t fileChecksum = 0;
+
+	// components of fileHashCode, stored in raw cache-files
+	std::uint32_t mapChecksum = 0;
+	std::uint32_t modChecksum = 0;
 
 	std::atomic<std::int64_t> offsetBlockNum = {0};
 	std::atomic<std::int64_t> costBlockNum = {0};
@@ -143,13 +207,29 @@ private:
 	CPathEstimator* nextPathEstimator; // next lower-resolution estimator
 	CPathCache* pathCache[2]; // [0] = !synced, [1] = synced
 
+	// owner of the precalculated data (this, unless a search-worker)
+	const CPathEstimator* sharedData = this;
+	std::vector<CPathCache::CacheItem>* deferredCacheItems = nullptr;
+
 	std::vector<IPathFinder*> pathFinders; // InitEstimator helpers
 	std::vector<spring::thread> threads;
 
+	struct UpdateHelper {
+		IPathFinder* GetPathFinder() { return ((pe != nullptr)? pe: pf); }
+
+		IPathFinder* pf;
+		CPathEstimator* pe; // search-worker of parentPathFinder if that is a PE, otherwise null
+	};
+
+	// Update helpers, each can recalculate vertex costs independently
+	std::vector<UpdateHelper> updateHelpers;
+
 	std::vector<float> maxSpeedMods;
 	std::vector<float> vertexCosts;
 	/// blocks that may need an update due to map changes
 	std::deque<int2> updatedBlocks;
+	/// indices of updatedBlocks entries to process first
+	std::vector<int> priorityBlocks;
 
 	struct SOffsetBlock {
 		float cost;
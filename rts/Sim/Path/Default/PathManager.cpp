@@ -12,9 +12,14 @@
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Objects/SolidObject.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/TimeProfiler.h"
 
+#include <algorithm>
+#include <atomic>
+
 
 static CPathFinder    gMaxResPF;
 static CPathEstimator gMedResPE;
@@ -28,6 +33,7 @@ CPathManager::CPathManager()
 , pathFlowMap(nullptr)
 , pathHeatMap(nullptr)
 , nextPathID(0)
+, numSolvedRequests(0)
 {
 	IPathFinder::InitStatic();
 	CPathFinder::InitStatic();
@@ -46,6 +52,8 @@ CPathManager::~CPathManager()
 {
 	// Finalize is not called in case of forced exit
 	if (maxResPF != nullptr) {
+		KillSearchWorkers();
+
 		lowResPE->Kill();
 		medResPE->Kill();
 		maxResPF->Kill();
@@ -77,6 +85,9 @@ std::int64_t CPathManager::Finalize() {
 		// any client has a corrupted or incorrect cache it desyncs from
 		// the start, not minutes later
 		{ SyncedUint tmp(GetPathCheckSum()); }
+
+		if (modInfo.pfAsyncRequests)
+			InitSearchWorkers();
 	}
 
 	const spring_time dt = spring_gettime() - t0;
@@ -84,6 +95,51 @@ std::int64_t CPathManager::Finalize() {
 }
 
 
+void CPathManager::InitSearchWorkers()
+{
+	// keep the total memory-footprint of all worker instances within the
+	// same bounds as the PE's use for their (load-time) helper-threads
+	const unsigned int minMemFootPrint =
+		sizeof(CPathFinder) + maxResPF->GetMemFootPrint() +
+		sizeof(CPathEstimator) * 2 + medResPE->GetMemFootPrint() + lowResPE->GetMemFootPrint();
+	const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint") * 1024 * 1024;
+	const unsigned int numWorkers = Clamp(int(maxMemFootPrint / minMemFootPrint), 1, ThreadPool::GetNumThreads());
+
+	searchWorkers.clear();
+	searchWorkers.reserve(numWorkers);
+
+	for (unsigned int i = 0; i < numWorkers; i++) {
+		PathSearchSet pss;
+
+		pss.maxResPF = pfMemPool.alloc<CPathFinder>(true);
+		pss.medResPE = peMemPool.alloc<CPathEstimator>();
+		pss.lowResPE = peMemPool.alloc<CPathEstimator>();
+
+		pss.medResPE->InitSearchWorker(medResPE, pss.maxResPF);
+		pss.lowResPE->InitSearchWorker(lowResPE, pss.medResPE);
+
+		searchWorkers.push_back(pss);
+	}
+
+	LOG("[PathManager::%s] %u search-workers (%u KB each)", __func__, numWorkers, minMemFootPrint / 1024);
+}
+
+void CPathManager::KillSearchWorkers()
+{
+	for (PathSearchSet& pss: searchWorkers) {
+		pss.lowResPE->Kill();
+		pss.medResPE->Kill();
+
+		peMemPool.free(pss.lowResPE);
+		peMemPool.free(pss.medResPE);
+		pfMemPool.free(pss.maxResPF);
+	}
+
+	searchWorkers.clear();
+	pathRequests.clear();
+}
+
+
 void CPathManager::FinalizePath(MultiPath* path, const float3 startPos, const float3 goalPos, const bool cantGetCloser)
 {
 	IPath::Path* sp = &path->lowResPath;
@@ -122,6 +178,7 @@ void CPathManager::FinalizePath(MultiPath* path, const float3 startPos, const fl
 
 
 IPath::SearchResult CPathManager::ArrangePath(
+	const PathSearchSet& pss,
 	MultiPath* newPath,
 	const MoveDef* moveDef,
 	const float3& startPos,
@@ -150,7 +207,7 @@ IPath::SearchResult CPathManager::ArrangePath(
 	constexpr bool useConstraints[] = {false, false, false};
 	constexpr bool allowRawSearch[] = {false, false, false};
 
-	IPathFinder* pathFinders[] = {lowResPE, medResPE, maxResPF};
+	IPathFinder* pathFinders[] = {pss.lowResPE, pss.medResPE, pss.maxResPF};
 	IPath::Path* pathObjects[] = {&newPath->lowResPath, &newPath->medResPath, &newPath->maxResPath};
 
 	IPath::SearchResult bestResult = IPath::Error;
@@ -364,23 +421,74 @@ unsigned int CPathManager::RequestPath(
 	goalRadius = std::max<float>(goalRadius, PATH_NODE_SPACING * SQUARE_SIZE); //FIXME do on a per PE & PF level?
 	assert(moveDef == moveDefHandler.GetMoveDefByPathType(moveDef->pathType));
 
+	if (synced) {
+		// searches start here, so any stale costs around startPos should be
+		// recalculated first (also the queued case, which waits for Update)
+		const int sx = startPos.x / SQUARE_SIZE;
+		const int sz = startPos.z / SQUARE_SIZE;
+		const int sr = MAXRES_SEARCH_DISTANCE;
+
+		medResPE->PrioritizeBlocks(std::max(0, sx - sr), std::max(0, sz - sr), sx + sr, sz + sr);
+		lowResPE->PrioritizeBlocks(std::max(0, sx - sr), std::max(0, sz - sr), sx + sr, sz + sr);
+	}
+
 	MultiPath newPath = MultiPath(moveDef, startPos, goalPos, goalRadius);
 	newPath.finalGoal = goalPos;
 	newPath.caller = caller;
 	newPath.peDef.synced = synced;
 
+	// solved by the search-workers during the next Update; requests without
+	// a caller (Lua, AI) keep getting their result immediately since those
+	// expect to be able to read the waypoints right away
+	if (synced && caller != nullptr && !searchWorkers.empty())
+		return (QueuePath(newPath, goalRadius));
+
 	if (caller != nullptr)
 		caller->UnBlock();
 
-	const IPath::SearchResult result = ArrangePath(&newPath, moveDef, startPos, goalPos, caller);
+	const IPath::SearchResult result = SolvePath(GetMainSearchSet(), newPath, startPos, goalPos, caller);
 
 	unsigned int pathID = 0;
 
+	if (result != IPath::Error)
+		pathID = Store(newPath);
+
+	if (caller != nullptr)
+		caller->Block();
+
+	return pathID;
+}
+
+unsigned int CPathManager::QueuePath(MultiPath& path, float goalRadius)
+{
+	// stands in for the real path until it has been solved
+	MultiPath tempPath = MultiPath(path.moveDef, path.start, path.finalGoal, goalRadius);
+	tempPath.finalGoal = path.finalGoal;
+	tempPath.caller = path.caller;
+	tempPath.peDef.synced = path.peDef.synced;
+	tempPath.queued = true;
+
+	const unsigned int pathID = Store(tempPath);
+
+	pathRequests.emplace_back(pathID, std::move(path));
+	return pathID;
+}
+
+IPath::SearchResult CPathManager::SolvePath(
+	const PathSearchSet& pss,
+	MultiPath& newPath,
+	const float3& startPos,
+	const float3& goalPos,
+	CSolidObject* caller
+) const {
+	const bool synced = newPath.peDef.synced;
+	const IPath::SearchResult result = ArrangePath(pss, &newPath, newPath.moveDef, startPos, goalPos, caller);
+
 	if (result != IPath::Error) {
 		if (newPath.maxResPath.path.empty()) {
 			if (result != IPath::CantGetCloser) {
-				LowRes2MedRes(newPath, startPos, caller, synced);
-				MedRes2MaxRes(newPath, startPos, caller, synced);
+				LowRes2MedRes(pss, newPath, startPos, caller, synced);
+				MedRes2MaxRes(pss, newPath, startPos, caller, synced);
 			} else {
 				// add one dummy waypoint so that the calling MoveType
 				// does not consider this request a failure, which can
@@ -396,18 +504,81 @@ unsigned int CPathManager::RequestPath(
 
 		FinalizePath(&newPath, startPos, goalPos, result == IPath::CantGetCloser);
 		newPath.searchResult = result;
-		pathID = Store(newPath);
 	}
 
-	if (caller != nullptr)
-		caller->Block();
+	return result;
+}
 
-	return pathID;
+void CPathManager::SolvePathRequests()
+{
+	numSolvedRequests = 0;
+
+	if (pathRequests.empty())
+		return;
+
+	SCOPED_TIMER("Sim::Path::Requests");
+
+	// skip requests whose path was deleted before it could be solved
+	const auto isDeleted = [&](const PathRequest& pr) { return (pathMap.find(pr.pathID) == pathMap.end()); };
+	pathRequests.erase(std::remove_if(pathRequests.begin(), pathRequests.end(), isDeleted), pathRequests.end());
+
+	// main instances might have (re)allocated their cost-overlays since last time
+	for (PathSearchSet& pss: searchWorkers) {
+		pss.maxResPF->GetNodeStateBuffer().ShareNodeExtraCosts(maxResPF->GetNodeStateBuffer());
+		pss.medResPE->GetNodeStateBuffer().ShareNodeExtraCosts(medResPE->GetNodeStateBuffer());
+		pss.lowResPE->GetNodeStateBuffer().ShareNodeExtraCosts(lowResPE->GetNodeStateBuffer());
+	}
+
+	{
+		// every search only reads shared state (the main PE caches included)
+		// and writes into its own request, so the outcome does not depend on
+		// which worker picks up which request
+		// no UnBlock is needed either, the thread-safe block-check always
+		// ignores the caller
+		std::atomic<size_t> nextRequestIdx = {0};
+
+		for_mt(0, std::min(searchWorkers.size(), pathRequests.size()), [&](const int workerIdx) {
+			const PathSearchSet& pss = searchWorkers[workerIdx];
+
+			for (size_t i = nextRequestIdx++; i < pathRequests.size(); i = nextRequestIdx++) {
+				PathRequest& pr = pathRequests[i];
+				MultiPath& mp = pr.path;
+
+				pss.medResPE->deferredCacheItems = &pr.cacheItems[0];
+				pss.lowResPE->deferredCacheItems = &pr.cacheItems[1];
+
+				SolvePath(pss, mp, mp.start, mp.finalGoal, mp.caller);
+			}
+
+			pss.medResPE->deferredCacheItems = nullptr;
+			pss.lowResPE->deferredCacheItems = nullptr;
+		});
+	}
+
+	// commit in request order
+	for (PathRequest& pr: pathRequests) {
+		for (const CPathCache::CacheItem& ci: pr.cacheItems[0]) {
+			medResPE->AddCache(&ci.path, ci.result, ci.strtBlock, ci.goalBlock, ci.goalRadius, ci.pathType, true);
+		}
+		for (const CPathCache::CacheItem& ci: pr.cacheItems[1]) {
+			lowResPE->AddCache(&ci.path, ci.result, ci.strtBlock, ci.goalBlock, ci.goalRadius, ci.pathType, true);
+		}
+
+		// a failed search leaves no path, NextWayPoint then tells the caller
+		if (pr.path.searchResult == IPath::Error) {
+			DeletePath(pr.pathID);
+		} else {
+			pathMap[pr.pathID] = std::move(pr.path);
+		}
+	}
+
+	numSolvedRequests = pathRequests.size();
+	pathRequests.clear();
 }
 
 
 // converts part of a med-res path into a max-res path
-void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
+void CPathManager::MedRes2MaxRes(const PathSearchSet& pss, MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
 {
 	assert(IsFinalized());
 
@@ -440,7 +611,7 @@ void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, c
 	// Perform the search.
 	// If this is the final improvement of the path, then use the original goal.
 	const auto& pfd = (medResPath.path.empty() && lowResPath.path.empty()) ? multiPath.peDef : rangedGoalDef;
-	const IPath::SearchResult result = maxResPF->GetPath(*multiPath.moveDef, pfd, owner, startPos, maxResPath, MAX_SEARCHED_NODES_ON_REFINE);
+	const IPath::SearchResult result = pss.maxResPF->GetPath(*multiPath.moveDef, pfd, owner, startPos, maxResPath, MAX_SEARCHED_NODES_ON_REFINE);
 
 	// If no refined path could be found, set goal as desired goal.
 	if (result == IPath::CantGetCloser || result == IPath::Error) {
@@ -449,7 +620,7 @@ void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, c
 }
 
 // converts part of a low-res path into a med-res path
-void CPathManager::LowRes2MedRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
+void CPathManager::LowRes2MedRes(const PathSearchSet& pss, MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
 {
 	assert(IsFinalized());
 
@@ -479,7 +650,7 @@ void CPathManager::LowRes2MedRes(MultiPath& multiPath, const float3& startPos, c
 	// Perform the search.
 	// If there is no low-res path left, use original goal.
 	const auto& pfd = (lowResPath.path.empty()) ? multiPath.peDef : rangedGoalDef;
-	const IPath::SearchResult result = medResPE->GetPath(*multiPath.moveDef, pfd, owner, startPos, medResPath, MAX_SEARCHED_NODES_ON_REFINE);
+	const IPath::SearchResult result = pss.medResPE->GetPath(*multiPath.moveDef, pfd, owner, startPos, medResPath, MAX_SEARCHED_NODES_ON_REFINE);
 
 	// If no refined path could be found, set goal as desired goal.
 	if (result == IPath::CantGetCloser || result == IPath::Error) {
@@ -517,6 +688,14 @@ float3 CPathManager::NextWayPoint(
 	if (multiPath == nullptr)
 		return noPathPoint;
 
+	if (multiPath->queued) {
+		// request has not been solved yet; set the caller off toward its
+		// goal (but only a short distance, s.t. it asks again soon) with
+		// y=-1 to mark this as a temporary waypoint, as QTPFS does
+		const float3 goalDir = (multiPath->finalGoal - callerPos).SafeNormalize() * SQUARE_SIZE;
+		return (float3(callerPos.x + goalDir.x, -1.0f, callerPos.z + goalDir.z));
+	}
+
 	if (numRetries > MAX_PATH_REFINEMENT_DEPTH)
 		return (multiPath->finalGoal);
 
@@ -542,9 +721,9 @@ float3 CPathManager::NextWayPoint(
 			multiPath->caller->UnBlock();
 
 		if (extendMedResPath)
-			LowRes2MedRes(*multiPath, callerPos, owner, synced);
+			LowRes2MedRes(GetMainSearchSet(), *multiPath, callerPos, owner, synced);
 
-		MedRes2MaxRes(*multiPath, callerPos, owner, synced);
+		MedRes2MaxRes(GetMainSearchSet(), *multiPath, callerPos, owner, synced);
 
 		if (multiPath->caller != nullptr)
 			multiPath->caller->Block();
@@ -586,7 +765,6 @@ float3 CPathManager::NextWayPoint(
 	} while ((callerPos.SqDistance2D(waypoint) < Square(radius)) && (waypoint != maxResPath.pathGoal));
 
 	// y=0 indicates this is not a temporary waypoint
-	// (the default PFS does not queue path-requests)
 	return (waypoint * XZVector);
 }
 
@@ -617,6 +795,8 @@ void CPathManager::Update()
 
 	medResPE->Update();
 	lowResPE->Update();
+
+	SolvePathRequests();
 }
 
 // used to deposit heat on the heat-map as a unit moves along its path
@@ -4,9 +4,11 @@
 #define PATHMANAGER_H
 
 #include <cinttypes>
+#include <vector>
 
 #include "Sim/Path/IPathManager.h"
 #include "IPath.h"
+#include "PathCache.h"
 #include "PathFinderDef.h"
 #include "System/UnorderedMap.hpp"
 
@@ -21,13 +23,14 @@ struct MoveDef;
 class CPathManager: public IPathManager {
 public:
 	struct MultiPath {
-		MultiPath(): moveDef(nullptr), caller(nullptr) {}
+		MultiPath(): moveDef(nullptr), caller(nullptr), queued(false) {}
 		MultiPath(const MoveDef* moveDef, const float3& startPos, const float3& goalPos, float goalRadius)
 			: searchResult(IPath::Error)
 			, start(startPos)
 			, peDef(startPos, goalPos, goalRadius, 3.0f, 2000)
 			, moveDef(moveDef)
 			, caller(nullptr)
+			, queued(false)
 		{}
 
 		MultiPath(const MultiPath& mp) = delete;
@@ -47,6 +50,7 @@ public:
 			peDef   = mp.peDef;
 			moveDef = mp.moveDef;
 			caller  = mp.caller;
+			queued  = mp.queued;
 
 			mp.moveDef = nullptr;
 			mp.caller  = nullptr;
@@ -70,6 +74,30 @@ public:
 
 		// additional information
 		CSolidObject* caller;
+
+		// true while this is a placeholder for a not yet solved request
+		bool queued;
+	};
+
+	// request deferred to the next Update, solved by one of the search-workers
+	struct PathRequest {
+		PathRequest(unsigned int id, MultiPath&& mp): path(std::move(mp)), pathID(id) {}
+
+		MultiPath path;
+
+		unsigned int pathID;
+
+		// PE cache additions ([0] = med-res, [1] = low-res) made while
+		// solving, applied to the shared caches in request order
+		std::vector<CPathCache::CacheItem> cacheItems[2];
+	};
+
+	// set of instances that can run a (multi-resolution) search
+	// independently of any other set
+	struct PathSearchSet {
+		CPathFinder* maxResPF;
+		CPathEstimator* medResPE;
+		CPathEstimator* lowResPE;
 	};
 
 public:
@@ -143,6 +171,7 @@ public:
 	const float* GetNodeExtraCosts(bool) const override;
 
 	int2 GetNumQueuedUpdates() const override;
+	int2 GetNumQueuedRequests() const override { return {int(pathRequests.size()), numSolvedRequests}; }
 
 
 	const CPathFinder* GetMaxResPF() const { return maxResPF; }
@@ -156,6 +185,7 @@ public:
 
 private:
 	IPath::SearchResult ArrangePath(
+		const PathSearchSet& pss,
 		MultiPath* newPath,
 		const MoveDef* moveDef,
 		const float3& startPos,
@@ -177,14 +207,29 @@ private:
 		return nextPathID;
 	}
 
+	unsigned int QueuePath(MultiPath& path, float goalRadius);
+
+	IPath::SearchResult SolvePath(
+		const PathSearchSet& pss,
+		MultiPath& newPath,
+		const float3& startPos,
+		const float3& goalPos,
+		CSolidObject* caller
+	) const;
+	void SolvePathRequests();
 
 	static void FinalizePath(MultiPath* path, const float3 startPos, const float3 goalPos, const bool cantGetCloser);
 
-	void LowRes2MedRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
-	void MedRes2MaxRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
+	void LowRes2MedRes(const PathSearchSet& pss, MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
+	void MedRes2MaxRes(const PathSearchSet& pss, MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
+
+	void InitSearchWorkers();
+	void KillSearchWorkers();
 
 	bool IsFinalized() const { return (maxResPF != nullptr); }
 
+	PathSearchSet GetMainSearchSet() const { return {maxResPF, medResPE, lowResPE}; }
+
 private:
 	CPathFinder* maxResPF;
 	CPathEstimator* medResPE;
@@ -195,7 +240,11 @@ private:
 
 	spring::unordered_map<unsigned int, MultiPath> pathMap;
 
+	std::vector<PathRequest> pathRequests;
+	std::vector<PathSearchSet> searchWorkers;
+
 	unsigned int nextPathID;
+	int numSolvedRequests;
 };
 
 #endif
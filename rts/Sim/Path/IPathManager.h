@@ -169,6 +169,8 @@ public:
 	virtual const float* GetNodeExtraCosts(bool synced) const { return nullptr; }
 
 	virtual int2 GetNumQueuedUpdates() const { return (int2(0, 0)); }
+	/// {number of requests waiting to be solved, number solved during the last Update}
+	virtual int2 GetNumQueuedRequests() const { return (int2(0, 0)); }
 };
 
 extern IPathManager* pathManager;
@@ -5,7 +5,6 @@
 
 #include <array>
 #include <vector>
-#include <fstream>
 #include <cinttypes>
 
 #include "PathEnums.hpp"
@@ -22,6 +21,19 @@
 
 namespace QTPFS {
 	struct NodeLayer;
+
+	// pointer-free node representation used by the tree cache-files; the
+	// four children of a node are stored contiguously and childBaseIndex
+	// refers to the first of them (-1u for leafs)
+	struct SerialNode {
+		std::uint32_t nodeNumber;
+		std::uint32_t childBaseIndex;
+
+		float speedModAvg;
+		float speedModSum;
+		float moveCostAvg;
+	};
+
 	struct INode {
 	public:
 		void SetNodeNumber(unsigned int n) { nodeNumber = n; }
@@ -37,7 +49,6 @@ namespace QTPFS {
 		bool operator >= (const INode* n) const { return (fCost >= n->fCost); }
 
 		#ifdef QTPFS_VIRTUAL_NODE_FUNCTIONS
-		virtual void Serialize(std::fstream&, NodeLayer&, unsigned int*, unsigned int, bool) = 0;
 		virtual unsigned int GetNeighbors(const std::vector<INode*>&, std::vector<INode*>&) = 0;
 		virtual const std::vector<INode*>& GetNeighbors(const std::vector<INode*>& v) = 0;
 		virtual bool UpdateNeighborCache(const std::vector<INode*>& nodes) = 0;
@@ -135,7 +146,15 @@ namespace QTPFS {
 
 		void PreTesselate(NodeLayer& nl, const SRectangle& r, SRectangle& ur, unsigned int depth);
 		void Tesselate(NodeLayer& nl, const SRectangle& r, unsigned int depth);
-		void Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, unsigned int depth, bool readMode);
+
+		SerialNode GetSerialNode(unsigned int serialChildBaseIndex) const {
+			return {nodeNumber, serialChildBaseIndex, speedModAvg, speedModSum, moveCostAvg};
+		}
+		void SetSerialNode(const SerialNode& sn) {
+			speedModAvg = sn.speedModAvg;
+			speedModSum = sn.speedModSum;
+			moveCostAvg = sn.moveCostAvg;
+		}
 
 		bool IsLeaf() const { return (childBaseIndex == -1u); }
 		bool CanSplit(unsigned int depth, bool forced) const;
@@ -32,6 +32,90 @@ void QTPFS::NodeLayer::RegisterNode(INode* n) {
 	}
 }
 
+void QTPFS::NodeLayer::FlattenTree(const QTNode* root, std::vector<SerialNode>& serialNodes) const {
+	std::vector<const QTNode*> nodes;
+
+	nodes.reserve(numLeafNodes + numLeafNodes / 3 + 1);
+	nodes.push_back(root);
+
+	serialNodes.clear();
+	serialNodes.reserve(nodes.capacity());
+
+	// children are appended as soon as their parent is visited, so they
+	// always end up as a contiguous run of QTNODE_CHILD_COUNT entries
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const QTNode* n = nodes[i];
+
+		if (n->IsLeaf()) {
+			serialNodes.push_back(n->GetSerialNode(-1u));
+			continue;
+		}
+
+		serialNodes.push_back(n->GetSerialNode(nodes.size()));
+
+		for (unsigned int j = 0; j < QTNODE_CHILD_COUNT; j++) {
+			nodes.push_back(GetPoolNode(n->GetChildBaseIndex() + j));
+		}
+	}
+}
+
+bool QTPFS::NodeLayer::UnflattenTree(QTNode* root, const SerialNode* serialNodes, unsigned int numSerialNodes) {
+	assert(root->IsLeaf());
+
+	if (numSerialNodes == 0 || numSerialNodes > (POOL_TOTAL_SIZE + 1))
+		return false;
+
+	{
+		// validate the layout up-front so a malformed tree is never half-built;
+		// the children of the k-th internal node must start at index 1 + 4k
+		unsigned int nextChildBaseIndex = 1;
+
+		for (unsigned int i = 0; i < numSerialNodes; i++) {
+			if (serialNodes[i].childBaseIndex == -1u)
+				continue;
+			if (serialNodes[i].childBaseIndex != nextChildBaseIndex)
+				return false;
+
+			nextChildBaseIndex += QTNODE_CHILD_COUNT;
+		}
+
+		if (nextChildBaseIndex != numSerialNodes)
+			return false;
+	}
+
+	std::vector<QTNode*> nodes(numSerialNodes, nullptr);
+
+	nodes[0] = root;
+
+	for (unsigned int i = 0; i < numSerialNodes; i++) {
+		QTNode* n = nodes[i];
+		const SerialNode& sn = serialNodes[i];
+
+		if (n->GetNodeNumber() != sn.nodeNumber)
+			return false;
+
+		n->SetSerialNode(sn);
+
+		if (sn.childBaseIndex == -1u) {
+			// node was a leaf in an earlier life, register it
+			RegisterNode(n);
+			continue;
+		}
+
+		// re-create child nodes
+		if (!n->Split(*this, 0, true))
+			return false;
+
+		for (unsigned int j = 0; j < QTNODE_CHILD_COUNT; j++) {
+			nodes[sn.childBaseIndex + j] = GetPoolNode(n->GetChildBaseIndex() + j);
+		}
+	}
+
+	return true;
+}
+
+
+
 void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 	assert((QTPFS::NodeLayer::NUM_SPEEDMOD_BINS + 1) <= MaxSpeedBinTypeValue());
 
@@ -96,6 +96,10 @@ namespace QTPFS {
 
 		void FreePoolNode(unsigned int nodeIndex) { nodeIndcs.push_back(nodeIndex); }
 
+		// convert the tree below <root> to and from its (breadth-first) flat representation
+		void FlattenTree(const QTNode* root, std::vector<SerialNode>& serialNodes) const;
+		bool UnflattenTree(QTNode* root, const SerialNode* serialNodes, unsigned int numSerialNodes);
+
 
 		const std::vector<SpeedBinType>& GetOldSpeedBins() const { return oldSpeedBins; }
 		const std::vector<SpeedBinType>& GetCurSpeedBins() const { return curSpeedBins; }
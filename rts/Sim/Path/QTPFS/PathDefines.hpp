@@ -10,6 +10,7 @@
 #define QTPFS_SMOOTH_PATHS
 // #define QTPFS_CONSERVATIVE_NODE_SPLITS
 // #define QTPFS_DEBUG_NODE_HEAP
+// #define QTPFS_CHECK_SERIALIZED_TREES
 #define QTPFS_CORNER_CONNECTED_NODES
 // #define QTPFS_SLOW_ACCURATE_TESSELATION
 // #define QTPFS_OPENMP_ENABLED
@@ -27,7 +28,7 @@
 #define QTPFS_MAX_NETPOINTS_PER_NODE_EDGE 3
 #define QTPFS_NETPOINT_EDGE_SPACING_SCALE (1.0f / (QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + 1))
 
-#define QTPFS_CACHE_VERSION 16
+#define QTPFS_CACHE_VERSION 17
 #define QTPFS_CACHE_XACCESS
 
 #define QTPFS_POSITIVE_INFINITY (std::numeric_limits<float>::infinity())
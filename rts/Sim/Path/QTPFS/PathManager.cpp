@@ -2,6 +2,8 @@
 
 #include <chrono>
 #include <cinttypes>
+#include <cstring>
+#include <fstream>
 #include <functional>
 
 #include "System/Threading/ThreadPool.h"
@@ -21,11 +23,13 @@
 #include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/ArchiveScanner.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/MappedFile.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Threading.h"
 #include "System/Rectangle.h"
 #include "System/TimeProfiler.h"
 #include "System/StringUtil.h"
+#include "System/Sync/HsiehHash.h"
 
 #ifdef GetTempPath
 #undef GetTempPath
@@ -105,6 +109,20 @@ namespace QTPFS {
 		return ((numThreads == 0)? numCores: numThreads);
 	}
 
+	static constexpr char QTPFS_TREE_FILE_MAGIC[8] = {'Q', 'T', 'P', 'F', 'S', 'N', 'T', '\0'};
+
+	// tree cache-files consist of this header followed by numNodes SerialNode's
+	struct NodeTreeFileHeader {
+		char magic[8];
+
+		std::uint32_t version;
+		std::uint32_t xsize;
+		std::uint32_t zsize;
+		std::uint32_t numNodes;
+		std::uint32_t numLeafNodes;
+		std::uint32_t dataCheckSum;
+	};
+
 	unsigned int PathManager::LAYERS_PER_UPDATE;
 	unsigned int PathManager::MAX_TEAM_SEARCHES;
 
@@ -145,8 +163,9 @@ QTPFS::PathManager::~PathManager() {
 	pathTypes.clear();
 	pathTraces.clear();
 
-	numCurrExecutedSearches.clear();
-	numPrevExecutedSearches.clear();
+	searchStates.clear();
+
+	numQueuedSearches.clear();
 
 	PathSearch::FreeGlobalQueue();
 
@@ -185,8 +204,6 @@ void QTPFS::PathManager::InitStatic() {
 }
 
 void QTPFS::PathManager::Load() {
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
@@ -195,10 +212,11 @@ void QTPFS::PathManager::Load() {
 	nodeLayers.resize(moveDefHandler.GetNumMoveDefs());
 	pathCaches.resize(moveDefHandler.GetNumMoveDefs());
 	pathSearches.resize(moveDefHandler.GetNumMoveDefs());
+	searchStates.clear();
+	searchStates.resize(moveDefHandler.GetNumMoveDefs());
 
 	// add one extra element for object-less requests
-	numCurrExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
-	numPrevExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
+	numQueuedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
 
 	{
 		const sha512::raw_digest& mapCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(gameSetup->mapName);
@@ -549,8 +567,8 @@ std::string QTPFS::PathManager::GetCacheDirName(const std::string& mapCheckSumHe
 
 void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
 	std::vector<std::string> fileNames(nodeTrees.size(), "");
-	std::vector<std::fstream*> fileStreams(nodeTrees.size(), nullptr);
 	std::vector<unsigned int> fileSizes(nodeTrees.size(), 0);
+	std::vector<SerialNode> serialNodes;
 
 	if (!haveCacheDir) {
 		FileSystem::CreateDirectory(cacheFileDir);
@@ -562,12 +580,15 @@ void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
 	const char* fmtString = "[PathManager::%s] serializing node-tree %u (%s)";
 	#endif
 
-	// TODO: compress the tree cache-files?
 	for (unsigned int i = 0; i < nodeTrees.size(); i++) {
 		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
 
 		fileNames[i] = cacheFileDir + "tree" + IntToString(i, "%02x") + "-" + md->name;
-		fileStreams[i] = new std::fstream();
+
+		#ifndef NDEBUG
+		sprintf(loadMsg, fmtString, __func__, i, md->name.c_str());
+		pmLoadScreen.AddMessage(loadMsg);
+		#endif
 
 		if (haveCacheDir) {
 			#ifdef QTPFS_CACHE_XACCESS
@@ -582,9 +603,9 @@ void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
 					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
 				}
 
-				fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::in | std::ios::binary);
-				fileStreams[i]->read(reinterpret_cast<char*>(&fileSizes[i]), sizeof(unsigned int));
-				fileStreams[i]->close();
+				std::fstream fileStream((fileNames[i] + "-tmp").c_str(), std::ios::in | std::ios::binary);
+				fileStream.read(reinterpret_cast<char*>(&fileSizes[i]), sizeof(unsigned int));
+				fileStream.close();
 
 				while (!FileSystem::FileExists(fileNames[i])) {
 					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -593,42 +614,120 @@ void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
 					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
 				}
 			}
-
-			#else
-			assert(FileSystem::FileExists(fileNames[i]));
 			#endif
 
 			// read fileNames[i] into nodeTrees[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::in | std::ios::binary);
-			assert(fileStreams[i]->good());
-			assert(nodeTrees[i]->IsLeaf());
-		} else {
-			// write nodeTrees[i] into fileNames[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::out | std::ios::binary);
-		}
+			if (ReadNodeTree(i, fileNames[i]))
+				continue;
 
-		#ifndef NDEBUG
-		sprintf(loadMsg, fmtString, __func__, i, md->name.c_str());
-		pmLoadScreen.AddMessage(loadMsg);
-		#endif
+			LOG_L(L_WARNING, "[PathManager::%s] invalid cache-file \"%s\", re-tesselating node-tree %u", __func__, fileNames[i].c_str(), i);
 
-		nodeTrees[i]->Serialize(*fileStreams[i], nodeLayers[i], &fileSizes[i], 0, haveCacheDir);
+			// ReadNodeTree may have failed after (partially) unflattening the
+			// tree, so start over from a fresh root; this resets the layer's
+			// node-pool and leaf-count but keeps its speed-bins, which still
+			// all differ from their initial values
+			InitNodeLayer(i, MAP_RECTANGLE);
 
-		fileStreams[i]->flush();
-		fileStreams[i]->close();
+			SRectangle ur = MAP_RECTANGLE;
+			nodeTrees[i]->PreTesselate(nodeLayers[i], MAP_RECTANGLE, ur, 0);
+		}
+
+		// write nodeTrees[i] into fileNames[i]
+		fileSizes[i] = WriteNodeTree(i, fileNames[i], serialNodes);
 
 		#ifdef QTPFS_CACHE_XACCESS
 		if (!haveCacheDir) {
 			// signal any other (concurrently loading) Spring processes; needed for validation-tests
-			fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::out | std::ios::binary);
-			fileStreams[i]->write(reinterpret_cast<const char*>(&fileSizes[i]), sizeof(unsigned int));
-			fileStreams[i]->flush();
-			fileStreams[i]->close();
+			std::fstream fileStream((fileNames[i] + "-tmp").c_str(), std::ios::out | std::ios::binary);
+			fileStream.write(reinterpret_cast<const char*>(&fileSizes[i]), sizeof(unsigned int));
+			fileStream.flush();
+			fileStream.close();
 		}
 		#endif
+	}
+}
+
+unsigned int QTPFS::PathManager::WriteNodeTree(unsigned int layerNum, const std::string& fileName, std::vector<SerialNode>& serialNodes) {
+	const NodeLayer& nodeLayer = nodeLayers[layerNum];
+
+	nodeLayer.FlattenTree(nodeTrees[layerNum], serialNodes);
 
-		delete fileStreams[i];
+	NodeTreeFileHeader header;
+
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, QTPFS_TREE_FILE_MAGIC, sizeof(header.magic));
+
+	header.version = QTPFS_CACHE_VERSION;
+	header.xsize = mapDims.mapx;
+	header.zsize = mapDims.mapy;
+	header.numNodes = serialNodes.size();
+	header.numLeafNodes = nodeLayer.GetNumLeafNodes();
+	header.dataCheckSum = HsiehHash(serialNodes.data(), serialNodes.size() * sizeof(SerialNode), 0);
+
+	std::fstream fileStream(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	// one contiguous blob: header followed by the flattened tree
+	fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fileStream.write(reinterpret_cast<const char*>(serialNodes.data()), serialNodes.size() * sizeof(SerialNode));
+	fileStream.flush();
+	fileStream.close();
+
+	#ifdef QTPFS_CHECK_SERIALIZED_TREES
+	{
+		// round-trip the tree through a scratch layer and compare both
+		NodeLayer tmpLayer;
+		QTNode* tmpTree = nullptr;
+
+		std::vector<SerialNode> tmpNodes;
+
+		tmpLayer.Init(layerNum);
+		tmpLayer.RegisterNode(tmpTree = tmpLayer.AllocRootNode(nullptr, 0,  0, 0,  mapDims.mapx, mapDims.mapy));
+		tmpLayer.UnflattenTree(tmpTree, serialNodes.data(), serialNodes.size());
+		tmpLayer.FlattenTree(tmpTree, tmpNodes);
+
+		const std::uint64_t srcMem = nodeLayer.GetMemFootPrint() + nodeTrees[layerNum]->GetMemFootPrint(nodeLayer);
+		const std::uint64_t dstMem = tmpLayer.GetMemFootPrint() + tmpTree->GetMemFootPrint(tmpLayer);
+
+		const bool equalNodes = (tmpNodes.size() == serialNodes.size()) && (std::memcmp(tmpNodes.data(), serialNodes.data(), tmpNodes.size() * sizeof(SerialNode)) == 0);
+		const bool equalLeafs = (tmpLayer.GetNumLeafNodes() == nodeLayer.GetNumLeafNodes());
+
+		LOG("[PathManager::%s] node-tree %u round-trip: nodes=%u leafs=%u equal=%d mem-footprint=%lu/%lu KB (before/after)", __func__,
+			layerNum, header.numNodes, header.numLeafNodes, (equalNodes && equalLeafs), (unsigned long) (srcMem / 1024), (unsigned long) (dstMem / 1024));
+
+		assert(equalNodes && equalLeafs);
 	}
+	#endif
+
+	return (sizeof(header) + serialNodes.size() * sizeof(SerialNode));
+}
+
+bool QTPFS::PathManager::ReadNodeTree(unsigned int layerNum, const std::string& fileName) {
+	CMappedFile mappedFile(fileName);
+
+	if (!mappedFile.IsOpen() || mappedFile.GetSize() < sizeof(NodeTreeFileHeader))
+		return false;
+
+	NodeTreeFileHeader header;
+	std::memcpy(&header, mappedFile.GetData(), sizeof(header));
+
+	if (std::memcmp(header.magic, QTPFS_TREE_FILE_MAGIC, sizeof(header.magic)) != 0)
+		return false;
+	if (header.version != QTPFS_CACHE_VERSION)
+		return false;
+	if (header.xsize != mapDims.mapx || header.zsize != mapDims.mapy)
+		return false;
+	if (mappedFile.GetSize() != (sizeof(header) + header.numNodes * sizeof(SerialNode)))
+		return false;
+
+	// the node data is used in-place from the mapping
+	const SerialNode* serialNodes = reinterpret_cast<const SerialNode*>(mappedFile.GetData() + sizeof(header));
+
+	if (HsiehHash(serialNodes, header.numNodes * sizeof(SerialNode), 0) != header.dataCheckSum)
+		return false;
+	if (!nodeLayers[layerNum].UnflattenTree(nodeTrees[layerNum], serialNodes, header.numNodes))
+		return false;
+
+	return (nodeLayers[layerNum].GetNumLeafNodes() == header.numLeafNodes);
 }
 
 
@@ -710,22 +809,36 @@ void QTPFS::PathManager::ThreadUpdate() {
 		static unsigned int minPathTypeUpdate = 0;
 		static unsigned int maxPathTypeUpdate = numPathTypeUpdates;
 
-		sharedPaths.clear();
-
+		#ifndef QTPFS_IGNORE_DEAD_PATHS
+		// touches the (shared) path-type map, not done concurrently
 		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
-			#ifndef QTPFS_IGNORE_DEAD_PATHS
 			QueueDeadPathSearches(pathTypeUpdate);
-			#endif
+		}
+		#endif
 
+		const auto UpdatePathType = [&](unsigned int pathTypeUpdate) {
 			#ifdef QTPFS_STAGGERED_LAYER_UPDATES
 			// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
-			ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
+			ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty() || !searchStates[pathTypeUpdate].deferredSearches.empty());
 			#endif
 
 			ExecuteQueuedSearches(pathTypeUpdate);
-		}
+		};
+
+		// the per-team search limit is shared by all types of an update,
+		// so apply it up-front
+		PartitionTeamSearches(minPathTypeUpdate, maxPathTypeUpdate);
+
+		// each path-type only touches its own layer, cache and search-state
+		// here, so the types are processed in parallel; their searches still
+		// execute in the same (queue) order as when done serially
+		for_mt(minPathTypeUpdate, maxPathTypeUpdate, [&](const int pathTypeUpdate) {
+			UpdatePathType(pathTypeUpdate);
+		});
 
-		std::copy(numCurrExecutedSearches.begin(), numCurrExecutedSearches.end(), numPrevExecutedSearches.begin());
+		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+			FinishQueuedSearches(pathTypeUpdate);
+		}
 
 		minPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
 		maxPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
@@ -747,29 +860,83 @@ void QTPFS::PathManager::ThreadUpdate() {
 
 
 
+void QTPFS::PathManager::PartitionTeamSearches(unsigned int minPathType, unsigned int maxPathType) {
+	#ifdef QTPFS_LIMIT_TEAM_SEARCHES
+	std::fill(numQueuedSearches.begin(), numQueuedSearches.end(), 0);
+
+	// admit at most MAX_TEAM_SEARCHES of each team's searches in type- and
+	// queue-order, the rest wait for the next update; this is an upper bound
+	// since some searches will be satisfied by shared paths instead
+	for (unsigned int pathType = minPathType; pathType < maxPathType; pathType++) {
+		PathCache& pathCache = pathCaches[pathType];
+		PathSearchVect& searches = pathSearches[pathType];
+		PathSearchVect& deferredSearches = searchStates[pathType].deferredSearches;
+
+		size_t numSearches = 0;
+
+		for (IPathSearch* search: searches) {
+			// already deleted searches are only discarded, these do not count
+			if (pathCache.GetTempPath(search->GetID())->GetID() == 0 || (numQueuedSearches[search->GetTeam()] += 1) <= MAX_TEAM_SEARCHES) {
+				searches[numSearches++] = search;
+			} else {
+				deferredSearches.push_back(search);
+			}
+		}
+
+		searches.resize(numSearches);
+	}
+	#endif
+}
+
 void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	NodeLayer& nodeLayer = nodeLayers[pathType];
 	PathCache& pathCache = pathCaches[pathType];
+	PathTypeSearchState& searchState = searchStates[pathType];
 
 	std::vector<IPathSearch*>& searches = pathSearches[pathType];
 	std::vector<IPathSearch*>::iterator searchesIt = searches.begin();
 
+	searchState.sharedPaths.clear();
+
 	if (!searches.empty()) {
 		// execute pending searches collected via
 		// RequestPath and QueueDeadPathSearches
 		while (searchesIt != searches.end()) {
-			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
+			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, searchState, pathType)) {
+				searchState.searchStateOffset += NODE_STATE_OFFSET;
 			}
 		}
 	}
 }
 
+void QTPFS::PathManager::FinishQueuedSearches(unsigned int pathType) {
+	PathTypeSearchState& searchState = searchStates[pathType];
+
+	#ifdef QTPFS_TRACE_PATH_SEARCHES
+	for (const auto& pathTrace: searchState.pathTraces) {
+		pathTraces[pathTrace.first] = pathTrace.second;
+	}
+
+	searchState.pathTraces.clear();
+	#endif
+
+	for (const unsigned int pathID: searchState.deletedPaths) {
+		DeletePath(pathID);
+	}
+
+	searchState.deletedPaths.clear();
+
+	// searches deferred by PartitionTeamSearches go first next update
+	pathSearches[pathType].insert(pathSearches[pathType].begin(), searchState.deferredSearches.begin(), searchState.deferredSearches.end());
+	searchState.deferredSearches.clear();
+}
+
 bool QTPFS::PathManager::ExecuteSearch(
 	PathSearchVect& searches,
 	PathSearchVectIt& searchesIt,
 	NodeLayer& nodeLayer,
 	PathCache& pathCache,
+	PathTypeSearchState& searchState,
 	unsigned int pathType
 ) {
 	IPathSearch* search = *searchesIt;
@@ -800,41 +967,32 @@ bool QTPFS::PathManager::ExecuteSearch(
 
 	{
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+		SharedPathMap::const_iterator sharedPathsIt = searchState.sharedPaths.find(path->GetHash());
 
-		if (sharedPathsIt != sharedPaths.end()) {
+		if (sharedPathsIt != searchState.sharedPaths.end()) {
 			if (search->SharedFinalize(sharedPathsIt->second, path)) {
 				DeleteSearch(search, searches, searchesIt);
 				return false;
 			}
 		}
 		#endif
-
-		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
-		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
-		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
-
-		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
-			++searchesIt; return false;
-		}
-
-		numCurrExecutedSearches[search->GetTeam()] += 1;
-		#endif
 	}
 
 	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
+	if (search->Execute(searchState.searchStateOffset, numTerrainChanges)) {
 		search->Finalize(path);
 
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
+		searchState.sharedPaths[path->GetHash()] = path;
 		#endif
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
+		searchState.pathTraces.emplace_back(path->GetID(), search->GetExecutionTrace());
 		#endif
 	} else {
-		DeletePath(path->GetID());
+		// the path itself can be released right away, the ID-mapping is shared
+		pathCache.DelPath(path->GetID());
+		searchState.deletedPaths.push_back(path->GetID());
 	}
 
 	DeleteSearch(search, searches, searchesIt);
@@ -99,6 +99,25 @@ namespace QTPFS {
 		typedef std::vector<IPathSearch*> PathSearchVect;
 		typedef std::vector<IPathSearch*>::iterator PathSearchVectIt;
 
+		// everything the searches of a single path-type modify outside of
+		// that type's layer and cache; lets ExecuteQueuedSearches process
+		// different types concurrently
+		struct PathTypeSearchState {
+			// maps "hashes" of executed searches to the found paths
+			SharedPathMap sharedPaths;
+
+			// IDs of paths whose search failed, deleted after all types ran
+			std::vector<unsigned int> deletedPaths;
+			// searches over their team's limit, queued again after all types ran
+			std::vector<IPathSearch*> deferredSearches;
+
+			#ifdef QTPFS_TRACE_PATH_SEARCHES
+			std::vector< std::pair<unsigned int, PathSearchTrace::Execution*> > pathTraces;
+			#endif
+
+			unsigned int searchStateOffset = NODE_STATE_OFFSET;
+		};
+
 		void SpawnSpringThreads(MemberFunc f, const SRectangle& r);
 
 		void InitNodeLayersThreaded(const SRectangle& rect);
@@ -121,7 +140,9 @@ namespace QTPFS {
 		void ExecQueuedNodeLayerUpdates(unsigned int layerNum, bool flushQueue);
 		#endif
 
+		void PartitionTeamSearches(unsigned int minPathType, unsigned int maxPathType);
 		void ExecuteQueuedSearches(unsigned int pathType);
+		void FinishQueuedSearches(unsigned int pathType);
 		void QueueDeadPathSearches(unsigned int pathType);
 
 		unsigned int QueueSearch(
@@ -139,6 +160,7 @@ namespace QTPFS {
 			PathSearchVectIt& searchesIt,
 			NodeLayer& nodeLayer,
 			PathCache& pathCache,
+			PathTypeSearchState& searchState,
 			unsigned int pathType
 		);
 
@@ -148,6 +170,9 @@ namespace QTPFS {
 		std::string GetCacheDirName(const std::string& mapCheckSumHexStr, const std::string& modCheckSumHexStr) const;
 		void Serialize(const std::string& cacheFileDir);
 
+		unsigned int WriteNodeTree(unsigned int layerNum, const std::string& fileName, std::vector<SerialNode>& serialNodes);
+		bool ReadNodeTree(unsigned int layerNum, const std::string& fileName);
+
 		static std::vector<NodeLayer> nodeLayers;
 		static std::vector<QTNode*> nodeTrees;
 		static std::vector<PathCache> pathCaches;
@@ -156,16 +181,14 @@ namespace QTPFS {
 		spring::unordered_map<unsigned int, unsigned int> pathTypes;
 		spring::unordered_map<unsigned int, PathSearchTrace::Execution*> pathTraces;
 
-		// maps "hashes" of executed searches to the found paths
-		spring::unordered_map<std::uint64_t, IPath*> sharedPaths;
+		std::vector<PathTypeSearchState> searchStates;
 
-		std::vector<unsigned int> numCurrExecutedSearches;
-		std::vector<unsigned int> numPrevExecutedSearches;
+		// searches admitted per team during the current update
+		std::vector<unsigned int> numQueuedSearches;
 
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
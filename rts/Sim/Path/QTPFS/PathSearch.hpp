@@ -123,6 +123,7 @@ namespace QTPFS {
 			, nodeLayer(NULL)
 			, pathCache(NULL)
 			, searchExec(NULL)
+			, openNodes(NULL)
 			, srcNode(NULL)
 			, tgtNode(NULL)
 			, curNode(NULL)
@@ -132,7 +133,7 @@ namespace QTPFS {
 			, haveFullPath(false)
 			, havePartPath(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() { if (openNodes != NULL) openNodes->reset(); }
 
 		void Initialize(
 			NodeLayer* layer,
@@ -151,8 +152,8 @@ namespace QTPFS {
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitGlobalQueue(unsigned int n);
+		static void FreeGlobalQueue() { openNodeQueues.clear(); }
 
 	private:
 		void ResetState(INode* node);
@@ -165,15 +166,20 @@ namespace QTPFS {
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
+		// global queues (one per pool-thread since searches of different
+		// path-types can run concurrently): allocated once, re-used by all
+		// searches without clear()'s
 		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
+		static std::vector< binary_heap<INode*> > openNodeQueues;
 
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
 
 		// not used unless QTPFS_TRACE_PATH_SEARCHES is defined
 		PathSearchTrace::Execution* searchExec;
+
+		// queue of the thread executing this search
+		binary_heap<INode*>* openNodes;
 		PathSearchTrace::Iteration searchIter;
 
 		SRectangle searchRect;
@@ -30,6 +30,7 @@
 #include "System/Log/ILog.h"
 #include "System/SpringMath.h"
 #include "System/TimeProfiler.h"
+#include "System/Threading/ThreadPool.h"
 
 
 // reserve 5% of maxNanoParticles for important stuff such as capture and reclaim other teams' units
@@ -63,6 +64,33 @@ CR_REG_METADATA(CProjectileHandler, (
 // note: stores all ExpGenSpawnable types, not just projectiles
 ProjMemPool projMemPool;
 
+
+// broad-phase collision candidates; each pool thread appends the colliders
+// it finds to its own flat arrays and records where they start and end for
+// every projectile it processed (indexed by container position)
+struct CollisionCandidates {
+	std::vector<int> quads; // scratch
+
+	std::vector<CUnit*> units;
+	std::vector<CFeature*> features;
+	std::vector<CPlasmaRepulser*> repulsers;
+};
+
+struct CollisionCandidateRange {
+	// broad-phase input, compared against before the range is used
+	float3 pos;
+	float radius = 0.0f;
+
+	int threadNum = -1;
+
+	unsigned int units[2];
+	unsigned int features[2];
+	unsigned int repulsers[2];
+};
+
+static std::array<CollisionCandidates, ThreadPool::MAX_THREADS> collisionCandidates;
+static std::vector<CollisionCandidateRange> collisionCandidateRanges;
+
 CProjectileHandler projectileHandler;
 
 
@@ -598,12 +626,60 @@ void CProjectileHandler::CheckShieldCollisions(
 	}
 }
 
+void CProjectileHandler::GatherCollisionCandidates(const ProjectileContainer& pc)
+{
+	SCOPED_MT_TIMER("Sim::Projectiles::Collisions::Gather");
+
+	for (CollisionCandidates& cc: collisionCandidates) {
+		cc.units.clear();
+		cc.features.clear();
+		cc.repulsers.clear();
+	}
+
+	collisionCandidateRanges.clear();
+	collisionCandidateRanges.resize(pc.size());
+
+	// read-only w.r.t. all shared state, see GetUnitsAndFeaturesColVolMT
+	for_mt(0, pc.size(), [&](const int i) {
+		const CProjectile* p = pc[i];
+
+		if (!p->checkCol) return;
+		if ( p->deleteMe) return;
+
+		CollisionCandidates& cc = collisionCandidates[ThreadPool::GetThreadNum()];
+		CollisionCandidateRange& cr = collisionCandidateRanges[i];
+
+		cr.pos = p->pos;
+		cr.radius = p->speed.w + p->radius;
+		cr.threadNum = ThreadPool::GetThreadNum();
+
+		cr.units[0] = cc.units.size();
+		cr.features[0] = cc.features.size();
+		cr.repulsers[0] = cc.repulsers.size();
+
+		quadField.GetUnitsAndFeaturesColVolMT(cr.pos, cr.radius, cc.quads, cc.units, cc.features, &cc.repulsers);
+
+		cr.units[1] = cc.units.size();
+		cr.features[1] = cc.features.size();
+		cr.repulsers[1] = cc.repulsers.size();
+	});
+}
+
 void CProjectileHandler::CheckUnitFeatureCollisions(ProjectileContainer& pc)
 {
 	static std::vector<CUnit*> tempUnits;
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
 
+	// broad-phase runs in parallel over all projectiles that exist now, the
+	// narrow-phase (which has side-effects) stays serial and in container
+	// order below
+	GatherCollisionCandidates(pc);
+
+	const size_t numGathered = collisionCandidateRanges.size();
+	const unsigned int solidsModCount = quadField.GetSolidsModCount();
+	const unsigned int unitsModCount = quadField.GetUnitsModCount();
+
 	for (size_t i = 0; i < pc.size(); ++i) {
 		CProjectile* p = pc[i];
 
@@ -614,7 +690,28 @@ void CProjectileHandler::CheckUnitFeatureCollisions(ProjectileContainer& pc)
 		const float3 ppos1 = p->pos + p->speed;
 		// const float3 ppos1 = p->pos + p->dir * (p->speed.w + p->radius);
 
-		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+		// gathered candidates can only be used if this projectile and every
+		// object in the field are still where they were; collisions handled
+		// earlier in the loop may have spawned new projectiles, created or
+		// removed units or features, moved units within their quads or
+		// changed collision-volumes (via Lua call-ins)
+		const CollisionCandidateRange* cr = (i < numGathered)? &collisionCandidateRanges[i]: nullptr;
+
+		const bool haveCandidates =
+			(cr != nullptr && cr->threadNum >= 0) &&
+			(cr->pos.same(ppos0) && cr->radius == (p->speed.w + p->radius)) &&
+			(quadField.GetSolidsModCount() == solidsModCount) &&
+			(quadField.GetUnitsModCount() == unitsModCount);
+
+		if (haveCandidates) {
+			const CollisionCandidates& cc = collisionCandidates[cr->threadNum];
+
+			tempUnits.assign(cc.units.begin() + cr->units[0], cc.units.begin() + cr->units[1]);
+			tempFeatures.assign(cc.features.begin() + cr->features[0], cc.features.begin() + cr->features[1]);
+			tempRepulsers.assign(cc.repulsers.begin() + cr->repulsers[0], cc.repulsers.begin() + cr->repulsers[1]);
+		} else {
+			quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+		}
 
 		CheckShieldCollisions(p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
 		CheckUnitCollisions(p, tempUnits, ppos0, ppos1); tempUnits.clear();
@@ -44,6 +44,7 @@ public:
 	void CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
 	void CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
 	void CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
+	void GatherCollisionCandidates(const ProjectileContainer&);
 	void CheckUnitFeatureCollisions(ProjectileContainer&);
 	void CheckGroundCollisions(ProjectileContainer&);
 	void CheckCollisions();
@@ -0,0 +1,107 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_STATUS_UPDATER_H
+#define LOS_STATUS_UPDATER_H
+
+#include <cassert>
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+#include "System/Threading/DeferredWriteBuffer.h"
+#include "System/Threading/ThreadPool.h"
+
+/**
+ * Threaded equivalent of
+ *
+ *   for (UnitType* unit: units)
+ *     for (int at = 0; at < numAllyTeams; ++at)
+ *       unit->UpdateLosStatus(at);
+ *
+ * except that the call-ins are dispatched after all statuses have been
+ * changed rather than in between. UnitType has to provide losStatus[],
+ * CalcLosStatus, CommitLosStatus (sets a status without running call-ins)
+ * and LosStatusChanged (runs them) with the semantics of CUnit's; this is
+ * a template so the exact same code can be run against a mock world in the
+ * tests.
+ *
+ * All statuses are calculated on the thread-pool and committed in the
+ * serial order, which only reads state that committing does not touch;
+ * since call-ins may change anything (including the sensor-relevant state
+ * of other units) they are run last, again in the serial order. Changes
+ * made by a call-in are picked up by the next update.
+ */
+template<typename UnitType, typename StatusType>
+class CLosStatusUpdater {
+public:
+	typedef std::pair<StatusType, StatusType> StatusChange;
+
+	CLosStatusUpdater(unsigned int allMaskBits, unsigned int eventBits)
+		: allMaskBits(allMaskBits)
+		, eventBits(eventBits)
+	{}
+
+	void Update(const std::vector<UnitType*>& units, unsigned int numAllyTeams) {
+		writes.Reset();
+		events.clear();
+
+		for_mt(0, units.size(), [&](const int i) {
+			const UnitType* unit = units[i];
+
+			for (unsigned int at = 0; at < numAllyTeams; ++at) {
+				const StatusType currStatus = unit->losStatus[at];
+
+				if ((currStatus & allMaskBits) == allMaskBits)
+					continue;
+
+				const StatusType nextStatus = unit->CalcLosStatus(at);
+
+				// SetLosStatus would be a no-op
+				if (nextStatus == currStatus)
+					continue;
+
+				writes.Push(uint64_t(i) * numAllyTeams + at, {currStatus, nextStatus});
+			}
+		});
+
+		writes.Commit([&](uint64_t key, const StatusChange& status) {
+			UnitType* unit = units[key / numAllyTeams];
+
+			const unsigned int at = key % numAllyTeams;
+
+			// nothing ran between the calculation and this write
+			assert(unit->losStatus[at] == status.first);
+			unit->CommitLosStatus(at, status.second);
+
+			if (((status.first ^ status.second) & eventBits) == 0)
+				return;
+
+			events.emplace_back(key, status);
+		});
+
+		// call-ins may append to <units>, but never remove from it
+		for (const std::pair<uint64_t, StatusChange>& event: events) {
+			UnitType* unit = units[event.first / numAllyTeams];
+
+			const unsigned int at = event.first % numAllyTeams;
+
+			// an earlier call-in changed this status again, and already
+			// ran the call-ins for that change
+			if (((unit->losStatus[at] ^ event.second.second) & eventBits) != 0)
+				continue;
+
+			unit->LosStatusChanged(at, event.second.first, event.second.second);
+		}
+	}
+
+private:
+	// {old, new} status pairs keyed by (unit index * numAllyTeams + allyTeam)
+	DeferredWriteBuffer<StatusChange> writes;
+	// committed changes that still need their call-ins, in key order
+	std::vector< std::pair<uint64_t, StatusChange> > events;
+
+	unsigned int allMaskBits;
+	unsigned int eventBits;
+};
+
+#endif
@@ -5,38 +5,79 @@
 #include "CobThread.h"
 #include "CobFile.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 
 CR_BIND(CCobEngine, )
 
 CR_REG_METADATA(CCobEngine, (
 	CR_MEMBER(threadInstances),
+	CR_MEMBER(threadSlotGens),
+	CR_MEMBER(threadSlotRefs),
+	CR_MEMBER(freeThreadSlots),
 	CR_MEMBER(tickAddedThreads),
 
 	CR_MEMBER(runningThreadIDs),
-	CR_MEMBER(sleepingThreadIDs),
 	// always null/empty when saving
 	CR_IGNORED(waitingThreadIDs),
 
+	CR_MEMBER(nearSleepingThreads),
+	CR_MEMBER(farSleepingThreads),
+	CR_MEMBER(overflowSleepingThreads),
+	// always empty when saving
+	CR_IGNORED(wakingThreadIDs),
+
 	CR_IGNORED(curThread),
 
 	CR_MEMBER(currentTime),
-	CR_MEMBER(threadCounter)
+	CR_MEMBER(wheelSlot),
+	CR_MEMBER(drainTime),
+	CR_MEMBER(sleepCounter)
 ))
 
 CR_BIND(CCobEngine::SleepingThread, )
 CR_REG_METADATA(CCobEngine::SleepingThread, (
 	CR_MEMBER(id),
-	CR_MEMBER(wt)
+	CR_MEMBER(wt),
+	CR_MEMBER(seq)
 ))
 
 
+int CCobEngine::GenThreadID()
+{
+	int slot = threadInstances.size();
+
+	if (freeThreadSlots.size() > MIN_FREE_THREAD_SLOTS || slot > THREAD_SLOT_MASK) {
+		// every slot is owned by a thread or by a sleeper that has not woken yet
+		if (freeThreadSlots.empty())
+			throw std::runtime_error("[CobEngine::GenThreadID] too many COB threads");
+
+		slot = freeThreadSlots.front();
+		freeThreadSlots.pop_front();
+	} else {
+		threadInstances.emplace_back();
+		threadSlotGens.push_back(0);
+		threadSlotRefs.push_back(0);
+	}
+
+	assert(threadSlotRefs[slot] == 0);
+	threadSlotRefs[slot] = 1;
+
+	// slot stays reserved (GetThread returns null) until AddThread
+	return ((threadSlotGens[slot] << THREAD_SLOT_BITS) | slot);
+}
+
 int CCobEngine::AddThread(CCobThread&& thread)
 {
 	if (thread.GetID() == -1)
 		thread.SetID(GenThreadID());
 
 	CCobInstance* o = thread.cobInst;
-	CCobThread& t = threadInstances[thread.GetID()];
+	CCobThread& t = threadInstances[thread.GetID() & THREAD_SLOT_MASK];
+
+	assert(t.GetID() == -1);
+	assert(t.IsGarbage());
 
 	// move thread into registry, hand its ID to owner
 	t = std::move(thread);
@@ -45,6 +86,40 @@ int CCobEngine::AddThread(CCobThread&& thread)
 	return (t.GetID());
 }
 
+bool CCobEngine::RemoveThread(int threadID)
+{
+	CCobThread* t = GetThread(threadID);
+
+	if (t == nullptr)
+		return false;
+
+	// runs the callback in place; new slots never move <t>
+	t->Stop();
+
+	// callback might have removed this thread as well
+	if (t->GetID() != threadID)
+		return true;
+
+	const int slot = threadID & THREAD_SLOT_MASK;
+
+	t->SetID(-1);
+
+	threadSlotGens[slot] = (threadSlotGens[slot] + 1) & THREAD_GEN_MASK;
+	UnrefThreadSlot(threadID);
+	return true;
+}
+
+void CCobEngine::UnrefThreadSlot(int threadID)
+{
+	const int slot = threadID & THREAD_SLOT_MASK;
+
+	assert(threadSlotRefs[slot] > 0);
+
+	// neither a thread nor a sleeper can resolve to this slot anymore
+	if ((threadSlotRefs[slot] -= 1) == 0)
+		freeThreadSlots.push_back(slot);
+}
+
 
 // a thread wants to continue running at a later time, and adds itself to the scheduler
 void CCobEngine::ScheduleThread(const CCobThread* thread)
@@ -54,7 +129,8 @@ void CCobEngine::ScheduleThread(const CCobThread* thread)
 			waitingThreadIDs.push_back(thread->GetID());
 		} break;
 		case CCobThread::Sleep: {
-			sleepingThreadIDs.push(SleepingThread{thread->GetID(), thread->GetWakeTime()});
+			InsertSleepingThread(SleepingThread{thread->GetID(), thread->GetWakeTime(), sleepCounter++});
+			threadSlotRefs[thread->GetID() & THREAD_SLOT_MASK] += 1;
 		} break;
 		default: {
 			LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, thread->GetState(), thread->GetID());
@@ -66,8 +142,8 @@ void CCobEngine::SanityCheckThreads(const CCobInstance* owner)
 {
 	if (false) {
 		// no threads belonging to owner should be left
-		for (const auto& p: threadInstances) {
-			assert(p.second.cobInst != owner);
+		for (const CCobThread& t: threadInstances) {
+			assert(t.cobInst != owner);
 		}
 		for (const CCobThread& t: tickAddedThreads) {
 			assert(t.cobInst != owner);
@@ -76,6 +152,89 @@ void CCobEngine::SanityCheckThreads(const CCobInstance* owner)
 }
 
 
+void CCobEngine::InsertSleepingThread(const SleepingThread& st)
+{
+	// already due, e.g. after a negative sleep; drained sleepers are ordered
+	// by <wt, seq> just like a single priority-queue would order all of them
+	if (st.wt < drainTime) {
+		wakingThreadIDs.push(st);
+		return;
+	}
+
+	const int slot = st.wt >> WHEEL_SLOT_BITS;
+	const int span = (slot >> WHEEL_SIZE_BITS) - (wheelSlot >> WHEEL_SIZE_BITS);
+
+	if (span == 0) {
+		nearSleepingThreads[slot & WHEEL_MASK].push_back(st);
+		return;
+	}
+
+	if (span < WHEEL_SIZE) {
+		farSleepingThreads[(slot >> WHEEL_SIZE_BITS) & WHEEL_MASK].push_back(st);
+		return;
+	}
+
+	overflowSleepingThreads.push_back(st);
+}
+
+void CCobEngine::CascadeSleepingThreads()
+{
+	// wheelSlot just entered a new near span, pull it down from the far level
+	const int span = wheelSlot >> WHEEL_SIZE_BITS;
+
+	std::vector<SleepingThread>& farSlot = farSleepingThreads[span & WHEEL_MASK];
+
+	for (const SleepingThread& st: farSlot) {
+		nearSleepingThreads[(st.wt >> WHEEL_SLOT_BITS) & WHEEL_MASK].push_back(st);
+	}
+
+	farSlot.clear();
+
+	if ((span & WHEEL_MASK) != 0)
+		return;
+
+	// far level completed a revolution, overflow might now be in range
+	std::vector<SleepingThread> overflow;
+	std::swap(overflow, overflowSleepingThreads);
+
+	for (const SleepingThread& st: overflow) {
+		InsertSleepingThread(st);
+	}
+}
+
+void CCobEngine::DrainSleepingThreads()
+{
+	const int lastSlot = currentTime >> WHEEL_SLOT_BITS;
+
+	// every sleeper in a slot before the one containing currentTime is due
+	while (wheelSlot < lastSlot) {
+		std::vector<SleepingThread>& nearSlot = nearSleepingThreads[wheelSlot & WHEEL_MASK];
+
+		for (const SleepingThread& st: nearSlot) {
+			wakingThreadIDs.push(st);
+		}
+
+		nearSlot.clear();
+
+		if (((++wheelSlot) & WHEEL_MASK) == 0)
+			CascadeSleepingThreads();
+	}
+
+	// the current slot is only partially due
+	std::vector<SleepingThread>& nearSlot = nearSleepingThreads[wheelSlot & WHEEL_MASK];
+
+	const auto IsDue = [&](const SleepingThread& st) { return (st.wt < currentTime); };
+
+	for (const SleepingThread& st: nearSlot) {
+		if (IsDue(st))
+			wakingThreadIDs.push(st);
+	}
+
+	nearSlot.erase(std::remove_if(nearSlot.begin(), nearSlot.end(), IsDue), nearSlot.end());
+	drainTime = currentTime;
+}
+
+
 void CCobEngine::TickThread(CCobThread* thread)
 {
 	// for error messages originating in CUnitScript
@@ -90,25 +249,26 @@ void CCobEngine::TickThread(CCobThread* thread)
 
 void CCobEngine::WakeSleepingThreads()
 {
-	// check on the sleeping threads, remove any whose owner died
-	while (!sleepingThreadIDs.empty()) {
-		CCobThread* zzzThread = GetThread((sleepingThreadIDs.top()).id);
-
-		if (zzzThread == nullptr) {
-			sleepingThreadIDs.pop();
-			continue;
-		}
+	DrainSleepingThreads();
 
-		// not yet time to execute this thread or any subsequent sleepers
-		if (zzzThread->GetWakeTime() >= currentTime)
-			break;
+	// wake all due threads in order of wake-time, ties in the order they fell asleep
+	while (!wakingThreadIDs.empty()) {
+		const SleepingThread st = wakingThreadIDs.top();
 
 		// remove executing thread from the queue
-		sleepingThreadIDs.pop();
+		wakingThreadIDs.pop();
+		UnrefThreadSlot(st.id);
+
+		// slots are not reused while a sleeper references them, stale ID's never resolve
+		CCobThread* zzzThread = GetThread(st.id);
+
+		// owner died while thread was asleep
+		if (zzzThread == nullptr || zzzThread->GetWakeTime() != st.wt)
+			continue;
 
 		// wake up the thread and tick it (if not dead)
-		// this can quite possibly re-add the thread to <sleepingThreadIDs>
-		// again, but any thread is guaranteed to sleep for at least 1 tick
+		// this can quite possibly put the thread back to sleep; if its new
+		// wake-time has already passed it goes straight into <wakingThreadIDs>
 		switch (zzzThread->GetState()) {
 			case CCobThread::Sleep: {
 				zzzThread->SetState(CCobThread::Run);
@@ -8,12 +8,14 @@
  * It also manages reading and caching of the actual .cob files.
  */
 
+#include <array>
+#include <deque>
 #include <vector>
 
 #include "CobThread.h"
 #include "System/creg/creg_cond.h"
+#include "System/creg/STL_Deque.h"
 #include "System/creg/STL_Queue.h"
-#include "System/creg/STL_Map.h"
 
 
 class CCobThread;
@@ -31,38 +33,71 @@ private:
 
 		int id;
 		int wt;
+
+		// order in which threads went to sleep, breaks ties between equal wake-times
+		unsigned int seq;
 	};
 
 	struct CCobThreadComp: public std::binary_function<const SleepingThread&, const SleepingThread&, bool> {
 	public:
 		bool operator() (const SleepingThread& a, const SleepingThread& b) const {
-			return (a.wt > b.wt);
+			if (a.wt != b.wt)
+				return (a.wt > b.wt);
+
+			return (int(a.seq - b.seq) > 0);
 		}
 	};
 
+	// near wheel-slots are 32ms wide (about one sim-frame) and the near level
+	// spans 256 of them; each far slot covers one such span, and sleepers due
+	// beyond the far level's range (~35 minutes) wait in an overflow list
+	static constexpr int WHEEL_SLOT_BITS = 5;
+	static constexpr int WHEEL_SIZE_BITS = 8;
+	static constexpr int WHEEL_SIZE = 1 << WHEEL_SIZE_BITS;
+	static constexpr int WHEEL_MASK = WHEEL_SIZE - 1;
+
+	// thread ID's are <generation, slot> pairs
+	static constexpr int THREAD_SLOT_BITS = 20;
+	static constexpr int THREAD_SLOT_MASK = (1 << THREAD_SLOT_BITS) - 1;
+	static constexpr int THREAD_GEN_MASK = (1 << (31 - THREAD_SLOT_BITS)) - 1;
+
+	// a released slot is not reused before this many others have been
+	// released after it, which keeps stale ID's from matching for longer
+	static constexpr int MIN_FREE_THREAD_SLOTS = 1024;
+
 public:
 	void Init() {
-		threadInstances.reserve(2048);
 		tickAddedThreads.reserve(128);
 
 		runningThreadIDs.reserve(512);
 		waitingThreadIDs.reserve(512);
 
-		threadCounter = 0;
+		ResetSleepingThreads();
 	}
 	void Kill() {
-		// threadInstances is never explicitly iterated, so
-		// calling clear_unordered_map (between reloads) is
-		// unnecessary here
 		threadInstances.clear();
+		threadSlotGens.clear();
+		threadSlotRefs.clear();
+		freeThreadSlots.clear();
 		tickAddedThreads.clear();
 
 		runningThreadIDs.clear();
 		waitingThreadIDs.clear();
 
-		while (!sleepingThreadIDs.empty()) {
-			sleepingThreadIDs.pop();
+		for (std::vector<SleepingThread>& slot: nearSleepingThreads) {
+			slot.clear();
+		}
+		for (std::vector<SleepingThread>& slot: farSleepingThreads) {
+			slot.clear();
 		}
+
+		overflowSleepingThreads.clear();
+
+		while (!wakingThreadIDs.empty()) {
+			wakingThreadIDs.pop();
+		}
+
+		ResetSleepingThreads();
 	}
 
 	void Tick(int deltaTime);
@@ -70,34 +105,31 @@ public:
 
 
 	CCobThread* GetThread(int threadID) {
-		const auto it = threadInstances.find(threadID);
+		const unsigned int slot = threadID & THREAD_SLOT_MASK;
 
-		if (it == threadInstances.end())
+		if (threadID < 0 || slot >= threadInstances.size())
 			return nullptr;
 
-		return &(it->second);
-	}
-
-	bool RemoveThread(int threadID) {
-		const auto it = threadInstances.find(threadID);
+		CCobThread* thread = &threadInstances[slot];
 
-		if (it != threadInstances.end()) {
-			threadInstances.erase(it);
-			return true;
-		}
+		// slot is unused, reserved for a queued thread, or taken by a newer thread
+		if (thread->GetID() != threadID)
+			return nullptr;
 
-		return false;
+		return thread;
 	}
 
+	bool RemoveThread(int threadID);
+
 	int AddThread(CCobThread&& thread);
-	int GenThreadID() { return (threadCounter++); }
+	int GenThreadID();
 	int GetCurrentTime() const { return currentTime; }
 
 	void QueueAddThread(CCobThread&& thread) { tickAddedThreads.emplace_back(std::move(thread)); }
 	void AddQueuedThreads() {
 		// move new threads spawned by START into threadInstances;
 		// their ID's will already have been scheduled into either
-		// waitingThreadIDs or sleepingThreadIDs
+		// waitingThreadIDs or the sleeping-thread wheel
 		for (CCobThread& t: tickAddedThreads) {
 			AddThread(std::move(t));
 		}
@@ -111,6 +143,17 @@ public:
 private:
 	void TickThread(CCobThread* thread);
 
+	void ResetSleepingThreads() {
+		wheelSlot = currentTime >> WHEEL_SLOT_BITS;
+		drainTime = currentTime;
+		sleepCounter = 0;
+	}
+	void InsertSleepingThread(const SleepingThread& st);
+	void CascadeSleepingThreads();
+	void DrainSleepingThreads();
+
+	void UnrefThreadSlot(int threadID);
+
 	void WakeSleepingThreads();
 	void TickRunningThreads() {
 		// advance all currently running threads
@@ -129,22 +172,44 @@ private:
 	}
 
 private:
-	// registry of every thread across all script instances
-	spring::unordered_map<int, CCobThread> threadInstances;
+	// registry of every thread across all script instances, indexed by the
+	// slot-part of thread ID's; a deque so new slots never move existing ones
+	std::deque<CCobThread> threadInstances;
+	// current generation of each slot
+	std::vector<int> threadSlotGens;
+	// references to each slot; one while a thread (or queued thread) owns it,
+	// plus one per sleeper entry so a slot is not reused before every stale
+	// entry for it has woken
+	std::vector<int> threadSlotRefs;
+	// released slots, reused in FIFO order
+	std::deque<int> freeThreadSlots;
+
 	// threads that are spawned during Tick
 	std::vector<CCobThread> tickAddedThreads;
 
 	std::vector<int> runningThreadIDs;
 	std::vector<int> waitingThreadIDs;
 
-	// stores <id, waketime> pairs s.t. after waking up the ID can be checked
-	// for validity; thread owner might get removed while a thread is sleeping
-	std::priority_queue<SleepingThread, std::vector<SleepingThread>, CCobThreadComp> sleepingThreadIDs;
+	// hierarchical timer-wheel keyed on wake-time; stores <id, waketime> pairs
+	// s.t. after waking up the ID can be checked for validity since the thread
+	// owner might get removed while a thread is sleeping
+	std::array<std::vector<SleepingThread>, WHEEL_SIZE> nearSleepingThreads;
+	std::array<std::vector<SleepingThread>, WHEEL_SIZE> farSleepingThreads;
+	std::vector<SleepingThread> overflowSleepingThreads;
+
+	// sleepers whose wake-time has passed, popped in wake order
+	std::priority_queue<SleepingThread, std::vector<SleepingThread>, CCobThreadComp> wakingThreadIDs;
 
 	CCobThread* curThread = nullptr;
 
 	int currentTime = 0;
-	int threadCounter = 0;
+
+	// near slot containing <drainTime>, the time up to which the
+	// wheel was last drained; every sleeper in it is due no earlier
+	int wheelSlot = 0;
+	int drainTime = 0;
+
+	unsigned int sleepCounter = 0;
 };
 
 
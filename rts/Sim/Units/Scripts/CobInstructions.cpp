@@ -0,0 +1,311 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+
+#include "CobInstructions.h"
+#include "CobFile.h"
+
+#include <cassert>
+
+
+// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
+// And some information from basm0.8 source (basm ops.txt)
+
+// Model interaction
+constexpr int MOVE       = 0x10001000;
+constexpr int TURN       = 0x10002000;
+constexpr int SPIN       = 0x10003000;
+constexpr int STOP_SPIN  = 0x10004000;
+constexpr int SHOW       = 0x10005000;
+constexpr int HIDE       = 0x10006000;
+constexpr int CACHE      = 0x10007000;
+constexpr int DONT_CACHE = 0x10008000;
+constexpr int MOVE_NOW   = 0x1000B000;
+constexpr int TURN_NOW   = 0x1000C000;
+constexpr int SHADE      = 0x1000D000;
+constexpr int DONT_SHADE = 0x1000E000;
+constexpr int EMIT_SFX   = 0x1000F000;
+
+// Blocking operations
+constexpr int WAIT_TURN  = 0x10011000;
+constexpr int WAIT_MOVE  = 0x10012000;
+constexpr int SLEEP      = 0x10013000;
+
+// Stack manipulation
+constexpr int PUSH_CONSTANT    = 0x10021001;
+constexpr int PUSH_LOCAL_VAR   = 0x10021002;
+constexpr int PUSH_STATIC      = 0x10021004;
+constexpr int CREATE_LOCAL_VAR = 0x10022000;
+constexpr int POP_LOCAL_VAR    = 0x10023002;
+constexpr int POP_STATIC       = 0x10023004;
+constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
+
+// Arithmetic operations
+constexpr int ADD         = 0x10031000;
+constexpr int SUB         = 0x10032000;
+constexpr int MUL         = 0x10033000;
+constexpr int DIV         = 0x10034000;
+constexpr int MOD		  = 0x10034001; ///< spring specific
+constexpr int BITWISE_AND = 0x10035000;
+constexpr int BITWISE_OR  = 0x10036000;
+constexpr int BITWISE_XOR = 0x10037000;
+constexpr int BITWISE_NOT = 0x10038000;
+
+// Native function calls
+constexpr int RAND           = 0x10041000;
+constexpr int GET_UNIT_VALUE = 0x10042000;
+constexpr int GET            = 0x10043000;
+
+// Comparison
+constexpr int SET_LESS             = 0x10051000;
+constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
+constexpr int SET_GREATER          = 0x10053000;
+constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
+constexpr int SET_EQUAL            = 0x10055000;
+constexpr int SET_NOT_EQUAL        = 0x10056000;
+constexpr int LOGICAL_AND          = 0x10057000;
+constexpr int LOGICAL_OR           = 0x10058000;
+constexpr int LOGICAL_XOR          = 0x10059000;
+constexpr int LOGICAL_NOT          = 0x1005A000;
+
+// Flow control
+constexpr int START           = 0x10061000;
+constexpr int CALL            = 0x10062000; ///< resolved when decoded
+constexpr int REAL_CALL       = 0x10062001; ///< spring custom
+constexpr int LUA_CALL        = 0x10062002; ///< spring custom
+constexpr int JUMP            = 0x10064000;
+constexpr int RETURN          = 0x10065000;
+constexpr int JUMP_NOT_EQUAL  = 0x10066000;
+constexpr int SIGNAL          = 0x10067000;
+constexpr int SET_SIGNAL_MASK = 0x10068000;
+
+// Piece destruction
+constexpr int EXPLODE    = 0x10071000;
+constexpr int PLAY_SOUND = 0x10072000;
+
+// Special functions
+constexpr int SET    = 0x10082000;
+constexpr int ATTACH = 0x10083000;
+constexpr int DROP   = 0x10084000;
+
+
+typedef SCobInstruction Instr;
+
+
+static int GetLength(int type)
+{
+	constexpr int lengths[] = {
+		#define COB_INSTRUCTION_LENGTH(name, length) length,
+		COB_INSTRUCTION_TYPES(COB_INSTRUCTION_LENGTH)
+		#undef COB_INSTRUCTION_LENGTH
+	};
+
+	return lengths[type];
+}
+
+static int GetType(int opcode)
+{
+	switch (opcode) {
+		case MOVE: return Instr::MOVE;
+		case TURN: return Instr::TURN;
+		case SPIN: return Instr::SPIN;
+		case STOP_SPIN: return Instr::STOP_SPIN;
+		case SHOW: return Instr::SHOW;
+		case HIDE: return Instr::HIDE;
+		case CACHE: return Instr::NOP;
+		case DONT_CACHE: return Instr::NOP;
+		case MOVE_NOW: return Instr::MOVE_NOW;
+		case TURN_NOW: return Instr::TURN_NOW;
+		case SHADE: return Instr::NOP;
+		case DONT_SHADE: return Instr::NOP;
+		case EMIT_SFX: return Instr::EMIT_SFX;
+
+		case WAIT_TURN: return Instr::WAIT_TURN;
+		case WAIT_MOVE: return Instr::WAIT_MOVE;
+		case SLEEP: return Instr::SLEEP;
+
+		case PUSH_CONSTANT: return Instr::PUSH_CONSTANT;
+		case PUSH_LOCAL_VAR: return Instr::PUSH_LOCAL_VAR;
+		case PUSH_STATIC: return Instr::PUSH_STATIC;
+		case CREATE_LOCAL_VAR: return Instr::CREATE_LOCAL_VAR;
+		case POP_LOCAL_VAR: return Instr::POP_LOCAL_VAR;
+		case POP_STATIC: return Instr::POP_STATIC;
+		case POP_STACK: return Instr::POP_STACK;
+
+		case ADD: return Instr::ADD;
+		case SUB: return Instr::SUB;
+		case MUL: return Instr::MUL;
+		case DIV: return Instr::DIV;
+		case MOD: return Instr::MOD;
+		case BITWISE_AND: return Instr::BITWISE_AND;
+		case BITWISE_OR: return Instr::BITWISE_OR;
+		case BITWISE_XOR: return Instr::BITWISE_XOR;
+		case BITWISE_NOT: return Instr::BITWISE_NOT;
+
+		case RAND: return Instr::RAND;
+		case GET_UNIT_VALUE: return Instr::GET_UNIT_VALUE;
+		case GET: return Instr::GET;
+
+		case SET_LESS: return Instr::SET_LESS;
+		case SET_LESS_OR_EQUAL: return Instr::SET_LESS_OR_EQUAL;
+		case SET_GREATER: return Instr::SET_GREATER;
+		case SET_GREATER_OR_EQUAL: return Instr::SET_GREATER_OR_EQUAL;
+		case SET_EQUAL: return Instr::SET_EQUAL;
+		case SET_NOT_EQUAL: return Instr::SET_NOT_EQUAL;
+		case LOGICAL_AND: return Instr::LOGICAL_AND;
+		case LOGICAL_OR: return Instr::LOGICAL_OR;
+		case LOGICAL_XOR: return Instr::LOGICAL_XOR;
+		case LOGICAL_NOT: return Instr::LOGICAL_NOT;
+
+		case START: return Instr::START;
+		case CALL: return Instr::CALL;
+		case REAL_CALL: return Instr::CALL;
+		case LUA_CALL: return Instr::LUA_CALL;
+		case JUMP: return Instr::JUMP;
+		case RETURN: return Instr::RETURN;
+		case JUMP_NOT_EQUAL: return Instr::JUMP_NOT_EQUAL;
+		case SIGNAL: return Instr::SIGNAL;
+		case SET_SIGNAL_MASK: return Instr::SET_SIGNAL_MASK;
+
+		case EXPLODE: return Instr::EXPLODE;
+		case PLAY_SOUND: return Instr::PLAY_SOUND;
+
+		case SET: return Instr::SET;
+		case ATTACH: return Instr::ATTACH;
+		case DROP: return Instr::DROP;
+	}
+
+	return Instr::UNKNOWN;
+}
+
+
+static Instr DecodeCall(const CCobFile& file, int opcode, int scriptIdx, int argCount)
+{
+	Instr instr = {Instr::CALL, scriptIdx, argCount, 0, 0};
+
+	// the raw interpreter did not validate the index at all
+	if (static_cast<size_t>(scriptIdx) >= file.scriptLengths.size()) {
+		instr.type = Instr::BAD_CALL;
+		return instr;
+	}
+
+	// CALL was patched into LUA_CALL or REAL_CALL when first executed
+	if (opcode == CALL && file.scriptNames[scriptIdx].find("lua_") == 0) {
+		instr.type = Instr::LUA_CALL;
+		return instr;
+	}
+
+	// do not call (or start) zero-length functions
+	if (file.scriptLengths[scriptIdx] == 0) {
+		instr.type = Instr::NOP_CALL;
+		return instr;
+	}
+
+	if (opcode == START)
+		instr.type = Instr::START;
+
+	instr.arg3 = file.scriptOffsets[scriptIdx];
+	return instr;
+}
+
+static Instr DecodeSingle(const CCobFile& file, int offset)
+{
+	const std::vector<int>& code = file.code;
+
+	const int opcode = code[offset];
+	const int type = GetType(opcode);
+	const int length = GetLength(type);
+
+	Instr instr = {type, 0, 0, 0, offset + length};
+
+	if (instr.type == Instr::UNKNOWN) {
+		instr.arg1 = opcode;
+		return instr;
+	}
+
+	// operands past the end of the code used to throw from code.at()
+	if (static_cast<size_t>(instr.next) > code.size()) {
+		instr.type = Instr::BAD_OPERAND;
+		instr.next = offset;
+		return instr;
+	}
+
+	if (length > 1)
+		instr.arg1 = code[offset + 1];
+	if (length > 2)
+		instr.arg2 = code[offset + 2];
+
+	switch (opcode) {
+		case CALL:
+		case REAL_CALL:
+		case START: {
+			const int next = instr.next;
+
+			instr = DecodeCall(file, opcode, instr.arg1, instr.arg2);
+			instr.next = next;
+		} break;
+		default: {
+		} break;
+	}
+
+	assert(instr.next == (offset + GetLength(instr.type)));
+	return instr;
+}
+
+static void FusePushPop(Instr& push, const Instr& pop)
+{
+	constexpr int fusedTypes[3][2] = {
+		{Instr::PUSHC_POPL, Instr::PUSHC_POPS},
+		{Instr::PUSHL_POPL, Instr::PUSHL_POPS},
+		{Instr::PUSHS_POPL, Instr::PUSHS_POPS},
+	};
+
+	if (push.type < Instr::PUSH_CONSTANT || push.type > Instr::PUSH_STATIC)
+		return;
+	if (pop.type != Instr::POP_LOCAL_VAR && pop.type != Instr::POP_STATIC)
+		return;
+
+	push.type = fusedTypes[push.type - Instr::PUSH_CONSTANT][pop.type == Instr::POP_STATIC];
+	push.arg2 = pop.arg1;
+	push.next = pop.next;
+}
+
+
+namespace CobInstructions {
+
+void Decode(CCobFile& file)
+{
+	std::vector<Instr>& instrs = file.instructions;
+
+	instrs.clear();
+	instrs.resize(file.code.size());
+
+	for (size_t i = 0, n = file.code.size(); i < n; i++) {
+		instrs[i] = DecodeSingle(file, i);
+	}
+
+	// successors are always at higher offsets and not yet fused; the
+	// pop also remains individually addressable as a jump target
+	for (size_t i = 0, n = instrs.size(); i < n; i++) {
+		if (static_cast<size_t>(instrs[i].next) >= n)
+			continue;
+
+		FusePushPop(instrs[i], instrs[ instrs[i].next ]);
+	}
+}
+
+const char* GetTypeName(int type)
+{
+	constexpr const char* names[] = {
+		#define COB_INSTRUCTION_NAME(name, length) #name,
+		COB_INSTRUCTION_TYPES(COB_INSTRUCTION_NAME)
+		#undef COB_INSTRUCTION_NAME
+		"INVALID"
+	};
+
+	if (static_cast<unsigned int>(type) >= Instr::NUM_TYPES)
+		return names[Instr::NUM_TYPES];
+
+	return names[type];
+}
+
+}
@@ -0,0 +1,127 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_INSTRUCTIONS_H
+#define COB_INSTRUCTIONS_H
+
+#include <vector>
+
+class CCobFile;
+
+// every instruction-type the interpreter dispatches on (in table order)
+// and its fixed length in code words
+#define COB_INSTRUCTION_TYPES(X) \
+	X(MOVE, 3)                   \
+	X(TURN, 3)                   \
+	X(SPIN, 3)                   \
+	X(STOP_SPIN, 3)              \
+	X(SHOW, 2)                   \
+	X(HIDE, 2)                   \
+	X(MOVE_NOW, 3)               \
+	X(TURN_NOW, 3)               \
+	X(EMIT_SFX, 2)               \
+	X(WAIT_TURN, 3)              \
+	X(WAIT_MOVE, 3)              \
+	X(SLEEP, 1)                  \
+	X(PUSH_CONSTANT, 2)          \
+	X(PUSH_LOCAL_VAR, 2)         \
+	X(PUSH_STATIC, 2)            \
+	X(CREATE_LOCAL_VAR, 1)       \
+	X(POP_LOCAL_VAR, 2)          \
+	X(POP_STATIC, 2)             \
+	X(POP_STACK, 1)              \
+	X(ADD, 1)                    \
+	X(SUB, 1)                    \
+	X(MUL, 1)                    \
+	X(DIV, 1)                    \
+	X(MOD, 1)                    \
+	X(BITWISE_AND, 1)            \
+	X(BITWISE_OR, 1)             \
+	X(BITWISE_XOR, 1)            \
+	X(BITWISE_NOT, 1)            \
+	X(RAND, 1)                   \
+	X(GET_UNIT_VALUE, 1)         \
+	X(GET, 1)                    \
+	X(SET_LESS, 1)               \
+	X(SET_LESS_OR_EQUAL, 1)      \
+	X(SET_GREATER, 1)            \
+	X(SET_GREATER_OR_EQUAL, 1)   \
+	X(SET_EQUAL, 1)              \
+	X(SET_NOT_EQUAL, 1)          \
+	X(LOGICAL_AND, 1)            \
+	X(LOGICAL_OR, 1)             \
+	X(LOGICAL_XOR, 1)            \
+	X(LOGICAL_NOT, 1)            \
+	X(START, 3)                  \
+	X(CALL, 3)                   \
+	X(LUA_CALL, 3)               \
+	X(JUMP, 2)                   \
+	X(RETURN, 1)                 \
+	X(JUMP_NOT_EQUAL, 2)         \
+	X(SIGNAL, 1)                 \
+	X(SET_SIGNAL_MASK, 1)        \
+	X(EXPLODE, 2)                \
+	X(PLAY_SOUND, 2)             \
+	X(SET, 1)                    \
+	X(ATTACH, 1)                 \
+	X(DROP, 1)                   \
+	X(PUSHC_POPL, 4)             \
+	X(PUSHC_POPS, 4)             \
+	X(PUSHL_POPL, 4)             \
+	X(PUSHL_POPS, 4)             \
+	X(PUSHS_POPL, 4)             \
+	X(PUSHS_POPS, 4)             \
+	X(NOP, 2)                    \
+	X(NOP_CALL, 3)               \
+	X(BAD_CALL, 3)               \
+	X(BAD_OPERAND, 0)            \
+	X(UNKNOWN, 1)
+
+
+/**
+ * COB bytecode after load-time decoding. There is one instruction per
+ * code word (decoded as if execution started at that word), so program
+ * counters, jump targets and return addresses keep their raw offsets and
+ * saved games remain compatible; a jump into the middle of an instruction
+ * behaves exactly as it did with the raw code.
+ *
+ * Operands are read ahead of time, CALLs are resolved to a plain or Lua
+ * call (calls to zero-length scripts become NOPs), and a push directly
+ * followed by a pop is fused into one instruction. Since each type has a
+ * fixed length the interpreter can step over an instruction without a
+ * dependent load of <next>.
+ */
+struct SCobInstruction {
+	enum Type {
+		#define COB_INSTRUCTION_ENUM(name, length) name,
+		COB_INSTRUCTION_TYPES(COB_INSTRUCTION_ENUM)
+		#undef COB_INSTRUCTION_ENUM
+		NUM_TYPES
+	};
+	enum Length {
+		#define COB_INSTRUCTION_LENGTH(name, length) LENGTH_##name = length,
+		COB_INSTRUCTION_TYPES(COB_INSTRUCTION_LENGTH)
+		#undef COB_INSTRUCTION_LENGTH
+	};
+
+	int type;
+
+	// resolved operands; meaning depends on type
+	// (UNKNOWN stores the raw opcode in <arg1>)
+	int arg1;
+	int arg2;
+	int arg3;
+
+	// offset of the next instruction, i.e. pc after fetching this one;
+	// always the instruction's own offset plus the length of its type
+	int next;
+};
+
+
+namespace CobInstructions {
+	// decodes <file.code> into <file.instructions>
+	void Decode(CCobFile& file);
+
+	const char* GetTypeName(int type);
+}
+
+#endif // COB_INSTRUCTIONS_H
@@ -105,7 +105,7 @@ protected:
 		int stackTop = -1;
 	};
 
-	void LuaCall();
+	void LuaCall(int r1, int r2); // script id, arg count
 
 	bool PushCallStack(CallInfo v) { return (callStackSize < callStack.size() && PushCallStackRaw(v)); }
 	bool PushDataStack(     int v) { return (dataStackSize < dataStack.size() && PushDataStackRaw(v)); }
@@ -86,11 +86,14 @@ CUnitScript::CUnitScript(CUnit* unit)
 
 CUnitScript::~CUnitScript()
 {
-	// Remove us from possible animation ticking
-	if (!HaveAnimations())
+	// the null-script outlives the engine
+	if (unitScriptEngine == nullptr)
 		return;
 
-	unitScriptEngine->RemoveInstance(this);
+	// Remove us from possible animation ticking; even without animations
+	// left we might still be listed until the end of this tick, and have
+	// finished animations waiting to be dispatched
+	unitScriptEngine->KillInstance(this);
 }
 
 
@@ -174,14 +177,16 @@ bool CUnitScript::DoSpin(float& cur, float dest, float& speed, float accel, int
 
 
 
-void CUnitScript::TickAnims(int tickRate, const TickAnimFunc& tickAnimFunc, AnimContainerType& liveAnims, AnimContainerType& doneAnims) {
+void CUnitScript::TickAnims(int tickRate, AnimType animType, const TickAnimFunc& tickAnimFunc, DoneAnimBuffer& doneAnims, unsigned int& numDoneAnims) {
+	AnimContainerType& liveAnims = anims[animType];
+
 	for (size_t i = 0; i < liveAnims.size(); ) {
 		AnimInfo& ai = liveAnims[i];
 		LocalModelPiece& lmp = *pieces[ai.piece];
 
 		if ((ai.done |= (this->*tickAnimFunc)(tickRate, lmp, ai))) {
 			if (ai.hasWaiting)
-				doneAnims.push_back(ai);
+				doneAnims.Push((uint64_t(unit->id) << 32) | (numDoneAnims++), {this, animType, ai.piece, ai.axis});
 
 			ai = liveAnims.back();
 			liveAnims.pop_back();
@@ -194,32 +199,22 @@ void CUnitScript::TickAnims(int tickRate, const TickAnimFunc& tickAnimFunc, Anim
 
 /**
  * @brief Called by the engine when we are registered as animating.
-          If we return false there are no active animations left.
+          Finished animations are removed; those with waiting listeners
+          are pushed to doneAnims so the engine can call AnimFinished.
  * @param deltaTime int delta time to update
- * @return true if there are still active animations
+ * @param doneAnims buffer shared by all (concurrently ticked) scripts
  */
-bool CUnitScript::Tick(int deltaTime)
+void CUnitScript::Tick(int deltaTime, DoneAnimBuffer& doneAnims)
 {
-	// vector of indexes of finished animations,
-	// so we can get rid of them in constant time
-	static AnimContainerType doneAnims[AMove + 1];
 	// tick-functions; these never change address
 	static constexpr TickAnimFunc tickAnimFuncs[AMove + 1] = {&CUnitScript::TickTurnAnim, &CUnitScript::TickSpinAnim, &CUnitScript::TickMoveAnim};
 
-	for (int animType = ATurn; animType <= AMove; animType++) {
-		TickAnims(1000 / deltaTime, tickAnimFuncs[animType], anims[animType], doneAnims[animType]);
-	}
+	// keeps the per-unit AnimFinished order identical to ticking order
+	unsigned int numDoneAnims = 0;
 
-	// Tell listeners to unblock, and remove finished animations from the unit/script.
 	for (int animType = ATurn; animType <= AMove; animType++) {
-		for (AnimInfo& ai: doneAnims[animType]) {
-			AnimFinished((AnimType) animType, ai.piece, ai.axis);
-		}
-
-		doneAnims[animType].clear();
+		TickAnims(1000 / deltaTime, (AnimType) animType, tickAnimFuncs[animType], doneAnims, numDoneAnims);
 	}
-
-	return (HaveAnimations());
 }
 
 
@@ -10,6 +10,7 @@
 
 #include "Rendering/Models/3DModel.h"
 #include "System/creg/creg_cond.h"
+#include "System/Threading/DeferredWriteBuffer.h"
 
 
 class CUnit;
@@ -58,6 +59,20 @@ protected:
 
 	typedef bool(CUnitScript::*TickAnimFunc)(int, LocalModelPiece&, AnimInfo&);
 
+public:
+	// finished animation that still has threads waiting on it
+	struct DoneAnimInfo {
+		CUnitScript* script;
+		AnimType type;
+		int piece;
+		int axis;
+	};
+
+	// keyed by (unit-ID, per-unit sequence number)
+	typedef DeferredWriteBuffer<DoneAnimInfo> DoneAnimBuffer;
+
+protected:
+
 	AnimContainerType anims[AMove + 1];
 
 
@@ -122,12 +137,14 @@ public:
 	      CUnit* GetUnit()       { return unit; }
 	const CUnit* GetUnit() const { return unit; }
 
-	bool Tick(int tickRate);
+	// steps all animations; only touches this script's pieces, so different
+	// instances may be ticked concurrently (AnimFinished is left to the caller)
+	void Tick(int deltaTime, DoneAnimBuffer& doneAnims);
 	// note: must copy-and-set here (LMP dirty flag, etc)
 	bool TickMoveAnim(int tickRate, LocalModelPiece& lmp, AnimInfo& ai) { float3 pos = lmp.GetPosition(); const bool ret = MoveToward(pos[ai.axis], ai.dest, ai.speed / tickRate); lmp.SetPosition(pos); return ret; }
 	bool TickTurnAnim(int tickRate, LocalModelPiece& lmp, AnimInfo& ai) { float3 rot = lmp.GetRotation(); const bool ret = TurnToward(rot[ai.axis], ai.dest, ai.speed / tickRate); lmp.SetRotation(rot); return ret; }
 	bool TickSpinAnim(int tickRate, LocalModelPiece& lmp, AnimInfo& ai) { float3 rot = lmp.GetRotation(); const bool ret = DoSpin(rot[ai.axis], ai.dest, ai.speed, ai.accel, tickRate); lmp.SetRotation(rot); return ret; }
-	void TickAnims(int tickRate, const TickAnimFunc& tickAnimFunc, AnimContainerType& liveAnims, AnimContainerType& doneAnims);
+	void TickAnims(int tickRate, AnimType animType, const TickAnimFunc& tickAnimFunc, DoneAnimBuffer& doneAnims, unsigned int& numDoneAnims);
 
 	// animation, used by CCobThread
 	void Spin(int piece, int axis, float speed, float accel);
@@ -13,6 +13,7 @@
 #include "Sim/Units/UnitHandler.h"
 #include "System/ContainerUtil.h"
 #include "System/SafeUtil.h"
+#include "System/Threading/ThreadPool.h"
 
 static CCobEngine gCobEngine;
 static CCobFileHandler gCobFileHandler;
@@ -28,8 +29,11 @@ CR_BIND(CUnitScriptEngine, )
 CR_REG_METADATA(CUnitScriptEngine, (
 	CR_MEMBER(animating),
 
-	// always null when saving
-	CR_IGNORED(currentScript)
+	// always empty when saving
+	CR_IGNORED(killedInstances),
+	CR_IGNORED(doneAnims),
+
+	CR_IGNORED(dispatchingDoneAnims)
 ))
 
 
@@ -99,18 +103,22 @@ void CUnitScriptEngine::ReloadScripts(const UnitDef* udef)
 
 void CUnitScriptEngine::AddInstance(CUnitScript* instance)
 {
-	if (instance == currentScript)
-		return;
-
 	spring::VectorInsertUnique(animating, instance/*, true*/);
 }
 
 void CUnitScriptEngine::RemoveInstance(CUnitScript* instance)
 {
-	if (instance == currentScript)
+	spring::VectorErase(animating, instance);
+}
+
+void CUnitScriptEngine::KillInstance(CUnitScript* instance)
+{
+	RemoveInstance(instance);
+
+	if (!dispatchingDoneAnims)
 		return;
 
-	spring::VectorErase(animating, instance);
+	killedInstances.push_back(instance);
 }
 
 
@@ -118,19 +126,27 @@ void CUnitScriptEngine::Tick(int deltaTime)
 {
 	cobEngine->Tick(deltaTime);
 
-	// tick all (COB or LUS) script instances that have registered themselves as animating
-	for (size_t i = 0; i < animating.size(); ) {
-		currentScript = animating[i];
+	// tick all (COB or LUS) script instances that have registered themselves as animating;
+	// stepping only writes to each instance's own pieces so this can run on the pool
+	for_mt(0, animating.size(), [&](const int i) {
+		animating[i]->Tick(deltaTime, doneAnims);
+	});
 
-		if (!currentScript->Tick(deltaTime)) {
-			animating[i] = animating.back();
-			animating.pop_back();
-			continue;
-		}
+	// tell listeners to unblock in unit-ID order; this may add or remove
+	// animations (and hence instances) so must happen on the sim thread
+	dispatchingDoneAnims = true;
 
-		i++;
-	}
+	doneAnims.Commit([&](uint64_t key, const CUnitScript::DoneAnimInfo& info) {
+		if (std::find(killedInstances.begin(), killedInstances.end(), info.script) != killedInstances.end())
+			return;
+
+		info.script->AnimFinished(info.type, info.piece, info.axis);
+	});
+
+	dispatchingDoneAnims = false;
+	killedInstances.clear();
 
-	currentScript = nullptr;
+	// drop instances that have no active animations left
+	animating.erase(std::remove_if(animating.begin(), animating.end(), [](const CUnitScript* s) { return !s->HaveAnimations(); }), animating.end());
 }
 
@@ -7,11 +7,11 @@
 
 #include <vector>
 
+#include "UnitScript.h"
 #include "System/creg/creg_cond.h"
 
 struct UnitDef;
 class CUnit;
-class CUnitScript;
 
 
 class CUnitScriptEngine
@@ -21,20 +21,28 @@ class CUnitScriptEngine
 public:
 	void AddInstance(CUnitScript* instance);
 	void RemoveInstance(CUnitScript* instance);
+	void KillInstance(CUnitScript* instance);
 	void ReloadScripts(const UnitDef* udef);
 
 	void Tick(int deltaTime);
 
 	void Init() { animating.reserve(256); }
-	void Kill() { animating.clear(); }
+	void Kill() { animating.clear(); killedInstances.clear(); doneAnims.Reset(); }
 
 	static void InitStatic();
 	static void KillStatic();
 
 private:
-	CUnitScript* currentScript = nullptr;
-
 	std::vector<CUnitScript*> animating;
+
+	// instances destroyed while <doneAnims> is being dispatched, e.g. by
+	// a LUS AnimFinished callback replacing another unit's script; their
+	// remaining entries are dropped
+	std::vector<const CUnitScript*> killedInstances;
+
+	CUnitScript::DoneAnimBuffer doneAnims;
+
+	bool dispatchingDoneAnims = false;
 };
 
 extern CUnitScriptEngine* unitScriptEngine;
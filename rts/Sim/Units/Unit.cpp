@@ -626,6 +626,18 @@ void CUnit::ForcedMove(const float3& newPos)
 	quadField.MovedUnit(this);
 }
 
+void CUnit::MovedPos()
+{
+	// no-op until the unit has been linked into the quadfield
+	quadField.MovedUnitPos(this);
+}
+
+void CUnit::MovedMidPos()
+{
+	// cached GetUnitsIn* queries test midPos
+	quadField.MovedUnitMidPos();
+}
+
 
 
 float3 CUnit::GetErrorVector(int argAllyTeam) const
@@ -909,7 +921,6 @@ void CUnit::UpdateResources()
 void CUnit::SetLosStatus(int at, unsigned short newStatus)
 {
 	const unsigned short currStatus = losStatus[at];
-	const unsigned short diffBits = (currStatus ^ newStatus);
 
 	// add to the state before running the callins
 	//
@@ -919,6 +930,16 @@ void CUnit::SetLosStatus(int at, unsigned short newStatus)
 	// without first clearing the IN{LOS, RADAR} bit
 	losStatus[at] |= newStatus;
 
+	LosStatusChanged(at, currStatus, newStatus);
+
+	// remove from the state after running the callins
+	losStatus[at] &= newStatus;
+}
+
+void CUnit::LosStatusChanged(int at, unsigned short prevStatus, unsigned short newStatus)
+{
+	const unsigned short diffBits = (prevStatus ^ newStatus);
+
 	if (diffBits) {
 		if (diffBits & LOS_INLOS) {
 			if (newStatus & LOS_INLOS) {
@@ -946,9 +967,6 @@ void CUnit::SetLosStatus(int at, unsigned short newStatus)
 			}
 		}
 	}
-
-	// remove from the state after running the callins
-	losStatus[at] &= newStatus;
 }
 
 
@@ -2902,6 +2920,7 @@ CR_REG_METADATA(CUnit, (
 	CR_IGNORED(los),
 	CR_MEMBER(losStatus),
 	CR_MEMBER(quads),
+	CR_MEMBER(quadUnitIndices),
 
 
 	CR_MEMBER(loadingTransportId),
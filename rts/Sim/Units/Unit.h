@@ -87,6 +87,8 @@ public:
 	void Deactivate();
 
 	void ForcedMove(const float3& newPos);
+	void MovedPos() override;
+	void MovedMidPos() override;
 
 	void DeleteScript();
 	void EnableScriptMoveType();
@@ -157,6 +159,10 @@ public:
 	bool IsInLosForAllyTeam(int allyTeam) const { return ((losStatus[allyTeam] & LOS_INLOS) != 0); }
 
 	void SetLosStatus(int allyTeam, unsigned short newStatus);
+	// as SetLosStatus, split for CLosStatusUpdater: changes the state first
+	// and runs the call-ins for it later
+	void CommitLosStatus(int allyTeam, unsigned short newStatus) { losStatus[allyTeam] = newStatus; }
+	void LosStatusChanged(int allyTeam, unsigned short prevStatus, unsigned short newStatus);
 	void UpdateLosStatus(int allyTeam);
 	unsigned short CalcLosStatus(int allyTeam) const;
 
@@ -297,6 +303,8 @@ public:
 
 	/// quads the unit is part of
 	std::vector<int> quads;
+	/// position of the unit in Quad::units of each of its quads, parallel to quads
+	std::vector<int> quadUnitIndices;
 
 	std::vector<TransportedUnit> transportedUnits;
 	// incoming projectiles for which flares can cause retargeting
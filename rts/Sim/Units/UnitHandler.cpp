@@ -4,6 +4,7 @@
 
 #include "UnitHandler.h"
 #include "Unit.h"
+#include "LosStatusUpdater.h"
 #include "UnitDefHandler.h"
 #include "UnitMemPool.h"
 #include "UnitTypes/Builder.h"
@@ -12,6 +13,7 @@
 
 #include "CommandAI/BuilderCAI.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Weapons/Weapon.h"
@@ -48,6 +50,9 @@ CR_REG_METADATA(CUnitHandler, (
 
 UnitMemPool unitMemPool;
 
+// scratch-state of UpdateUnitLosStatesMT; not serialized
+static CLosStatusUpdater<CUnit, unsigned char> losStatusUpdater(LOS_ALL_MASK_BITS, LOS_INLOS | LOS_INRADAR);
+
 CUnitHandler unitHandler;
 
 
@@ -342,6 +347,11 @@ void CUnitHandler::UpdateUnitMoveTypes()
 
 void CUnitHandler::UpdateUnitLosStates()
 {
+	if (modInfo.threadedUnitUpdates) {
+		UpdateUnitLosStatesMT();
+		return;
+	}
+
 	for (CUnit* unit: activeUnits) {
 		for (int at = 0; at < teamHandler.ActiveAllyTeams(); ++at) {
 			unit->UpdateLosStatus(at);
@@ -349,6 +359,15 @@ void CUnitHandler::UpdateUnitLosStates()
 	}
 }
 
+void CUnitHandler::UpdateUnitLosStatesMT()
+{
+	SCOPED_TIMER("Sim::Unit::LosStates");
+
+	// as the serial loop, but LOS call-ins are only dispatched after every
+	// unit's state has been updated
+	losStatusUpdater.Update(activeUnits, teamHandler.ActiveAllyTeams());
+}
+
 
 void CUnitHandler::SlowUpdateUnits()
 {
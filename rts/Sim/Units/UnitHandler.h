@@ -83,6 +83,7 @@ private:
 	void SlowUpdateUnits();
 	void UpdateUnitMoveTypes();
 	void UpdateUnitLosStates();
+	void UpdateUnitLosStatesMT();
 	void UpdateUnits();
 	void UpdateUnitWeapons();
 
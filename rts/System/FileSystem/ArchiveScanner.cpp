@@ -25,6 +25,7 @@
 #include "System/Threading/ThreadPool.h"
 #include "System/FileSystem/RapidHandler.h"
 #include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
 #include "System/Threading/SpringThreading.h"
 #include "System/UnorderedMap.hpp"
 
@@ -51,7 +52,7 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
  * but mapping them all, every time to make the list is)
  */
 
-constexpr static int INTERNAL_VER = 15;
+constexpr static int INTERNAL_VER = 17;
 
 
 /*
@@ -379,6 +380,13 @@ bool CArchiveScanner::ArchiveData::GetInfoValueBool(const std::string& key) cons
 static spring::recursive_mutex scannerMutex;
 static std::atomic<uint32_t> numScannedArchives{0};
 
+struct ScanScope {
+	 ScanScope(bool* b) { p = b; *p =  true; }
+	~ScanScope(       ) {        *p = false; }
+
+	bool* p = nullptr;
+};
+
 
 /*
  * CArchiveScanner
@@ -418,6 +426,7 @@ void CArchiveScanner::Clear()
 	brokenArchives.reserve(16);
 	brokenArchivesIndex.clear();
 	brokenArchivesIndex.reserve(16);
+	staleFileDigests.clear();
 	cachefile.clear();
 }
 
@@ -473,6 +482,8 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs)
 
 	isDirty = true;
 
+	const spring_time scanStartTime = spring_gettime();
+
 	// scan for all archives
 	for (const std::string& dir: scanDirs) {
 		if (!FileSystem::DirExists(dir))
@@ -498,12 +509,61 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs)
 		}
 	}*/
 
-	// Create archiveInfos etc. if not in cache already
+	struct ScanData {
+		std::string fullName;
+		unsigned modified;
+
+		ScanResult result;
+		ArchiveInfo ai;
+		BrokenArchive ba;
+	};
+
+	std::vector<ScanData> scanData;
+	scanData.reserve(foundArchives.size());
+
+	// skip everything that is still cached; this can remove stale
+	// entries and has to see the archives in their original order
 	for (const std::string& archive: foundArchives) {
-		ScanArchive(archive, false);
-	#if !defined(DEDICATED) && !defined(UNITSYNC)
-		Watchdog::ClearTimer(WDT_MAIN);
-	#endif
+		unsigned modifiedTime = 0;
+
+		if (CheckCachedData(archive, modifiedTime, false))
+			continue;
+
+		scanData.emplace_back();
+		scanData.back().fullName = archive;
+		scanData.back().modified = modifiedTime;
+	}
+
+	{
+		const ScanScope scanScope(&isInScan);
+
+		// create archiveInfos etc. for the new or changed archives,
+		// opening them and running their {mod,map}info.lua touches
+		// no scanner state
+		for_mt(0, scanData.size(), [&](const int i) {
+			ScanData& sd = scanData[i];
+			sd.result = ScanArchiveData(sd.fullName, sd.modified, sd.ai, sd.ba);
+
+			#if !defined(DEDICATED) && !defined(UNITSYNC)
+			Watchdog::ClearTimer(WDT_MAIN);
+			#endif
+		});
+	}
+
+	// merge sequentially, such that duplicate archives are resolved
+	// exactly as if each had been scanned in turn
+	for (ScanData& sd: scanData) {
+		unsigned modifiedTime = 0;
+
+		if (CheckCachedData(sd.fullName, modifiedTime, false))
+			continue;
+
+		AddScannedArchive(sd.fullName, sd.result, std::move(sd.ai), std::move(sd.ba));
+	}
+
+	if (!scanData.empty()) {
+		const float scanTime = (spring_gettime() - scanStartTime).toSecsf();
+		LOG("[AS::%s] scanned %u new or changed archives (%u total) in %.1fs (%.1f archives/s)", __func__, unsigned(scanData.size()), unsigned(foundArchives.size()), scanTime, scanData.size() / std::max(scanTime, 0.001f));
 	}
 
 	// Now we'll have to parse the replaces-stuff found in the mods
@@ -529,29 +589,58 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs)
 
 void CArchiveScanner::ScanDir(const std::string& curPath, std::deque<std::string>& foundArchives)
 {
-	std::deque<std::string> subDirs = {curPath};
-
+	std::vector<std::string> subDirs = {curPath};
+	std::vector< std::vector<std::string> > foundFiles;
+	std::vector<std::string> levelFiles;
+	std::vector<int> fileTypes;
+
+	// breadth-first, one level at a time; listing the directories and
+	// classifying their entries is done in parallel, merging happens
+	// in order so the result is identical to a sequential walk
 	while (!subDirs.empty()) {
-		const std::string& subDir = FileSystem::EnsurePathSepAtEnd(subDirs.front());
-		const std::vector<std::string>& foundFiles = dataDirsAccess.FindFiles(subDir, "*", FileQueryFlags::INCLUDE_DIRS);
+		foundFiles.clear();
+		foundFiles.resize(subDirs.size());
+
+		for_mt(0, subDirs.size(), [&](const int i) {
+			foundFiles[i] = dataDirsAccess.FindFiles(FileSystem::EnsurePathSepAtEnd(subDirs[i]), "*", FileQueryFlags::INCLUDE_DIRS);
+		});
+
+		levelFiles.clear();
+		subDirs.clear();
+
+		for (std::vector<std::string>& files: foundFiles) {
+			for (std::string& fileName: files) {
+				FileSystem::EnsureNoPathSepAtEnd(fileName);
+				levelFiles.emplace_back(std::move(fileName));
+			}
+		}
 
-		subDirs.pop_front();
+		fileTypes.clear();
+		fileTypes.resize(levelFiles.size(), 0);
 
-		for (const std::string& fileName: foundFiles) {
-			const std::string& fileNameNoSep = FileSystem::EnsureNoPathSepAtEnd(fileName);
+		for_mt(0, levelFiles.size(), [&](const int i) {
+			const std::string& fileNameNoSep = levelFiles[i];
 			const std::string& lcFilePath = StringToLower(FileSystem::GetDirectory(fileNameNoSep));
 
 			// Exclude archive files found inside directory archives (.sdd)
 			if (lcFilePath.find(".sdd") != std::string::npos)
-				continue;
+				return;
 
 			// Is this an archive we should look into?
 			if (archiveLoader.IsArchiveFile(fileNameNoSep)) {
-				foundArchives.push_front(fileNameNoSep); // push in reverse order!
-				continue;
+				fileTypes[i] = 1;
+				return;
 			}
 			if (FileSystem::DirExists(fileNameNoSep)) {
-				subDirs.push_back(fileNameNoSep);
+				fileTypes[i] = 2;
+			}
+		});
+
+		for (size_t i = 0; i < levelFiles.size(); i++) {
+			switch (fileTypes[i]) {
+				case 1: { foundArchives.push_front(std::move(levelFiles[i])); } break; // push in reverse order!
+				case 2: { subDirs.emplace_back(std::move(levelFiles[i])); } break;
+				default: {} break;
 			}
 		}
 	}
@@ -648,17 +737,23 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		return;
 
 	isDirty = true;
-	isInScan = true;
 
-	struct ScanScope {
-		 ScanScope(bool* b) { p = b; *p =  true; }
-		~ScanScope(       ) {        *p = false; }
+	const ScanScope scanScope(&isInScan);
 
-		bool* p = nullptr;
-	};
+	ArchiveInfo ai;
+	BrokenArchive ba;
 
-	const ScanScope scanScope(&isInScan);
+	const ScanResult scanResult = ScanArchiveData(fullName, modifiedTime, ai, ba);
+
+	if (scanResult == SCAN_RESULT_VALID)
+		ai.hashed = doChecksum && GetArchiveChecksum(fullName, ai);
+
+	AddScannedArchive(fullName, scanResult, std::move(ai), std::move(ba));
+}
 
+
+CArchiveScanner::ScanResult CArchiveScanner::ScanArchiveData(const std::string& fullName, unsigned modifiedTime, ArchiveInfo& ai, BrokenArchive& ba)
+{
 	const std::string& fname = FileSystem::GetFilename(fullName);
 	const std::string& fpath = FileSystem::GetDirectory(fullName);
 	const std::string& lcfn  = StringToLower(fname);
@@ -669,16 +764,12 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		LOG_L(L_WARNING, "[AS::%s] unable to open archive \"%s\"", __func__, fullName.c_str());
 
 		// record it as broken, so we don't need to look inside everytime
-		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
 		ba.name = lcfn;
 		ba.path = fpath;
 		ba.modified = modifiedTime;
 		ba.updated = true;
 		ba.problem = "Unable to open archive";
-
-		// does not count as a scan
-		// numScannedArchives += 1;
-		return;
+		return SCAN_RESULT_UNOPENED;
 	}
 
 	std::string error;
@@ -690,7 +781,6 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	const bool hasMapInfo = ar->FileExists("mapinfo.lua");
 
 
-	ArchiveInfo ai;
 	ArchiveData& ad = ai.archiveData;
 
 	// execute the respective .lua, otherwise assume this archive is a map
@@ -713,16 +803,12 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		LOG_L(L_WARNING, "[AS::%s] failed to scan \"%s\" (%s)", __func__, fullName.c_str(), error.c_str());
 
 		// mark archive as broken, so we don't need to look inside everytime
-		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
 		ba.name = lcfn;
 		ba.path = fpath;
 		ba.modified = modifiedTime;
 		ba.updated = true;
 		ba.problem = error;
-
-		// does count as a scan
-		numScannedArchives += 1;
-		return;
+		return SCAN_RESULT_BROKEN;
 	}
 
 	if (hasMapInfo || !arMapFile.empty()) {
@@ -763,12 +849,31 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 
 	ai.origName = fname;
 	ai.updated = true;
-	ai.hashed = doChecksum && GetArchiveChecksum(fullName, ai);
-
-	archiveInfosIndex.insert(lcfn, archiveInfos.size());
-	archiveInfos.emplace_back(std::move(ai));
+	return SCAN_RESULT_VALID;
+}
 
-	numScannedArchives += 1;
+void CArchiveScanner::AddScannedArchive(const std::string& fullName, ScanResult scanResult, ArchiveInfo&& ai, BrokenArchive&& ba)
+{
+	const std::string& lcfn = StringToLower(FileSystem::GetFilename(fullName));
+
+	switch (scanResult) {
+		case SCAN_RESULT_UNOPENED: {
+			// does not count as a scan
+			GetAddBrokenArchive(lcfn) = std::move(ba);
+		} break;
+		case SCAN_RESULT_BROKEN: {
+			GetAddBrokenArchive(lcfn) = std::move(ba);
+			numScannedArchives += 1;
+		} break;
+		case SCAN_RESULT_VALID: {
+			archiveInfosIndex.insert(lcfn, archiveInfos.size());
+			archiveInfos.emplace_back(std::move(ai));
+			numScannedArchives += 1;
+		} break;
+		default: {
+			assert(false);
+		} break;
+	}
 }
 
 
@@ -847,6 +952,10 @@ bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& mod
 	// st_mtime only reflects changes to the directory itself
 	// (not the contents)
 	//
+	// keep the file hashes, most files are usually unchanged
+	if (!ai.fileDigests.empty())
+		staleFileDigests[fileNameLower] = std::move(ai.fileDigests);
+
 	// remap replacement archive
 	if (aiIter->second != (archiveInfos.size() - 1)) {
 		archiveInfosIndex[StringToLower(rai.origName)] = aiIter->second;
@@ -873,7 +982,9 @@ bool CArchiveScanner::ScanArchiveLua(IArchive* ar, const std::string& fileName,
 	}
 
 	// NB: skips LuaConstGame::PushEntries(L) since that would invoke ScanArchive again
-	LuaParser p(std::string((char*)(buf.data()), buf.size()), SPRING_VFS_ZIP);
+	// runs concurrently for different archives, must stay unsynced so that
+	// math.random does not draw from gsRNG (LuaParser::Random)
+	LuaParser p(std::string((char*)(buf.data()), buf.size()), SPRING_VFS_ZIP, 0, {false});
 
 	if (!p.Execute()) {
 		err = "Error in " + fileName + ": " + p.GetErrorLog();
@@ -921,13 +1032,24 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 	if (ar == nullptr)
 		return false;
 
+	// hashes from the previous scan, if the archive was cached
+	std::vector<FileDigest> prevDigests = std::move(archiveInfo.fileDigests);
+
+	if (prevDigests.empty()) {
+		const auto iter = staleFileDigests.find(StringToLower(FileSystem::GetFilename(archiveName)));
+
+		if (iter != staleFileDigests.end()) {
+			prevDigests = std::move(iter->second);
+			staleFileDigests.erase(iter);
+		}
+	}
+
 	// load ignore list, and insert all files to check in lowercase format
 	std::unique_ptr<IFileFilter> ignore(CreateIgnoreFilter(ar.get()));
-	std::vector<std::string> fileNames;
-	std::vector<sha512::raw_digest> fileHashes;
+	std::vector<FileDigest> fileDigests;
+	std::vector<uint8_t> fileStamped;
 
-	fileNames.reserve(ar->NumFiles());
-	fileHashes.reserve(ar->NumFiles());
+	fileDigests.reserve(ar->NumFiles());
 
 	for (unsigned fid = 0; fid != ar->NumFiles(); ++fid) {
 		const std::pair<std::string, int>& info = ar->FileInfo(fid);
@@ -936,16 +1058,36 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 			continue;
 
 		// create case-insensitive hashes
-		fileNames.push_back(StringToLower(info.first));
-		fileHashes.emplace_back();
+		fileDigests.emplace_back();
+		fileDigests.back().name = StringToLower(info.first);
+		fileDigests.back().size = info.second;
 	}
 
 	// sort by filename
-	std::stable_sort(fileNames.begin(), fileNames.end());
+	std::stable_sort(fileDigests.begin(), fileDigests.end(), [](const FileDigest& a, const FileDigest& b) { return (a.name < b.name); });
+	fileStamped.resize(fileDigests.size(), 0);
+
+	std::atomic<uint32_t> numReused{0};
+
+	// compute hashes of the files, unless a stamped one is unchanged since the last scan
+	for_mt(0, fileDigests.size(), [&](const int i) {
+		FileDigest& fd = fileDigests[i];
+
+		const unsigned int fid = ar->FindFile(fd.name);
+		const auto pred = [](const FileDigest& a, const std::string& name) { return (a.name < name); };
+		const auto iter = std::lower_bound(prevDigests.begin(), prevDigests.end(), fd.name, pred);
+
+		std::fill(fd.digest.begin(), fd.digest.end(), 0);
+
+		if ((fileStamped[i] = ar->GetFileStamp(fid, fd.stamp))) {
+			if (iter != prevDigests.end() && iter->name == fd.name && iter->size == fd.size && iter->stamp == fd.stamp) {
+				fd.digest = iter->digest;
+				numReused += 1;
+				return;
+			}
+		}
 
-	// compute hashes of the files
-	for_mt(0, fileNames.size(), [&](const int i) {
-		ar->CalcHash(ar->FindFile(fileNames[i]), fileHashes[i].data());
+		ar->CalcHash(fid, fd.digest.data());
 
 		#if !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer(WDT_MAIN);
@@ -953,11 +1095,11 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 	});
 
 	// combine individual hashes, initialize to hash(name)
-	for (size_t i = 0; i < fileNames.size(); i++) {
-		sha512::calc_digest(reinterpret_cast<const uint8_t*>(fileNames[i].c_str()), fileNames[i].size(), archiveInfo.checksum);
+	for (size_t i = 0; i < fileDigests.size(); i++) {
+		sha512::calc_digest(reinterpret_cast<const uint8_t*>(fileDigests[i].name.c_str()), fileDigests[i].name.size(), archiveInfo.checksum);
 
 		for (uint8_t j = 0; j < sha512::SHA_LEN; j++) {
-			archiveInfo.checksum[j] ^= fileHashes[i][j];
+			archiveInfo.checksum[j] ^= fileDigests[i].digest[j];
 		}
 
 		#if !defined(DEDICATED) && !defined(UNITSYNC)
@@ -965,10 +1107,45 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 		#endif
 	}
 
+	// only stamped hashes can be validated later
+	for (size_t i = 0; i < fileDigests.size(); i++) {
+		if (!fileStamped[i])
+			continue;
+
+		archiveInfo.fileDigests.emplace_back(std::move(fileDigests[i]));
+	}
+
+	LOG_S(LOG_SECTION_ARCHIVESCANNER, "[AS::%s] \"%s\": reused %u of %u file hashes", __func__, archiveName.c_str(), numReused.load(), unsigned(fileDigests.size()));
 	return true;
 }
 
 
+static std::string GetDigestCacheFile(const std::string& cacheFile)
+{
+	// "ArchiveCache17.lua" -> "ArchiveCache17.digests"
+	return (cacheFile.substr(0, cacheFile.rfind('.')) + ".digests");
+}
+
+template<typename T> static bool ReadDigestValue(FILE* in, T& value) { return (fread(&value, sizeof(T), 1, in) == 1); }
+template<typename T> static bool WriteDigestValue(FILE* out, const T& value) { return (fwrite(&value, sizeof(T), 1, out) == 1); }
+
+static bool ReadDigestString(FILE* in, std::string& str)
+{
+	uint32_t len = 0;
+
+	if (!ReadDigestValue(in, len) || len > 4096)
+		return false;
+
+	str.resize(len);
+	return (len == 0 || fread(&str[0], len, 1, in) == 1);
+}
+
+static bool WriteDigestString(FILE* out, const std::string& str)
+{
+	return (WriteDigestValue(out, uint32_t(str.size())) && (str.empty() || fwrite(str.data(), str.size(), 1, out) == 1));
+}
+
+
 void CArchiveScanner::ReadCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
@@ -1024,7 +1201,7 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 
 		ai.updated = false;
 		ai.hashed = (memcmp(ai.checksum, tmp.checksum, sha512::SHA_LEN) != 0);
-
+		ai.fileDigests.clear();
 
 		ai.archiveData = CArchiveScanner::ArchiveData(archivedTbl, true);
 		if (ai.archiveData.IsMap()) {
@@ -1046,9 +1223,59 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 		ba.problem = curArchive.GetString("problem", "unknown");
 	}
 
+	ReadDigestCache(GetDigestCacheFile(filename));
+
 	isDirty = false;
 }
 
+
+void CArchiveScanner::ReadDigestCache(const std::string& filename)
+{
+	FILE* in = fopen(filename.c_str(), "rb");
+
+	// not an error, digests are only an optimization
+	if (in == nullptr)
+		return;
+
+	uint32_t ver = 0;
+	uint32_t numArchives = 0;
+
+	std::string archiveName;
+	std::vector<FileDigest> fileDigests;
+
+	const auto ReadArchive = [&]() {
+		uint32_t numFiles = 0;
+
+		// bounded, the file might be corrupt
+		if (!ReadDigestString(in, archiveName) || !ReadDigestValue(in, numFiles) || numFiles > (1 << 20))
+			return false;
+
+		fileDigests.clear();
+		fileDigests.resize(numFiles);
+
+		for (FileDigest& fd: fileDigests) {
+			if (!ReadDigestString(in, fd.name) || !ReadDigestValue(in, fd.size) || !ReadDigestValue(in, fd.stamp) || !ReadDigestValue(in, fd.digest))
+				return false;
+		}
+
+		return true;
+	};
+
+	if (ReadDigestValue(in, ver) && ver == INTERNAL_VER && ReadDigestValue(in, numArchives)) {
+		for (uint32_t i = 0; i < numArchives && ReadArchive(); i++) {
+			const auto iter = archiveInfosIndex.find(archiveName);
+
+			// archive no longer in the cache
+			if (iter == archiveInfosIndex.end())
+				continue;
+
+			archiveInfos[iter->second].fileDigests = std::move(fileDigests);
+		}
+	}
+
+	fclose(in);
+}
+
 static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
 {
 	if (str.empty())
@@ -1178,10 +1405,48 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 	if (fclose(out) == EOF)
 		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
 
+	WriteDigestCache(GetDigestCacheFile(filename));
+
 	isDirty = false;
 }
 
 
+void CArchiveScanner::WriteDigestCache(const std::string& filename) const
+{
+	// binary and in host byte-order, this is a local cache; as hex-strings
+	// in ArchiveCache.lua the digests of large games made up most of it
+	FILE* out = fopen(filename.c_str(), "wb");
+
+	if (out == nullptr) {
+		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
+		return;
+	}
+
+	const uint32_t numArchives = std::count_if(archiveInfos.begin(), archiveInfos.end(), [](const ArchiveInfo& ai) { return (!ai.fileDigests.empty()); });
+
+	bool ok = (WriteDigestValue(out, uint32_t(INTERNAL_VER)) && WriteDigestValue(out, numArchives));
+
+	for (const ArchiveInfo& ai: archiveInfos) {
+		if (ai.fileDigests.empty())
+			continue;
+
+		ok = ok && WriteDigestString(out, StringToLower(ai.origName));
+		ok = ok && WriteDigestValue(out, uint32_t(ai.fileDigests.size()));
+
+		for (const FileDigest& fd: ai.fileDigests) {
+			ok = ok && WriteDigestString(out, fd.name);
+			ok = ok && WriteDigestValue(out, fd.size);
+			ok = ok && WriteDigestValue(out, fd.stamp);
+			ok = ok && WriteDigestValue(out, fd.digest);
+		}
+	}
+
+	// a truncated file is rejected (partially) on the next read
+	if ((fclose(out) == EOF) || !ok)
+		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
+}
+
+
 static void sortByName(std::vector<CArchiveScanner::ArchiveData>& data)
 {
 	std::stable_sort(data.begin(), data.end(), [](const CArchiveScanner::ArchiveData& a, const CArchiveScanner::ArchiveData& b) {
@@ -157,6 +157,13 @@ public:
 
 
 private:
+	struct FileDigest {
+		std::string name;             // lower-case, relative to archive-root
+		uint32_t size = 0;
+		uint64_t stamp = 0;           // IArchive::GetFileStamp
+		sha512::raw_digest digest;
+	};
+
 	struct ArchiveInfo {
 		ArchiveInfo() {
 			memset(checksum, 0, sizeof(checksum));
@@ -169,6 +176,11 @@ private:
 
 		ArchiveData archiveData;
 
+		// hashes of the files that have a stamp, sorted by name; these
+		// survive changes to the archive and let GetArchiveChecksum skip
+		// rehashing unchanged files
+		std::vector<FileDigest> fileDigests;
+
 		uint32_t modified = 0;
 		uint32_t modifiedArchiveData = 0;
 		uint8_t checksum[sha512::SHA_LEN];
@@ -185,6 +197,12 @@ private:
 		bool updated = false;
 	};
 
+	enum ScanResult {
+		SCAN_RESULT_UNOPENED = 0,
+		SCAN_RESULT_BROKEN   = 1,
+		SCAN_RESULT_VALID    = 2,
+	};
+
 private:
 	ArchiveInfo& GetAddArchiveInfo(const std::string& lcfn);
 	BrokenArchive& GetAddBrokenArchive(const std::string& lcfn);
@@ -192,6 +210,13 @@ private:
 	void ScanDirs(const std::vector<std::string>& dirs);
 	void ScanDir(const std::string& curPath, std::deque<std::string>& foundArchives);
 
+	/**
+	 * Opens the archive and fills either ai or ba, does not touch any
+	 * scanner state and may therefore run on multiple threads at once.
+	 */
+	ScanResult ScanArchiveData(const std::string& fullName, unsigned modifiedTime, ArchiveInfo& ai, BrokenArchive& ba);
+	void AddScannedArchive(const std::string& fullName, ScanResult scanResult, ArchiveInfo&& ai, BrokenArchive&& ba);
+
 	/// scan mapinfo / modinfo lua files
 	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err);
 
@@ -204,6 +229,9 @@ private:
 
 	void ReadCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
+	/// per-file digests live in a binary side file, see WriteDigestCache
+	void ReadDigestCache(const std::string& filename);
+	void WriteDigestCache(const std::string& filename) const;
 
 	IFileFilter* CreateIgnoreFilter(IArchive* ar);
 
@@ -243,6 +271,9 @@ private:
 	std::vector<ArchiveInfo> archiveInfos;
 	std::vector<BrokenArchive> brokenArchives;
 
+	// file hashes of cached archives that were modified and are being rescanned
+	spring::unordered_map<std::string, std::vector<FileDigest>> staleFileDigests;
+
 	std::string cachefile;
 
 	bool isDirty = false;
@@ -13,12 +13,11 @@ CBufferedArchive::~CBufferedArchive()
 	if (cacheSize <= 1 || fileCount <= 1)
 		return;
 
-	LOG_L(L_INFO, "[%s][name=%s] %u bytes cached in %u files", __func__, archiveFile.c_str(), cacheSize, fileCount);
+	LOG_L(L_INFO, "[%s][name=%s] %u bytes cached in %u files", __func__, archiveFile.c_str(), cacheSize.load(), fileCount.load());
 }
 
 bool CBufferedArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
 	assert(IsFileId(fid));
 
 	int ret = 0;
@@ -38,29 +37,63 @@ bool CBufferedArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buff
 		return (ret == 1);
 	}
 
+	const FileBuffer& fb = GetCachedFile(fid, ret);
+
+	if (!fb.exists) {
+		LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s ret=%d size=" _STPF_, __func__, fid, archiveFile.c_str(), ret, fb.data->size());
+		return false;
+	}
+
+	if (buffer.size() != fb.data->size())
+		buffer.resize(fb.data->size());
+
+	// zero-copy access goes through GetFileView
+	std::copy(fb.data->begin(), fb.data->end(), buffer.begin());
+	return true;
+}
+
+bool CBufferedArchive::GetFileView(unsigned int fid, FileView& view)
+{
+	assert(IsFileId(fid));
+
+	if (GetFileViewImpl(fid, view))
+		return true;
+
+	// nothing to share, GetFile reads directly into the caller's buffer
+	if (noCache || !globalConfig.vfsCacheArchiveFiles)
+		return false;
+
+	int ret = 0;
+
+	const FileBuffer& fb = GetCachedFile(fid, ret);
+
+	if (!fb.exists || fb.data->empty())
+		return false;
+
+	view.data = fb.data->data();
+	view.size = fb.data->size();
+	view.handle = fb.data;
+	return true;
+}
+
+const CBufferedArchive::FileBuffer& CBufferedArchive::GetCachedFile(unsigned int fid, int& ret)
+{
 	// NumFiles is virtual, can't do this in ctor
-	if (cache.empty())
-		cache.resize(NumFiles());
+	std::call_once(cacheInitFlag, [&]() { cache.resize(NumFiles()); });
+
+	// buffers never change once populated and can be read without the lock
+	std::lock_guard<spring::mutex> lck(cacheLocks[fid % NUM_CACHE_LOCKS]);
 
 	FileBuffer& fb = cache.at(fid);
 
 	if (!fb.populated) {
-		fb.exists = ((ret = GetFileImpl(fid, fb.data)) == 1);
+		fb.data = std::make_shared< std::vector<std::uint8_t> >();
+		fb.exists = ((ret = GetFileImpl(fid, *fb.data)) == 1);
 		fb.populated = true;
 
-		cacheSize += fb.data.size();
+		cacheSize += fb.data->size();
 		fileCount += fb.exists;
 	}
 
-	if (!fb.exists) {
-		LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s ret=%d size=" _STPF_, __func__, fid, archiveFile.c_str(), ret, fb.data.size());
-		return false;
-	}
-
-	if (buffer.size() != fb.data.size())
-		buffer.resize(fb.data.size());
-
-	// TODO: zero-copy access
-	std::copy(fb.data.begin(), fb.data.end(), buffer.begin());
-	return true;
+	return fb;
 }
@@ -3,12 +3,19 @@
 #ifndef _BUFFERED_ARCHIVE_H
 #define _BUFFERED_ARCHIVE_H
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "IArchive.h"
 #include "System/Threading/SpringThreading.h"
 
 /**
- * Provides a helper implementation for archive types that can only uncompress
- * one file to memory at a time.
+ * Provides a helper implementation for archive types that uncompress whole
+ * files to memory, and caches the results.
+ * GetFileImpl may be called concurrently for different files, derived
+ * classes have to keep their decompression state per call or per thread.
  */
 class CBufferedArchive : public IArchive
 {
@@ -22,9 +29,16 @@ public:
 	virtual int GetType() const override { return ARCHIVE_TYPE_BUF; }
 
 	bool GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	/**
+	 * Maps the file if the archive type supports it, otherwise shares the
+	 * cached copy (only if caching is enabled).
+	 */
+	bool GetFileView(unsigned int fid, FileView& view) override;
 
 protected:
 	virtual int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) = 0;
+	// for files that are stored uncompressed, these bypass the cache
+	virtual bool GetFileViewImpl(unsigned int fid, FileView& view) { return false; }
 
 	struct FileBuffer {
 		FileBuffer() = default;
@@ -37,22 +51,26 @@ protected:
 		bool populated = false; // files may be empty (0 bytes)
 		bool exists = false;
 
-		std::vector<std::uint8_t> data;
+		// shared with the views handed out for this file
+		std::shared_ptr< std::vector<std::uint8_t> > data;
 	};
 
+	// caching must be enabled; populates the buffer on first access
+	const FileBuffer& GetCachedFile(unsigned int fid, int& ret);
+
+private:
+	// number of locks protecting the cache, file-ids are spread over them;
+	// a file is only decompressed once even if requested by many threads
+	static constexpr unsigned int NUM_CACHE_LOCKS = 64;
+
 	// indexed by file-id
 	std::vector<FileBuffer> cache;
-	// neither 7zip (.sd7) nor minizip (.sdz) are threadsafe
-	// zlib (used to extract pool archive .gz entries) should
-	// not need this, but currently each buffered GetFileImpl
-	// call is protected
-	spring::mutex archiveLock;
+	std::array<spring::mutex, NUM_CACHE_LOCKS> cacheLocks;
+	std::once_flag cacheInitFlag;
 
-private:
-	uint32_t cacheSize = 0;
-	uint32_t fileCount = 0;
+	std::atomic<uint32_t> cacheSize = {0};
+	std::atomic<uint32_t> fileCount = {0};
 
 	bool noCache = false;
 };
-
 #endif // _BUFFERED_ARCHIVE_H
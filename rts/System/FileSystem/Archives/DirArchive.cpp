@@ -5,9 +5,12 @@
 
 #include <assert.h>
 #include <fstream>
+#include <memory>
 
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileSystemAbstraction.h"
+#include "System/FileSystem/MappedFile.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/StringUtil.h"
 
@@ -63,6 +66,22 @@ bool CDirArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
 	return true;
 }
 
+bool CDirArchive::GetFileView(unsigned int fid, FileView& view)
+{
+	assert(IsFileId(fid));
+
+	std::shared_ptr<CMappedFile> file = std::make_shared<CMappedFile>(dataDirsAccess.LocateFile(dirName + searchFiles[fid]));
+
+	// also fails for empty files, which can not be mapped
+	if (!file->IsOpen())
+		return false;
+
+	view.data = file->GetData();
+	view.size = file->GetSize();
+	view.handle = std::move(file);
+	return true;
+}
+
 void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 {
 	assert(IsFileId(fid));
@@ -78,3 +97,13 @@ void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 		size = 0;
 	}
 }
+
+bool CDirArchive::GetFileStamp(unsigned int fid, uint64_t& stamp) const
+{
+	assert(IsFileId(fid));
+
+	// sub-second resolution, catches same-size edits made in quick succession;
+	// 0 if the file can not be stat'ed, never matches a cached stamp
+	stamp = FileSystemAbstraction::GetFileModificationTimeNs(dataDirsAccess.LocateFile(dirName + searchFiles[fid]));
+	return (stamp != 0);
+}
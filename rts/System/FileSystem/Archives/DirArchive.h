@@ -37,7 +37,9 @@ public:
 
 	unsigned int NumFiles() const override { return (searchFiles.size()); }
 	bool GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	bool GetFileView(unsigned int fid, FileView& view) override;
 	void FileInfo(unsigned int fid, std::string& name, int& size) const override;
+	bool GetFileStamp(unsigned int fid, uint64_t& stamp) const override;
 	const std::string& GetOrigFileName(unsigned int fid) const { return searchFiles[fid]; }
 
 private:
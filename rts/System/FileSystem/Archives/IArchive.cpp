@@ -17,7 +17,14 @@ unsigned int IArchive::FindFile(const std::string& filePath) const
 
 bool IArchive::CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN])
 {
-	// NOTE: should be possible to avoid a re-read for buffered archives
+	FileView view;
+
+	// buffered archives hand out their cached copy, no re-read
+	if (GetFileView(fid, view)) {
+		sha512::calc_digest(view.GetData(), view.GetSize(), hash);
+		return true;
+	}
+
 	std::vector<std::uint8_t> buffer;
 
 	if (!GetFile(fid, buffer))
@@ -41,3 +48,12 @@ bool IArchive::GetFile(const std::string& name, std::vector<std::uint8_t>& buffe
 	return true;
 }
 
+bool IArchive::GetFileView(const std::string& name, FileView& view)
+{
+	const unsigned int fid = FindFile(name);
+
+	if (!IsFileId(fid))
+		return false;
+
+	return (GetFileView(fid, view));
+}
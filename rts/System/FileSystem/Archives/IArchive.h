@@ -3,11 +3,13 @@
 #ifndef _ARCHIVE_BASE_H
 #define _ARCHIVE_BASE_H
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <cinttypes>
 
 #include "ArchiveTypes.h"
+#include "System/FileSystem/FileView.h"
 #include "System/Sync/SHA512.hpp"
 #include "System/UnorderedMap.hpp"
 
@@ -82,6 +84,22 @@ public:
 	 */
 	bool GetFile(const std::string& name, std::vector<std::uint8_t>& buffer);
 
+	/**
+	 * Provides the content of a file without copying it into a new buffer,
+	 * e.g. by memory-mapping it if it is stored uncompressed on disk.
+	 * Empty files are never returned as a view.
+	 * @param fid file ID in [0, NumFiles())
+	 * @param view on success, points to the contents of the file
+	 * @return false if the archive can not provide a view of this file,
+	 *   callers should fall back to GetFile in that case
+	 */
+	virtual bool GetFileView(unsigned int fid, FileView& view) { return false; }
+	/**
+	 * Provides the content of a file by its name without copying it.
+	 * @see GetFileView(unsigned int fid, FileView& view)
+	 */
+	bool GetFileView(const std::string& name, FileView& view);
+
 	std::pair<std::string, int> FileInfo(unsigned int fid) const {
 		std::pair<std::string, int> info;
 		FileInfo(fid, info.first, info.second);
@@ -121,10 +139,30 @@ public:
 	 * @return true if archive type can be packed solid (which is VERY slow when reading)
 	 */
 	virtual bool CheckForSolid() const { return false; }
+	/**
+	 * Decompresses the archive's contents ahead of use, for archive types
+	 * where reading everything at once is much cheaper than reading files
+	 * one by one (solid archives). Subsequent reads are served from memory.
+	 * @param progressFunc called after each decompressed unit, possibly
+	 *   from worker threads
+	 */
+	virtual void Prefetch(const std::function<void()>& progressFunc) {}
+	/**
+	 * Frees the memory held by Prefetch, once the data is no longer
+	 * needed in bulk. Later reads decompress on demand again.
+	 */
+	virtual void ReleasePrefetched() {}
 	/**
 	 * Fetches the (SHA512) hash of a file by its ID.
 	 */
 	virtual bool CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN]);
+	/**
+	 * Fetches a value that changes whenever the content of a file does,
+	 * without reading it (stored CRC32, or modification time in ns for
+	 * plain files). Lets the archive scanner reuse cached hashes.
+	 * @return false if the archive type can not provide one
+	 */
+	virtual bool GetFileStamp(unsigned int fid, uint64_t& stamp) const { return false; }
 
 
 protected:
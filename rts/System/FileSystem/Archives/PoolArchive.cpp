@@ -81,7 +81,6 @@ CPoolArchive::CPoolArchive(const std::string& name): CBufferedArchive(name)
 		f.name = std::move(std::string(c_name, length));
 
 		std::memcpy(&f.md5sum, &c_md5sum, sizeof(f.md5sum));
-		std::memset(&f.shasum, 0, sizeof(f.shasum));
 
 		f.crc32 = parse_uint32(c_crc32);
 		f.size = parse_uint32(c_size);
@@ -165,6 +164,5 @@ int CPoolArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffe
 		return 0;
 	}
 
-	sha512::calc_digest(buffer.data(), buffer.size(), f->shasum);
 	return 1;
 }
@@ -90,8 +90,9 @@ public:
 	}
 	bool CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN]) override {
 		assert(IsFileId(fid));
-		// FIXME: not calculated until GetFileImpl
-		memcpy(hash, &files[fid].shasum[0], sha512::SHA_LEN);
+		// pool files are content-addressed, their MD5 already identifies
+		// the content and hashing it avoids reading (and inflating) them
+		sha512::calc_digest(files[fid].md5sum, sizeof(files[fid].md5sum), hash);
 		return true;
 	}
 
@@ -112,7 +113,6 @@ protected:
 	struct FileData {
 		std::string name;
 		uint8_t md5sum[16];
-		uint8_t shasum[sha512::SHA_LEN];
 		uint32_t crc32;
 		uint32_t size;
 	};
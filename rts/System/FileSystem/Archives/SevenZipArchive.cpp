@@ -12,8 +12,10 @@ extern "C" {
 #include "lib/7z/7zCrc.h"
 }
 
+#include "System/MainDefines.h"
 #include "System/StringUtil.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 
 static Byte kUtf8Limits[5] = { 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
 static Bool Utf16_To_Utf8(char *dest, size_t *destLen, const UInt16 *src, size_t srcLen)
@@ -129,9 +131,6 @@ static inline std::string GetSystemErrorStr(WRes wres)
 
 CSevenZipArchive::CSevenZipArchive(const std::string& name):
 	CBufferedArchive(name, false),
-	blockIndex(0xFFFFFFFF),
-	outBuffer(nullptr),
-	outBufferSize(0),
 	tempBuf(nullptr),
 	tempBufSize(0),
 	isOpen(false)
@@ -143,22 +142,19 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 
 	SzArEx_Init(&db);
 
-	WRes wres = InFile_Open(&archiveStream.file, name.c_str());
-	if (wres) {
-		LOG_L(L_ERROR, "Error opening \"%s\": %s (%i)",
-				name.c_str(), GetSystemErrorStr(wres).c_str(), (int) wres);
+	// the first context also reads the archive database
+	contexts.emplace_back(new ExtractContext());
+
+	if (!OpenContext(contexts[0].get())) {
+		contexts.clear();
 		return;
 	}
 
-	FileInStream_CreateVTable(&archiveStream);
-	LookToRead_CreateVTable(&lookStream, False);
-
-	lookStream.realStream = &archiveStream.s;
-	LookToRead_Init(&lookStream);
+	freeContexts.push_back(contexts[0].get());
 
 	CrcGenerateTable();
 
-	SRes res = SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp);
+	SRes res = SzArEx_Open(&db, &contexts[0]->lookStream.s, &allocImp, &allocTempImp);
 	if (res == SZ_OK) {
 		isOpen = true;
 	} else {
@@ -174,9 +170,19 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 		folderUnpackSizes[fi] = SzFolder_GetUnpackSize(db.db.Folders + fi);
 	}
 
+	// files are laid out back to back in their block, in index order
+	std::vector<size_t> folderOffsets(db.db.NumFolders, 0);
+
 	// Get contents of archive and store name->int mapping
 	for (unsigned int i = 0; i < db.db.NumFiles; ++i) {
 		CSzFileItem* f = db.db.Files + i;
+
+		const UInt32 folderIndex = db.FileIndexToFolderIndexMap[i];
+		const size_t blockOffset = (folderIndex != ((UInt32)-1))? folderOffsets[folderIndex]: 0;
+
+		if (folderIndex != ((UInt32)-1))
+			folderOffsets[folderIndex] += f->Size;
+
 		if (!f->IsDir) {
 			int written = GetFileName(&db, i);
 			if (written<=0) {
@@ -195,8 +201,9 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 			fd.fp = i;
 			fd.size = f->Size;
 			fd.crc = (f->Size > 0) ? f->Crc: 0;
+			fd.folderIndex = folderIndex;
+			fd.blockOffset = blockOffset;
 
-			const UInt32 folderIndex = db.FileIndexToFolderIndexMap[i];
 			if (folderIndex == ((UInt32)-1)) {
 				// file has no folder assigned
 				fd.unpackedSize = f->Size;
@@ -218,11 +225,14 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 
 CSevenZipArchive::~CSevenZipArchive()
 {
-	if (outBuffer != nullptr)
-		IAlloc_Free(&allocImp, outBuffer);
+	const size_t blockCacheSize = CSolidBlockCache::GetInstance().Erase(this, false);
 
-	if (isOpen)
-		File_Close(&archiveStream.file);
+	if (blockCacheSize > 0)
+		LOG_L(L_INFO, "[%s][name=%s] " _STPF_ " bytes cached in solid blocks", __func__, archiveFile.c_str(), blockCacheSize);
+
+	for (const auto& ctx: contexts) {
+		FreeContext(ctx.get());
+	}
 
 	SzArEx_Free(&db, &allocImp);
 	SzFree(nullptr, tempBuf);
@@ -240,23 +250,252 @@ unsigned int CSevenZipArchive::NumFiles() const
 	return fileData.size();
 }
 
+bool CSevenZipArchive::OpenContext(ExtractContext* ctx)
+{
+	const WRes wres = InFile_Open(&ctx->archiveStream.file, archiveFile.c_str());
+
+	if (wres) {
+		LOG_L(L_ERROR, "Error opening \"%s\": %s (%i)", archiveFile.c_str(), GetSystemErrorStr(wres).c_str(), (int) wres);
+		return false;
+	}
+
+	FileInStream_CreateVTable(&ctx->archiveStream);
+	LookToRead_CreateVTable(&ctx->lookStream, False);
+
+	ctx->lookStream.realStream = &ctx->archiveStream.s;
+	LookToRead_Init(&ctx->lookStream);
+	return true;
+}
+
+void CSevenZipArchive::FreeContext(ExtractContext* ctx)
+{
+	if (ctx->outBuffer != nullptr)
+		IAlloc_Free(&allocImp, ctx->outBuffer);
+
+	File_Close(&ctx->archiveStream.file);
+
+	ctx->outBuffer = nullptr;
+	ctx->outBufferSize = 0;
+}
+
+CSevenZipArchive::ExtractContext* CSevenZipArchive::AcquireContext()
+{
+	std::lock_guard<spring::mutex> lck(contextLock);
+
+	if (!freeContexts.empty()) {
+		ExtractContext* ctx = freeContexts.back();
+		freeContexts.pop_back();
+		return ctx;
+	}
+
+	std::unique_ptr<ExtractContext> ctx(new ExtractContext());
+
+	if (!OpenContext(ctx.get()))
+		return nullptr;
+
+	contexts.push_back(std::move(ctx));
+	return (contexts.back().get());
+}
+
+void CSevenZipArchive::ReleaseContext(ExtractContext* ctx)
+{
+	std::lock_guard<spring::mutex> lck(contextLock);
+	freeContexts.push_back(ctx);
+}
+
+
+std::shared_ptr<const Byte> CSevenZipArchive::DecodeBlock(ExtractContext* ctx, unsigned int folderIndex, size_t& size)
+{
+	// extracting the block's first file decodes (and CRC-checks) all of it;
+	// the buffer is not the context's so it can outlive the next extraction
+	UInt32 blockIndex = 0xFFFFFFFF;
+	Byte* outBuffer = nullptr;
+	size_t outBufferSize = 0;
+
+	size_t offset;
+	size_t outSizeProcessed;
+
+	const SRes res = SzArEx_Extract(&db, &ctx->lookStream.s, db.FolderStartFileIndex[folderIndex], &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
+
+	if (res != SZ_OK) {
+		LOG_L(L_ERROR, "[7zArchive::%s] error decoding block %u of \"%s\": %s", __func__, folderIndex, archiveFile.c_str(), GetErrorStr(res));
+		IAlloc_Free(&allocImp, outBuffer);
+		return nullptr;
+	}
+
+	size = outBufferSize;
+	return std::shared_ptr<const Byte>(outBuffer, [](const Byte* p) { SzFree(nullptr, const_cast<Byte*>(p)); });
+}
+
+std::shared_ptr<const Byte> CSevenZipArchive::GetBlock(unsigned int folderIndex, size_t& size, bool prefetch)
+{
+	CSolidBlockCache& blockCache = CSolidBlockCache::GetInstance();
+
+	// blocks larger than the whole cache would evict everything else
+	if (SzFolder_GetUnpackSize(db.db.Folders + folderIndex) > blockCache.GetMaxSize())
+		return nullptr;
+
+	std::shared_ptr<const Byte> data = blockCache.Find(this, folderIndex, size);
+
+	if (data != nullptr)
+		return data;
+
+	// another thread may be decoding this block, wait and check again
+	std::lock_guard<spring::mutex> lck(blockDecodeLocks[folderIndex % NUM_BLOCK_LOCKS]);
+
+	if ((data = blockCache.Find(this, folderIndex, size)) != nullptr)
+		return data;
+
+	ExtractContext* ctx = AcquireContext();
+
+	if (ctx == nullptr)
+		return nullptr;
+
+	data = DecodeBlock(ctx, folderIndex, size);
+	ReleaseContext(ctx);
+
+	if (data != nullptr)
+		blockCache.Insert(this, folderIndex, data, size, prefetch);
+
+	return data;
+}
+
+const Byte* CSevenZipArchive::GetBlockFile(const FileData& fd, std::shared_ptr<const Byte>& block)
+{
+	if (fd.folderIndex == ((UInt32)-1))
+		return nullptr;
+
+	size_t blockSize = 0;
+
+	if ((block = GetBlock(fd.folderIndex, blockSize)) == nullptr)
+		return nullptr;
+
+	if ((fd.blockOffset + fd.size) > blockSize)
+		return nullptr;
+
+	const Byte* fileData = block.get() + fd.blockOffset;
+	const CSzFileItem* f = db.db.Files + fd.fp;
+
+	// decoding only checked the CRC of the block's first file
+	if (f->CrcDefined && CrcCalc(fileData, fd.size) != f->Crc) {
+		LOG_L(L_ERROR, "[7zArchive::%s] %s in \"%s\": %s", __func__, fd.origName.c_str(), archiveFile.c_str(), GetErrorStr(SZ_ERROR_CRC));
+		return nullptr;
+	}
+
+	return fileData;
+}
+
+
 int CSevenZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
 	assert(IsFileId(fid));
 
+	const FileData& fd = fileData[fid];
+
+	{
+		std::shared_ptr<const Byte> block;
+
+		const Byte* blockFile = GetBlockFile(fd, block);
+
+		if (blockFile != nullptr) {
+			buffer.assign(blockFile, blockFile + fd.size);
+			return 1;
+		}
+	}
+
+	ExtractContext* ctx = AcquireContext();
+
+	if (ctx == nullptr)
+		return 0;
+
 	// Get 7zip to decompress it
 	size_t offset;
 	size_t outSizeProcessed;
 
-	const SRes res = SzArEx_Extract(&db, &lookStream.s, fileData[fid].fp, &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
+	const SRes res = SzArEx_Extract(&db, &ctx->lookStream.s, fd.fp, &ctx->blockIndex, &ctx->outBuffer, &ctx->outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
 
 	if (res == SZ_OK) {
 		buffer.resize(outSizeProcessed);
-		memcpy(&buffer[0], (char*)outBuffer + offset, outSizeProcessed);
-		return 1;
+		memcpy(buffer.data(), (char*)ctx->outBuffer + offset, outSizeProcessed);
+	}
+
+	ReleaseContext(ctx);
+	return (res == SZ_OK);
+}
+
+bool CSevenZipArchive::GetFileViewImpl(unsigned int fid, FileView& view)
+{
+	assert(IsFileId(fid));
+
+	const FileData& fd = fileData[fid];
+
+	if (fd.size <= 0)
+		return false;
+
+	std::shared_ptr<const Byte> block;
+
+	const Byte* blockFile = GetBlockFile(fd, block);
+
+	if (blockFile == nullptr)
+		return false;
+
+	view.data = blockFile;
+	view.size = fd.size;
+	view.handle = std::move(block);
+	return true;
+}
+
+void CSevenZipArchive::Prefetch(const std::function<void()>& progressFunc)
+{
+	CSolidBlockCache& blockCache = CSolidBlockCache::GetInstance();
+
+	if (!isOpen || blockCache.GetMaxSize() == 0)
+		return;
+
+	std::vector<unsigned int> folders;
+	folders.reserve(db.db.NumFolders);
+
+	// the cache is shared, do not evict what other archives prefetched
+	const size_t freeSize = blockCache.GetMaxSize() - std::min(blockCache.GetSize(), blockCache.GetMaxSize());
+
+	size_t prefetchSize = 0;
+
+	// everything that fits into the cache; larger blocks are decoded on demand
+	for (unsigned int fi = 0; fi < db.db.NumFolders; fi++) {
+		const size_t unpackSize = SzFolder_GetUnpackSize(db.db.Folders + fi);
+
+		if (unpackSize == 0 || (prefetchSize + unpackSize) > freeSize)
+			continue;
+
+		folders.push_back(fi);
+		prefetchSize += unpackSize;
 	}
 
-	return 0;
+	if (folders.empty())
+		return;
+
+	// largest first, so no thread is left decoding a big block at the end
+	std::sort(folders.begin(), folders.end(), [&](unsigned int a, unsigned int b) {
+		return (SzFolder_GetUnpackSize(db.db.Folders + a) > SzFolder_GetUnpackSize(db.db.Folders + b));
+	});
+
+	for_mt(0, folders.size(), [&](const int i) {
+		size_t size = 0;
+		GetBlock(folders[i], size, true);
+		progressFunc();
+	});
+
+	LOG("[7zArchive::%s] prefetched " _STPF_ " solid blocks (" _STPF_ " bytes) of \"%s\"", __func__, folders.size(), prefetchSize, archiveFile.c_str());
+}
+
+void CSevenZipArchive::ReleasePrefetched()
+{
+	const size_t releasedSize = CSolidBlockCache::GetInstance().Erase(this, true);
+
+	if (releasedSize == 0)
+		return;
+
+	LOG("[7zArchive::%s] released " _STPF_ " bytes of prefetched solid blocks of \"%s\"", __func__, releasedSize, archiveFile.c_str());
 }
 
 void CSevenZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
@@ -285,11 +524,3 @@ bool CSevenZipArchive::HasLowReadingCost(unsigned int fid) const
 			|| (fd.packedSize <= COST_LIMIT_DISC_READ));
 }
 
-#if 0
-unsigned int CSevenZipArchive::GetCrc32(unsigned int fid)
-{
-	assert(IsFileId(fid));
-	return fileData[fid].crc;
-}
-#endif
-
@@ -10,6 +10,10 @@ extern "C" {
 
 #include "IArchiveFactory.h"
 #include "BufferedArchive.h"
+#include "SolidBlockCache.h"
+#include <array>
+#include <cassert>
+#include <memory>
 #include <vector>
 #include <string>
 #include "IArchive.h"
@@ -44,14 +48,49 @@ public:
 	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
 	void FileInfo(unsigned int fid, std::string& name, int& size) const override;
 	bool HasLowReadingCost(unsigned int fid) const override;
-	#if 0
-	unsigned GetCrc32(unsigned int fid);
-	#endif
+	void Prefetch(const std::function<void()>& progressFunc) override;
+	void ReleasePrefetched() override;
+	bool GetFileStamp(unsigned int fid, uint64_t& stamp) const override {
+		assert(IsFileId(fid));
+		stamp = fileData[fid].crc;
+		return true;
+	}
+
+protected:
+	// shares the file's part of the cached solid block
+	bool GetFileViewImpl(unsigned int fid, FileView& view) override;
 
 private:
-	UInt32 blockIndex;
-	Byte* outBuffer;
-	size_t outBufferSize;
+	/**
+	 * Stream and decoder state of one reader; the LZMA SDK keeps the last
+	 * decompressed solid block in outBuffer, and the stream has its own
+	 * file position. Contexts are pooled, every concurrent GetFileImpl
+	 * call uses a different one.
+	 */
+	struct ExtractContext {
+		CFileInStream archiveStream;
+		CLookToRead lookStream;
+
+		UInt32 blockIndex = 0xFFFFFFFF;
+		Byte* outBuffer = nullptr;
+		size_t outBufferSize = 0;
+	};
+
+	ExtractContext* AcquireContext();
+	void ReleaseContext(ExtractContext* ctx);
+
+	bool OpenContext(ExtractContext* ctx);
+	void FreeContext(ExtractContext* ctx);
+
+	std::shared_ptr<const Byte> DecodeBlock(ExtractContext* ctx, unsigned int folderIndex, size_t& size);
+	/**
+	 * Returns the fully decompressed solid block, decoding it if it is not
+	 * in the CSolidBlockCache; files in it are read by offset. A block is
+	 * decoded by one thread at a time, others wait for it.
+	 * @return nullptr if the block is too large for the cache (callers
+	 *   fall back to per-file extraction) or could not be decoded
+	 */
+	std::shared_ptr<const Byte> GetBlock(unsigned int folderIndex, size_t& size, bool prefetch = false);
 
 	/**
 	 * How much more unpacked data may be allowed in a solid block,
@@ -97,19 +136,41 @@ private:
 		 * @see #unpackedSize
 		 */
 		int packedSize;
+		/**
+		 * Solid block holding the file, -1 for empty files.
+		 */
+		unsigned int folderIndex;
+		/**
+		 * Offset of the file within its decompressed solid block.
+		 */
+		size_t blockOffset;
 	};
+
+	// points to the file's data within its cached block, nullptr if the
+	// block is not cacheable or the file's CRC does not match
+	const Byte* GetBlockFile(const FileData& fd, std::shared_ptr<const Byte>& block);
+
 	int GetFileName(const CSzArEx* db, int i);
 
 	std::vector<FileData> fileData;
 	UInt16 *tempBuf;
 	size_t tempBufSize;
 
-	CFileInStream archiveStream;
+	// read-only after construction, shared by all contexts
 	CSzArEx db;
-	CLookToRead lookStream;
 	ISzAlloc allocImp;
 	ISzAlloc allocTempImp;
 
+	std::vector< std::unique_ptr<ExtractContext> > contexts;
+	std::vector<ExtractContext*> freeContexts;
+
+	spring::mutex contextLock;
+
+	// serialize decoding of the same solid block, indexed by folder
+	static constexpr unsigned int NUM_BLOCK_LOCKS = 16;
+
+	std::array<spring::mutex, NUM_BLOCK_LOCKS> blockDecodeLocks;
+
 	bool isOpen;
 };
 
@@ -0,0 +1,81 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "SolidBlockCache.h"
+
+#include <algorithm>
+
+#include "System/GlobalConfig.h"
+
+
+CSolidBlockCache& CSolidBlockCache::GetInstance()
+{
+	static CSolidBlockCache cache(std::max(0, globalConfig.vfsSolidBlockCacheSize) * size_t(1024 * 1024));
+	return cache;
+}
+
+
+CSolidBlockCache::BlockData CSolidBlockCache::Find(const void* owner, unsigned int blockIdx, size_t& blockSize)
+{
+	std::lock_guard<spring::mutex> lck(mutex);
+
+	const auto iter = blocks.find({owner, blockIdx});
+
+	if (iter == blocks.end())
+		return nullptr;
+
+	blocksLRU.splice(blocksLRU.begin(), blocksLRU, iter->second);
+	blockSize = iter->second->size;
+	return iter->second->data;
+}
+
+void CSolidBlockCache::Insert(const void* owner, unsigned int blockIdx, const BlockData& data, size_t blockSize, bool prefetched)
+{
+	// would evict everything else
+	if (blockSize > maxSize)
+		return;
+
+	std::lock_guard<spring::mutex> lck(mutex);
+
+	if (blocks.find({owner, blockIdx}) != blocks.end())
+		return;
+
+	while (!blocksLRU.empty() && (size + blockSize) > maxSize) {
+		const Block& lruBlock = blocksLRU.back();
+
+		size -= lruBlock.size;
+		blocks.erase({lruBlock.owner, lruBlock.blockIdx});
+		blocksLRU.pop_back();
+	}
+
+	blocksLRU.push_front({owner, blockIdx, data, blockSize, prefetched});
+	blocks.emplace(BlockKey{owner, blockIdx}, blocksLRU.begin());
+
+	size += blockSize;
+}
+
+size_t CSolidBlockCache::Erase(const void* owner, bool prefetchedOnly)
+{
+	std::lock_guard<spring::mutex> lck(mutex);
+
+	size_t erasedSize = 0;
+
+	for (auto iter = blocksLRU.begin(); iter != blocksLRU.end(); ) {
+		if (iter->owner != owner || (prefetchedOnly && !iter->prefetched)) {
+			++iter;
+			continue;
+		}
+
+		erasedSize += iter->size;
+		blocks.erase({iter->owner, iter->blockIdx});
+		iter = blocksLRU.erase(iter);
+	}
+
+	size -= erasedSize;
+	return erasedSize;
+}
+
+size_t CSolidBlockCache::GetSize() const
+{
+	std::lock_guard<spring::mutex> lck(mutex);
+	return size;
+}
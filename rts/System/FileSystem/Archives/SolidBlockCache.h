@@ -0,0 +1,73 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _SOLID_BLOCK_CACHE_H
+#define _SOLID_BLOCK_CACHE_H
+
+#include <cinttypes>
+#include <list>
+#include <map>
+#include <memory>
+
+#include "System/Threading/SpringThreading.h"
+
+/**
+ * Decompressed solid blocks of all open 7z archives, kept in one LRU list
+ * until their total size exceeds the limit. Blocks are identified by their
+ * owning archive and index; views handed out keep an evicted block alive
+ * until they are released.
+ */
+class CSolidBlockCache
+{
+public:
+	typedef std::shared_ptr<const std::uint8_t> BlockData;
+
+	CSolidBlockCache(size_t maxSize): maxSize(maxSize) {}
+
+	/// the cache shared by all archives, sized by VFSSolidBlockCacheSize
+	static CSolidBlockCache& GetInstance();
+
+	/**
+	 * @return the block, nullptr if it is not cached; marks the block
+	 *   as most recently used
+	 */
+	BlockData Find(const void* owner, unsigned int blockIdx, size_t& size);
+	/**
+	 * Adds a block, evicting the least recently used ones of any owner
+	 * to make room. Blocks larger than the whole cache are not added.
+	 * @param prefetched whether the block was decoded ahead of use,
+	 *   see Erase
+	 */
+	void Insert(const void* owner, unsigned int blockIdx, const BlockData& data, size_t size, bool prefetched);
+	/**
+	 * Removes the blocks of an owner, or only the ones added prefetched.
+	 * @return the number of bytes freed
+	 */
+	size_t Erase(const void* owner, bool prefetchedOnly);
+
+	size_t GetSize() const;
+	size_t GetMaxSize() const { return maxSize; }
+
+private:
+	struct Block {
+		const void* owner;
+		unsigned int blockIdx;
+
+		BlockData data;
+		size_t size;
+
+		bool prefetched;
+	};
+
+	typedef std::pair<const void*, unsigned int> BlockKey;
+
+	// most recently used first
+	std::list<Block> blocksLRU;
+	std::map<BlockKey, std::list<Block>::iterator> blocks;
+
+	mutable spring::mutex mutex;
+
+	size_t size = 0;
+	const size_t maxSize;
+};
+
+#endif // _SOLID_BLOCK_CACHE_H
@@ -45,17 +45,23 @@ CZipArchive::CZipArchive(const std::string& archiveName): CBufferedArchive(archi
 		fd.size = info.uncompressed_size;
 		fd.origName = fName;
 		fd.crc = info.crc;
+		// only non-empty unencrypted entries stored without compression can be viewed
+		fd.dataOffset = (info.compression_method == 0 && (info.flag & 1) == 0 && info.uncompressed_size > 0)? 0: -1;
 		fileData.push_back(fd);
 		lcNameIndex[fLowerName] = fileData.size() - 1;
 	}
+
+	freeHandles.push_back(zip);
 }
 
 CZipArchive::~CZipArchive()
 {
-	if (zip != nullptr) {
-		unzClose(zip);
-		zip = nullptr;
+	// all readers are done, every handle is free again
+	for (unzFile handle: freeHandles) {
+		unzClose(handle);
 	}
+
+	zip = nullptr;
 }
 
 bool CZipArchive::IsOpen()
@@ -76,18 +82,32 @@ void CZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 	size = fileData[fid].size;
 }
 
-#if 0
-unsigned int CZipArchive::GetCrc32(unsigned int fid)
+unzFile CZipArchive::AcquireHandle()
 {
-	assert(IsFileId(fid));
+	{
+		std::lock_guard<spring::mutex> lck(handleLock);
+
+		if (!freeHandles.empty()) {
+			unzFile handle = freeHandles.back();
+			freeHandles.pop_back();
+			return handle;
+		}
+	}
 
-	return fileData[fid].crc;
+	// all handles are in use, open another one (re-reads the central directory)
+	return (unzOpen(archiveFile.c_str()));
 }
-#endif
+
+void CZipArchive::ReleaseHandle(unzFile handle)
+{
+	std::lock_guard<spring::mutex> lck(handleLock);
+	freeHandles.push_back(handle);
+}
+
 
 // To simplify things, files are always read completely into memory from
 // the zip-file, since zlib does not provide any way of reading more
-// than one file at a time
+// than one file at a time per handle
 int CZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
 	// Prevent opening files on missing/invalid archives
@@ -96,26 +116,91 @@ int CZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer
 
 	assert(IsFileId(fid));
 
-	unzGoToFilePos(zip, &fileData[fid].fp);
+	unzFile handle = AcquireHandle();
+
+	if (handle == nullptr)
+		return -4;
+
+	unzGoToFilePos(handle, &fileData[fid].fp);
 
 	unz_file_info fi;
-	unzGetCurrentFileInfo(zip, &fi, nullptr, 0, nullptr, 0, nullptr, 0);
+	unzGetCurrentFileInfo(handle, &fi, nullptr, 0, nullptr, 0, nullptr, 0);
 
-	if (unzOpenCurrentFile(zip) != UNZ_OK)
+	if (unzOpenCurrentFile(handle) != UNZ_OK) {
+		ReleaseHandle(handle);
 		return -3;
+	}
 
 	buffer.clear();
 	buffer.resize(fi.uncompressed_size);
 
 	int ret = 1;
 
-	if (!buffer.empty() && unzReadCurrentFile(zip, &buffer[0], fi.uncompressed_size) != fi.uncompressed_size)
+	if (!buffer.empty() && unzReadCurrentFile(handle, &buffer[0], fi.uncompressed_size) != fi.uncompressed_size)
 		ret -= 2;
-	if (unzCloseCurrentFile(zip) == UNZ_CRCERROR)
+	if (unzCloseCurrentFile(handle) == UNZ_CRCERROR)
 		ret -= 1;
 
+	ReleaseHandle(handle);
+
 	if (ret != 1)
 		buffer.clear();
 
 	return ret;
 }
+
+bool CZipArchive::GetFileViewImpl(unsigned int fid, FileView& view)
+{
+	if (zip == nullptr)
+		return false;
+
+	assert(IsFileId(fid));
+
+	std::lock_guard<spring::mutex> lck(handleLock);
+
+	FileData& fd = fileData[fid];
+
+	if (fd.dataOffset < 0)
+		return false;
+
+	if (fd.dataOffset == 0) {
+		// the local header has a variable length, its data-offset is only
+		// known after opening the entry (the CRC is not verified on views)
+		if (freeHandles.empty())
+			freeHandles.push_back(unzOpen(archiveFile.c_str()));
+
+		// stays in the free-list, readers can not acquire it while we hold the lock
+		unzFile handle = freeHandles.back();
+
+		if (handle == nullptr) {
+			freeHandles.pop_back();
+			return false;
+		}
+
+		fd.dataOffset = -1;
+
+		unzGoToFilePos(handle, &fd.fp);
+
+		if (unzOpenCurrentFile(handle) == UNZ_OK) {
+			fd.dataOffset = unzGetCurrentFileZStreamPos64(handle);
+			unzCloseCurrentFile(handle);
+		}
+
+		if (fd.dataOffset <= 0)
+			return ((fd.dataOffset = -1), false);
+	}
+
+	if (mappedFile == nullptr)
+		mappedFile = std::make_shared<CMappedFile>(archiveFile);
+
+	if (!mappedFile->IsOpen())
+		return false;
+
+	if (size_t(fd.dataOffset + fd.size) > mappedFile->GetSize())
+		return false;
+
+	view.data = mappedFile->GetData() + fd.dataOffset;
+	view.size = fd.size;
+	view.handle = mappedFile;
+	return true;
+}
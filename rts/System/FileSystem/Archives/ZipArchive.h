@@ -5,8 +5,11 @@
 
 #include "IArchiveFactory.h"
 #include "BufferedArchive.h"
+#include "System/FileSystem/MappedFile.h"
 #include "minizip/unzip.h"
 
+#include <cassert>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -39,9 +42,11 @@ public:
 
 	unsigned int NumFiles() const override;
 	void FileInfo(unsigned int fid, std::string& name, int& size) const override;
-	#if 0
-	unsigned int GetCrc32(unsigned int fid);
-	#endif
+	bool GetFileStamp(unsigned int fid, uint64_t& stamp) const override {
+		assert(IsFileId(fid));
+		stamp = fileData[fid].crc;
+		return true;
+	}
 
 protected:
 	unzFile zip;
@@ -51,10 +56,28 @@ protected:
 		int size;
 		std::string origName;
 		unsigned int crc;
+
+		// offset of the raw data of uncompressed (stored) entries,
+		// -1 if not stored and 0 if not yet looked up
+		int64_t dataOffset;
 	};
 	std::vector<FileData> fileData;
 
+	// whole archive, mapped on the first view request
+	std::shared_ptr<CMappedFile> mappedFile;
+
+	// minizip handles keep the current file's decompression state, each
+	// concurrent reader takes its own (zip itself is one of them)
+	std::vector<unzFile> freeHandles;
+
+	// protects freeHandles, mappedFile and FileData::dataOffset
+	spring::mutex handleLock;
+
+	unzFile AcquireHandle();
+	void ReleaseHandle(unzFile handle);
+
 	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	bool GetFileViewImpl(unsigned int fid, FileView& view) override;
 };
 
 #endif // _ZIP_ARCHIVE_H
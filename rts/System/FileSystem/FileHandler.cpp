@@ -92,7 +92,19 @@ bool CFileHandler::TryReadFromVFS(const string& fileName, int section)
 	if (vfsHandler == nullptr)
 		return (loadCode = -2, false);
 
-	if ((loadCode = vfsHandler->LoadFile(StringToLower(fileName), fileBuffer, (CVFSHandler::Section) section)) == 1) {
+	const std::string& lcFileName = StringToLower(fileName);
+
+	// mapped or cached archive contents need not be copied
+	if ((loadCode = vfsHandler->LoadFileView(lcFileName, fileView, (CVFSHandler::Section) section)) == 1) {
+		fileSize = fileView.GetSize();
+		return true;
+	}
+
+	// not in this section
+	if (loadCode < 0)
+		return false;
+
+	if ((loadCode = vfsHandler->LoadFile(lcFileName, fileBuffer, (CVFSHandler::Section) section)) == 1) {
 		// capacity can exceed size if FH was used to open more than one file
 		// assert(fileBuffer.size() == fileBuffer.capacity());
 
@@ -130,6 +142,18 @@ void CFileHandler::Close()
 
 	ifs.close();
 	fileBuffer.clear();
+	fileView.Clear();
+}
+
+
+std::vector<std::uint8_t>& CFileHandler::GetBuffer()
+{
+	if (!fileView.Empty()) {
+		fileBuffer.assign(fileView.GetData(), fileView.GetData() + fileView.GetSize());
+		fileView.Clear();
+	}
+
+	return fileBuffer;
 }
 
 
@@ -173,15 +197,14 @@ int CFileHandler::Read(void* buf, int length)
 		return ifs.gcount();
 	}
 
-	if (fileBuffer.empty())
+	if (!IsBuffered())
 		return 0;
 
 	if ((length + filePos) > fileSize)
 		length = fileSize - filePos;
 
 	if (length > 0) {
-		assert(fileBuffer.size() >= (filePos + length));
-		memcpy(buf, &fileBuffer[filePos], length);
+		memcpy(buf, GetBufferData() + filePos, length);
 		filePos += length;
 	}
 
@@ -218,7 +241,7 @@ void CFileHandler::Seek(int length, std::ios_base::seekdir where)
 		ifs.seekg(length, where);
 		return;
 	}
-	if (fileBuffer.empty())
+	if (!IsBuffered())
 		return;
 
 	switch (where) {
@@ -234,7 +257,7 @@ bool CFileHandler::Eof() const
 	if (ifs.is_open())
 		return ifs.eof();
 
-	if (!fileBuffer.empty())
+	if (IsBuffered())
 		return (filePos >= fileSize);
 
 	return true;
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <cinttypes>
 
+#include "FileView.h"
 #include "VFSModes.h"
 
 /**
@@ -37,7 +38,7 @@ public:
 	// true if any of TryReadFrom{RawFS,PWD,VFS} succeed
 	bool FileExists() const { return (fileSize >= 0); }
 	// true if (and only if) TryReadFromVFS succeeds
-	bool IsBuffered() const { return (!fileBuffer.empty()); }
+	bool IsBuffered() const { return (!fileView.Empty() || !fileBuffer.empty()); }
 
 	bool Eof() const;
 	int GetPos();
@@ -49,7 +50,10 @@ public:
 	static std::string GetFileAbsolutePath(const std::string& filePath, const std::string& modes);
 	static std::string GetArchiveContainingFile(const std::string& filePath, const std::string& modes);
 
-	std::vector<std::uint8_t>& GetBuffer() { return fileBuffer; }
+	// copies the contents if they are only viewed, prefer GetBufferData
+	std::vector<std::uint8_t>& GetBuffer();
+	// contents of a buffered file, valid until Close
+	const std::uint8_t* GetBufferData() const { return ((fileView.Empty())? fileBuffer.data(): fileView.GetData()); }
 
 	static bool InReadDir(const std::string& path);
 	static bool InWriteDir(const std::string& path);
@@ -78,6 +82,8 @@ protected:
 	std::string fileName;
 	std::ifstream ifs;
 	std::vector<std::uint8_t> fileBuffer;
+	// set instead of fileBuffer if the archive could provide a view
+	FileView fileView;
 
 	int filePos = 0;
 	int fileSize = -1;
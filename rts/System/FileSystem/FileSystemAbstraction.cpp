@@ -185,6 +185,35 @@ unsigned int FileSystemAbstraction::GetFileModificationTime(const std::string& f
 	return info.st_mtime;
 }
 
+std::uint64_t FileSystemAbstraction::GetFileModificationTimeNs(const std::string& file)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+
+	if (!GetFileAttributesExA(file.c_str(), GetFileExInfoStandard, &info)) {
+		LOG_L(L_WARNING, "[FSA::%s] error getting last modification time of file '%s'", __func__, file.c_str());
+		return 0;
+	}
+
+	// 100ns intervals since 1601-01-01
+	const std::uint64_t ft = (std::uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+	return ((ft - 116444736000000000ull) * 100);
+#else
+	struct stat info;
+
+	if (stat(file.c_str(), &info) != 0) {
+		LOG_L(L_WARNING, "[FSA::%s] error '%s' getting last modification time of file '%s'", __func__, strerror(errno), file.c_str());
+		return 0;
+	}
+
+	#ifdef __APPLE__
+	return (std::uint64_t(info.st_mtimespec.tv_sec) * 1000000000ull + info.st_mtimespec.tv_nsec);
+	#else
+	return (std::uint64_t(info.st_mtim.tv_sec) * 1000000000ull + info.st_mtim.tv_nsec);
+	#endif
+#endif
+}
+
 std::string FileSystemAbstraction::GetFileModificationDate(const std::string& file)
 {
 	const std::time_t t = GetFileModificationTime(file);
@@ -3,6 +3,7 @@
 #ifndef FILE_SYSTEM_ABSTACTION_H
 #define FILE_SYSTEM_ABSTACTION_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -109,6 +110,13 @@ public:
 	static bool IsReadableFile(const std::string& file);
 
 	static unsigned int GetFileModificationTime(const std::string& file);
+	/**
+	 * Returns the last file modification time in nanoseconds since the
+	 * epoch, with the (sub-second) resolution the file-system provides.
+	 *
+	 * @return the last file modification time, or 0 on error
+	 */
+	static std::uint64_t GetFileModificationTimeNs(const std::string& file);
 	/**
 	 * Returns the last file modification time formatted in a sort friendly
 	 * way, with second resolution.
@@ -0,0 +1,36 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef FILE_VIEW_H
+#define FILE_VIEW_H
+
+#include <cinttypes>
+#include <memory>
+
+/**
+ * Read-only window onto the contents of a file that were not copied for
+ * the caller, e.g. a memory-mapped region or an archive's cached buffer.
+ * The handle owns whatever backs the data; copies of a view share it, so
+ * the data stays valid until the last copy is cleared or destroyed, even
+ * if the archive it came from is closed before that.
+ */
+struct FileView {
+public:
+	bool Empty() const { return (size == 0); }
+
+	void Clear() {
+		data = nullptr;
+		size = 0;
+		handle.reset();
+	}
+
+	const std::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+public:
+	const std::uint8_t* data = nullptr;
+	size_t size = 0;
+
+	std::shared_ptr<const void> handle;
+};
+
+#endif // FILE_VIEW_H
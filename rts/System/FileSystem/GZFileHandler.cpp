@@ -67,6 +67,10 @@ bool CGZFileHandler::UncompressBuffer()
 	std::vector<std::uint8_t> compressed;
 	std::swap(compressed, fileBuffer);
 
+	// compressed data was either viewed or copied from the VFS
+	const std::uint8_t* compressedData = (fileView.Empty())? compressed.data(): fileView.GetData();
+	const size_t compressedSize = (fileView.Empty())? compressed.size(): fileView.GetSize();
+
 
 	z_stream zstream;
 	zstream.opaque = Z_NULL;
@@ -77,8 +81,8 @@ bool CGZFileHandler::UncompressBuffer()
 	//+16 marks it's a gzip header
 	inflateInit2(&zstream, 15 + 16);
 
-	zstream.next_in   = &compressed[0];
-	zstream.avail_in  = compressed.size();
+	zstream.next_in   = const_cast<std::uint8_t*>(compressedData);
+	zstream.avail_in  = compressedSize;
 
 	std::uint8_t unzipBuffer[BUFFER_SIZE];
 
@@ -88,6 +92,7 @@ bool CGZFileHandler::UncompressBuffer()
 		const int ret = inflate(&zstream, Z_NO_FLUSH);
 		if (ret != Z_OK) {
 			fileBuffer.clear();
+			fileView.Clear();
 			fileSize = -1;
 			return false;
 		}
@@ -100,6 +105,7 @@ bool CGZFileHandler::UncompressBuffer()
 	}
 
 	inflateEnd(&zstream);
+	fileView.Clear();
 
 
 	fileSize = fileBuffer.size();
@@ -0,0 +1,118 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#include "System/Platform/Win/win32.h"
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+CMappedFile& CMappedFile::operator = (CMappedFile&& f)
+{
+	if (this == &f)
+		return *this;
+
+	Close();
+
+	std::swap(data, f.data);
+	std::swap(size, f.size);
+
+	#ifdef _WIN32
+	std::swap(fileHandle, f.fileHandle);
+	std::swap(mapHandle, f.mapHandle);
+	#endif
+
+	return *this;
+}
+
+
+bool CMappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	#ifdef _WIN32
+	HANDLE fh = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	HANDLE mh = nullptr;
+	LARGE_INTEGER fs;
+
+	if (fh == INVALID_HANDLE_VALUE)
+		return false;
+
+	// zero-length files can not be mapped
+	if (!GetFileSizeEx(fh, &fs) || fs.QuadPart <= 0) {
+		CloseHandle(fh);
+		return false;
+	}
+
+	if ((mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr)) == nullptr) {
+		CloseHandle(fh);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+
+	if (view == nullptr) {
+		CloseHandle(mh);
+		CloseHandle(fh);
+		return false;
+	}
+
+	data = reinterpret_cast<const std::uint8_t*>(view);
+	size = fs.QuadPart;
+
+	fileHandle = fh;
+	mapHandle = mh;
+
+	#else
+
+	const int fd = open(filePath.c_str(), O_RDONLY);
+	struct stat fs;
+
+	if (fd < 0)
+		return false;
+
+	// zero-length files can not be mapped
+	if (fstat(fd, &fs) != 0 || fs.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	const void* view = mmap(nullptr, fs.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// the mapping holds its own reference to the file
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	data = reinterpret_cast<const std::uint8_t*>(view);
+	size = fs.st_size;
+	#endif
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (data == nullptr)
+		return;
+
+	#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mapHandle);
+	CloseHandle(fileHandle);
+
+	fileHandle = nullptr;
+	mapHandle = nullptr;
+	#else
+	munmap(const_cast<std::uint8_t*>(data), size);
+	#endif
+
+	data = nullptr;
+	size = 0;
+}
@@ -0,0 +1,43 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cinttypes>
+#include <string>
+#include <utility>
+
+/**
+ * Read-only memory-mapping of an entire native (non-VFS) file.
+ * The OS pages the contents in on demand, nothing is copied up front.
+ * The mapped data stays valid for the lifetime of the object.
+ */
+class CMappedFile {
+public:
+	CMappedFile(const std::string& filePath) { Open(filePath); }
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile(CMappedFile&& f) { *this = std::move(f); }
+	~CMappedFile() { Close(); }
+
+	CMappedFile& operator = (const CMappedFile&) = delete;
+	CMappedFile& operator = (CMappedFile&& f);
+
+	bool Open(const std::string& filePath);
+	void Close();
+
+	bool IsOpen() const { return (data != nullptr); }
+
+	const std::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const std::uint8_t* data = nullptr;
+	size_t size = 0;
+
+	#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mapHandle = nullptr;
+	#endif
+};
+
+#endif // MAPPED_FILE_H
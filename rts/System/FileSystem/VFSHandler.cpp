@@ -236,6 +236,30 @@ bool CVFSHandler::RemoveArchive(const std::string& archiveName)
 }
 
 
+void CVFSHandler::PrefetchArchives(const std::function<void()>& progressFunc)
+{
+	std::lock_guard<decltype(vfsMutex)> lck(vfsMutex);
+
+	for (const auto& p: archives) {
+		if (p.second == nullptr)
+			continue;
+
+		(p.second)->Prefetch(progressFunc);
+	}
+}
+
+void CVFSHandler::ReleasePrefetchedArchives()
+{
+	std::lock_guard<decltype(vfsMutex)> lck(vfsMutex);
+
+	for (const auto& p: archives) {
+		if (p.second == nullptr)
+			continue;
+
+		(p.second)->ReleasePrefetched();
+	}
+}
+
 
 void CVFSHandler::DeleteArchives()
 {
@@ -296,6 +320,20 @@ int CVFSHandler::LoadFile(const std::string& filePath, std::vector<std::uint8_t>
 	return (fileData.ar->GetFile(normalizedPath, buffer));
 }
 
+int CVFSHandler::LoadFileView(const std::string& filePath, FileView& view, Section section)
+{
+	LOG_L(L_DEBUG, "[VFSH::%s(filePath=\"%s\", section=%d)]", __func__, filePath.c_str(), section);
+
+	const std::string& normalizedPath = GetNormalizedPath(filePath);
+	const FileData& fileData = GetFileData(normalizedPath, section);
+
+	if (fileData.ar == nullptr)
+		return -1;
+
+	// 0 or 1
+	return (fileData.ar->GetFileView(normalizedPath, view));
+}
+
 int CVFSHandler::FileExists(const std::string& filePath, Section section)
 {
 	LOG_L(L_DEBUG, "[VFSH::%s(filePath=\"%s\", section=%d)]", __func__, filePath.c_str(), section);
@@ -4,10 +4,12 @@
 #define _VFS_HANDLER_H
 
 #include <array>
+#include <functional>
 #include <string>
 #include <vector>
 #include <cinttypes>
 
+#include "FileView.h"
 #include "System/UnorderedMap.hpp"
 
 class IArchive;
@@ -85,6 +87,16 @@ public:
 	 */
 	int LoadFile(const std::string& filePath, std::vector<std::uint8_t>& buffer, Section section);
 
+	/**
+	 * Provides the contents of a file from within the VFS without copying,
+	 * if its archive supports this (see IArchive::GetFileView).
+	 * @param filePath raw file path, for example "maps/myMap.smf",
+	 *   case-insensitive
+	 * @return 1 if the file exists in the VFS and a view was created,
+	 *   0 if it exists but has to be loaded with LoadFile, -1 otherwise
+	 */
+	int LoadFileView(const std::string& filePath, FileView& view, Section section);
+
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
@@ -124,6 +136,17 @@ public:
 	 */
 	bool RemoveArchive(const std::string& archiveName);
 
+	/**
+	 * Decompresses the contents of all loaded solid archives in bulk,
+	 * so the reads while loading a game are served from memory.
+	 * @see IArchive::Prefetch
+	 */
+	void PrefetchArchives(const std::function<void()>& progressFunc);
+	/**
+	 * Frees the prefetched contents once loading is done.
+	 * @see IArchive::ReleasePrefetched
+	 */
+	void ReleasePrefetchedArchives();
 
 	void DeleteArchives();
 
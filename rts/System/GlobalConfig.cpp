@@ -59,6 +59,9 @@ CONFIG(bool, UseNetMessageSmoothingBuffer).defaultValue(true);
 
 CONFIG(bool, LuaWritableConfigFile).defaultValue(true);
 CONFIG(bool, VFSCacheArchiveFiles).defaultValue(true);
+CONFIG(int, VFSSolidBlockCacheSize)
+	.defaultValue(256)
+	.minimumValue(0);
 
 
 void GlobalConfig::Init()
@@ -87,6 +90,7 @@ void GlobalConfig::Init()
 	useNetMessageSmoothingBuffer = configHandler->GetBool("UseNetMessageSmoothingBuffer");
 	luaWritableConfigFile = configHandler->GetBool("LuaWritableConfigFile");
 	vfsCacheArchiveFiles = configHandler->GetBool("VFSCacheArchiveFiles");
+	vfsSolidBlockCacheSize = configHandler->GetInt("VFSSolidBlockCacheSize");
 
 	teamHighlight = configHandler->GetInt("TeamHighlight");
 }
@@ -106,6 +106,14 @@ public:
 	 */
 	bool vfsCacheArchiveFiles = true;
 
+	/**
+	 * @brief vfsSolidBlockCacheSize
+	 *
+	 * Memory limit in MB for decompressed solid blocks, shared by all 7z
+	 * archives; 0 disables the block cache and prefetching of game archives
+	 */
+	int vfsSolidBlockCacheSize = 256;
+
 
 	/**
 	 * @brief teamHighlight
@@ -76,6 +76,7 @@ void CGameStateCollector::Serialize(creg::ISerializer* s)
 	s->SerializeObjectInstance(readMap, readMap->GetClass());
 	s->SerializeObjectInstance(&quadField, quadField.GetClass());
 	s->SerializeObjectInstance(&unitHandler, unitHandler.GetClass());
+	CSplitLuaHandle::SerializeUnitParamSlots(s);
 	s->SerializeObjectInstance(cobEngine, cobEngine->GetClass());
 	s->SerializeObjectInstance(unitScriptEngine, unitScriptEngine->GetClass());
 	s->SerializeObjectInstance(&CNullUnitScript::value, CNullUnitScript::value.GetClass());
@@ -154,6 +155,14 @@ static void ReadString(std::istream& s, std::string& str)
 }
 
 
+static void CollectLuaGarbage(CSplitLuaHandle* handle)
+{
+	if ((handle == nullptr) || !handle->syncedLuaHandle.IsValid())
+		return;
+
+	lua_gc(handle->syncedLuaHandle.GetLuaGCState(), LUA_GCCOLLECT, 0);
+}
+
 static void SaveLuaState(CSplitLuaHandle* handle, creg::COutputStreamSerializer& os, std::stringstream& oss)
 {
 	CLuaStateCollector lsc;
@@ -161,7 +170,6 @@ static void SaveLuaState(CSplitLuaHandle* handle, creg::COutputStreamSerializer&
 	if (lsc.valid) {
 		lsc.L = handle->syncedLuaHandle.GetLuaState();
 		lsc.L_GC = handle->syncedLuaHandle.GetLuaGCState();
-		lua_gc(lsc.L_GC, LUA_GCCOLLECT, 0);
 	}
 	os.SavePackage(&oss, &lsc, lsc.GetClass());
 }
@@ -188,51 +196,67 @@ static void LoadLuaState(CSplitLuaHandle* handle, creg::CInputStreamSerializer&
 }
 
 
-void CCregLoadSaveHandler::SaveGame(const std::string& path)
+void CCregLoadSaveHandler::CollectSyncedLuaGarbage()
+{
+	CollectLuaGarbage(luaGaia);
+	CollectLuaGarbage(luaRules);
+}
+
+bool CCregLoadSaveHandler::SaveGameData(std::stringstream& oss)
 {
 #ifdef USING_CREG
-	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
+	// must stay the only change to synced state, see CGame::SaveDemoKeyFrame
+	CollectSyncedLuaGarbage();
 
-	try {
-		std::stringstream oss;
+	// write our own header. SavePackage() will add its own
+	WriteString(oss, SpringVersion::GetSync());
+	WriteString(oss, gameSetup->setupText);
+	WriteString(oss, modName);
+	WriteString(oss, mapName);
 
-		// write our own header. SavePackage() will add its own
-		WriteString(oss, SpringVersion::GetSync());
-		WriteString(oss, gameSetup->setupText);
-		WriteString(oss, modName);
-		WriteString(oss, mapName);
+	creg::COutputStreamSerializer os;
 
+	// save lua state first as lua unit scripts depend on it
+	const int luaStart = oss.tellp();
+	SaveLuaState(luaGaia, os, oss);
+	SaveLuaState(luaRules, os, oss);
+	PrintSize("Lua", ((int)oss.tellp()) - luaStart);
 
-		{
-			creg::COutputStreamSerializer os;
+	// save creg state
+	const int gameStart = oss.tellp();
+	CGameStateCollector gsc;
+	os.SavePackage(&oss, &gsc, gsc.GetClass());
+	PrintSize("Game", ((int)oss.tellp()) - gameStart);
 
-			// save lua state first as lua unit scripts depend on it
-			const int luaStart = oss.tellp();
-			SaveLuaState(luaGaia, os, oss);
-			SaveLuaState(luaRules, os, oss);
-			PrintSize("Lua", ((int)oss.tellp()) - luaStart);
 
-			// save creg state
-			const int gameStart = oss.tellp();
-			CGameStateCollector gsc;
-			os.SavePackage(&oss, &gsc, gsc.GetClass());
-			PrintSize("Game", ((int)oss.tellp()) - gameStart);
+	// save AI state
+	const int aiStart = oss.tellp();
 
+	for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
+		std::stringstream aiData;
+		eoh->Save(&aiData, ai.first);
 
-			// save AI state
-			const int aiStart = oss.tellp();
+		std::streamsize aiSize = aiData.tellp();
+		os.SerializeInt(&aiSize, sizeof(aiSize));
+		if (aiSize > 0)
+			oss << aiData.rdbuf();
+	}
+	PrintSize("AIs", ((int)oss.tellp()) - aiStart);
+	return true;
+#else //USING_CREG
+	return false;
+#endif //USING_CREG
+}
 
-			for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
-				std::stringstream aiData;
-				eoh->Save(&aiData, ai.first);
+void CCregLoadSaveHandler::SaveGame(const std::string& path)
+{
+#ifdef USING_CREG
+	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
 
-				std::streamsize aiSize = aiData.tellp();
-				os.SerializeInt(&aiSize, sizeof(aiSize));
-				if (aiSize > 0)
-					oss << aiData.rdbuf();
-			}
-			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
-		}
+	try {
+		std::stringstream oss;
+
+		SaveGameData(oss);
 
 		{
 			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
@@ -312,6 +336,32 @@ void CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 	CGameSetup::LoadSavedScript(path, scriptText);
 }
 
+bool CCregLoadSaveHandler::LoadGameData(std::string&& data)
+{
+	iss.clear();
+	iss.str(std::move(data));
+
+	std::string saveVersion;
+	std::string saveScript;
+	std::string saveModName;
+	std::string saveMapName;
+
+	// header is only checked, the game was started from the same script
+	ReadString(iss, saveVersion);
+	ReadString(iss, saveScript);
+	ReadString(iss, saveModName);
+	ReadString(iss, saveMapName);
+
+	if (saveVersion != SpringVersion::GetSync()) {
+		LOG_L(L_ERROR, "[LSH::%s] state was saved by a different engine version: %s", __func__, saveVersion.c_str());
+		iss.str("");
+		return false;
+	}
+
+	LoadGame();
+	return true;
+}
+
 /// this should be called on frame 0 when the game has started
 void CCregLoadSaveHandler::LoadGame()
 {
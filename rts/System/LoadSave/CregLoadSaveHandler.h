@@ -17,6 +17,13 @@ public:
 	void LoadGameStartInfo(const std::string& path);
 	void LoadGame();
 
+	/// serialize the running game to memory, used for demo keyframes
+	bool SaveGameData(std::stringstream& oss);
+	/// the synced-state side effect of SaveGameData
+	static void CollectSyncedLuaGarbage();
+	/// restore an in-memory state from SaveGameData into the running game
+	bool LoadGameData(std::string&& data);
+
 protected:
 	std::stringstream iss;
 };
@@ -0,0 +1,313 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_INDEXED_STREAM_H
+#define DEMO_INDEXED_STREAM_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "demofile.h"
+
+
+/**
+ * @brief index of an indexed demo container while it is being recorded
+ * @see demofile.h
+ */
+struct DemoIndexedData {
+public:
+	void AddFrame(int frameNum, std::uint64_t streamOffset) {
+		DemoIndexedFrame frame;
+		frame.frameNum = frameNum;
+		frame.unused = 0;
+		frame.streamOffset = streamOffset;
+
+		frames.push_back(frame);
+	}
+
+	/// compresses <state>, returns false (adding nothing) if that fails
+	bool AddKeyFrame(int frameNum, std::uint64_t streamOffset, const std::string& state) {
+		DemoIndexedKeyFrame keyFrame;
+		std::string compressedState(compressBound(state.size()), 0);
+		uLongf compressedSize = compressedState.size();
+
+		// taken on the sim thread, trade size for speed
+		if (compress2(reinterpret_cast<Bytef*>(&compressedState[0]), &compressedSize, reinterpret_cast<const Bytef*>(state.data()), state.size(), Z_BEST_SPEED) != Z_OK)
+			return false;
+
+		compressedState.resize(compressedSize);
+
+		keyFrame.frameNum = frameNum;
+		keyFrame.compressedSize = compressedSize;
+		keyFrame.rawSize = state.size();
+		keyFrame.streamOffset = streamOffset;
+		keyFrame.fileOffset = 0;
+
+		keyFrames.push_back(keyFrame);
+		keyFrameData.emplace_back(std::move(compressedState));
+		return true;
+	}
+
+	/// writes the container holding <stream>, consumes the index
+	bool Write(FILE* file, const std::string& stream, unsigned int blockSize) {
+		DemoIndexedFileHeader header;
+		memset(&header, 0, sizeof(header));
+		strcpy(header.magic, DEMOFILE_INDEXED_MAGIC);
+		header.version = DEMOFILE_INDEXED_VERSION;
+		header.headerSize = sizeof(header);
+		header.blockSize = blockSize;
+		header.numFrames = frames.size();
+		header.numKeyFrames = keyFrames.size();
+		header.streamSize = stream.size();
+
+		std::vector<DemoIndexedBlock> blocks;
+		std::vector<Bytef> blockData(compressBound(blockSize));
+
+		blocks.reserve((stream.size() + blockSize - 1) / blockSize);
+
+		// placeholder, rewritten once the table offsets are known
+		if (fwrite(&header, sizeof(header), 1, file) != 1)
+			return false;
+
+		std::uint64_t fileOffset = sizeof(header);
+
+		for (size_t pos = 0; pos < stream.size(); pos += blockSize) {
+			DemoIndexedBlock block;
+			uLongf compressedSize = blockData.size();
+
+			block.fileOffset = fileOffset;
+			block.rawSize = std::min(stream.size() - pos, size_t(blockSize));
+
+			if (compress2(blockData.data(), &compressedSize, reinterpret_cast<const Bytef*>(stream.data() + pos), block.rawSize, Z_BEST_COMPRESSION) != Z_OK)
+				return false;
+			if (fwrite(blockData.data(), compressedSize, 1, file) != 1)
+				return false;
+
+			block.compressedSize = compressedSize;
+			fileOffset += compressedSize;
+			blocks.push_back(block);
+		}
+
+		for (size_t i = 0; i < keyFrames.size(); i++) {
+			keyFrames[i].fileOffset = fileOffset;
+
+			if (fwrite(keyFrameData[i].data(), keyFrameData[i].size(), 1, file) != 1)
+				return false;
+
+			fileOffset += keyFrameData[i].size();
+		}
+
+		header.numBlocks = blocks.size();
+		header.tablesOffset = fileOffset;
+
+		// to little endian
+		for (DemoIndexedBlock& block: blocks) {
+			block.swab();
+		}
+		for (DemoIndexedFrame& frame: frames) {
+			frame.swab();
+		}
+		for (DemoIndexedKeyFrame& keyFrame: keyFrames) {
+			keyFrame.swab();
+		}
+
+		fwrite(blocks.data(), sizeof(DemoIndexedBlock), blocks.size(), file);
+		fwrite(frames.data(), sizeof(DemoIndexedFrame), frames.size(), file);
+		fwrite(keyFrames.data(), sizeof(DemoIndexedKeyFrame), keyFrames.size(), file);
+
+		header.swab();
+		fseek(file, 0, SEEK_SET);
+
+		frames.clear();
+		keyFrames.clear();
+		keyFrameData.clear();
+		return (fwrite(&header, sizeof(header), 1, file) == 1 && ferror(file) == 0);
+	}
+
+public:
+	std::vector<DemoIndexedFrame> frames;
+	std::vector<DemoIndexedKeyFrame> keyFrames;
+	std::vector<std::string> keyFrameData; // compressed
+};
+
+
+
+/**
+ * @brief random-access reader of the plain demo stream in an indexed container
+ *
+ * FileType has to provide Read(void*, int), Seek(int) and FileSize() with
+ * the semantics of CFileHandler's; a template so the tests can read from
+ * an in-memory file.
+ */
+template<typename FileType>
+class CDemoIndexedStream {
+public:
+	/**
+	 * @return false if <file> is an indexed container with a corrupt index;
+	 *   true for valid containers and for any other (non-indexed) file
+	 */
+	bool Open(FileType* file) {
+		demoFile = file;
+
+		memset(&header, 0, sizeof(header));
+		demoFile->Read(&header, sizeof(header));
+		demoFile->Seek(0);
+
+		if (memcmp(header.magic, DEMOFILE_INDEXED_MAGIC, sizeof(header.magic)) != 0)
+			return true;
+
+		header.swab();
+
+		if (header.version != DEMOFILE_INDEXED_VERSION || header.headerSize != sizeof(header))
+			return false;
+		if (header.blockSize == 0 || header.tablesOffset >= std::uint64_t(demoFile->FileSize()))
+			return false;
+
+		blocks.resize(header.numBlocks);
+		frames.resize(header.numFrames);
+		keyFrames.resize(header.numKeyFrames);
+
+		demoFile->Seek(int(header.tablesOffset));
+
+		const int blocksSize = blocks.size() * sizeof(DemoIndexedBlock);
+		const int framesSize = frames.size() * sizeof(DemoIndexedFrame);
+		const int keyFramesSize = keyFrames.size() * sizeof(DemoIndexedKeyFrame);
+
+		if (demoFile->Read(blocks.data(), blocksSize) != blocksSize)
+			return false;
+		if (demoFile->Read(frames.data(), framesSize) != framesSize)
+			return false;
+		if (demoFile->Read(keyFrames.data(), keyFramesSize) != keyFramesSize)
+			return false;
+
+		for (DemoIndexedBlock& block: blocks) {
+			block.swab();
+		}
+		for (DemoIndexedFrame& frame: frames) {
+			frame.swab();
+		}
+		for (DemoIndexedKeyFrame& keyFrame: keyFrames) {
+			keyFrame.swab();
+		}
+
+		return (isIndexed = !blocks.empty());
+	}
+
+	bool IsIndexed() const { return isIndexed; }
+
+	const DemoIndexedFileHeader& GetHeader() const { return header; }
+	const std::vector<DemoIndexedFrame>& GetFrames() const { return frames; }
+	const std::vector<DemoIndexedKeyFrame>& GetKeyFrames() const { return keyFrames; }
+
+	/// the last keyframe in (minFrameNum, maxFrameNum], or nullptr
+	const DemoIndexedKeyFrame* FindKeyFrame(int minFrameNum, int maxFrameNum) const {
+		// keyframes are sorted by frame, prefer the one closest to maxFrameNum
+		for (auto iter = keyFrames.rbegin(); iter != keyFrames.rend(); ++iter) {
+			if (iter->frameNum > maxFrameNum)
+				continue;
+			if (iter->frameNum <= minFrameNum)
+				break;
+
+			return &(*iter);
+		}
+
+		return nullptr;
+	}
+
+	bool ReadKeyFrame(const DemoIndexedKeyFrame& keyFrame, std::string& data) {
+		compressedData.resize(keyFrame.compressedSize);
+		data.resize(keyFrame.rawSize);
+
+		demoFile->Seek(int(keyFrame.fileOffset));
+
+		if (demoFile->Read(compressedData.data(), compressedData.size()) != int(compressedData.size()))
+			return false;
+
+		uLongf rawSize = data.size();
+
+		if (uncompress(reinterpret_cast<Bytef*>(&data[0]), &rawSize, reinterpret_cast<const Bytef*>(compressedData.data()), compressedData.size()) != Z_OK)
+			return false;
+
+		return (rawSize == keyFrame.rawSize);
+	}
+
+
+	int Read(void* buf, int length) {
+		int numRead = 0;
+
+		while (numRead < length && streamPos < header.streamSize) {
+			if (!LoadBlock(streamPos / header.blockSize))
+				break;
+
+			const std::uint64_t blockPos = streamPos % header.blockSize;
+			const int numCopy = std::min(std::uint64_t(length - numRead), blockData.size() - blockPos);
+
+			memcpy(static_cast<char*>(buf) + numRead, blockData.data() + blockPos, numCopy);
+
+			numRead += numCopy;
+			streamPos += numCopy;
+		}
+
+		return numRead;
+	}
+
+	// header is packed, std::min must not bind a reference to its member
+	void Seek(std::uint64_t pos) { streamPos = std::min(pos, std::uint64_t(header.streamSize)); }
+
+	std::uint64_t GetPos() const { return streamPos; }
+	std::uint64_t GetSize() const { return header.streamSize; }
+
+	bool Eof() const { return (streamPos >= header.streamSize); }
+
+private:
+	bool LoadBlock(unsigned int blockIdx) {
+		if (blockIdx == curBlockIdx)
+			return true;
+		if (blockIdx >= blocks.size())
+			return false;
+
+		const DemoIndexedBlock& block = blocks[blockIdx];
+
+		compressedData.resize(block.compressedSize);
+		blockData.resize(block.rawSize);
+
+		demoFile->Seek(int(block.fileOffset));
+
+		if (demoFile->Read(compressedData.data(), compressedData.size()) != int(compressedData.size()))
+			return false;
+
+		uLongf rawSize = blockData.size();
+
+		if (uncompress(reinterpret_cast<Bytef*>(blockData.data()), &rawSize, reinterpret_cast<const Bytef*>(compressedData.data()), compressedData.size()) != Z_OK)
+			return false;
+		if (rawSize != block.rawSize)
+			return false;
+
+		curBlockIdx = blockIdx;
+		return true;
+	}
+
+private:
+	FileType* demoFile = nullptr;
+
+	bool isIndexed = false;
+
+	DemoIndexedFileHeader header;
+
+	std::vector<DemoIndexedBlock> blocks;
+	std::vector<DemoIndexedFrame> frames;
+	std::vector<DemoIndexedKeyFrame> keyFrames;
+
+	// one block is decompressed at a time, reading is mostly sequential
+	std::vector<char> blockData;
+	std::vector<char> compressedData;
+
+	unsigned int curBlockIdx = -1u;
+	std::uint64_t streamPos = 0;
+};
+
+#endif
@@ -13,6 +13,7 @@ CONFIG(bool, DisableDemoVersionCheck).defaultValue(false).description("Allow to
 #include "System/Net/RawPacket.h"
 #include "Game/GameVersion.h"
 
+#include <algorithm>
 #include <climits>
 #include <stdexcept>
 #include <cassert>
@@ -21,14 +22,24 @@ CONFIG(bool, DisableDemoVersionCheck).defaultValue(false).description("Allow to
 
 CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDemo(new CGZFileHandler(filename, SPRING_VFS_PWD_ALL))
 {
-	if (FileSystem::GetExtension(filename) != "sdfz")
+	// .sdfz are gzip'ed streams, .sdfi indexed containers (see demofile.h)
+	if (FileSystem::GetExtension(filename) != "sdfz" && FileSystem::GetExtension(filename) != "sdfi")
 		throw content_error("Unknown demo extension: " + FileSystem::GetExtension(filename));
 
 	// file not found -> exception
 	if (!playbackDemo->FileExists())
 		throw user_error("Demofile not found: " + filename);
 
-	playbackDemo->Read((char*)&fileHeader, sizeof(fileHeader));
+	// gzread passes the (uncompressed) indexed container through as-is
+	if (!indexedStream.Open(playbackDemo))
+		throw content_error("Demofile " + filename + " has a corrupt index");
+
+	if (indexedStream.IsIndexed()) {
+		const DemoIndexedFileHeader& indexHeader = indexedStream.GetHeader();
+		LOG("[DemoReader::%s] \"%s\": %u blocks, %u indexed frames, %u keyframes", __func__, filename.c_str(), indexHeader.numBlocks, indexHeader.numFrames, indexHeader.numKeyFrames);
+	}
+
+	StreamRead((char*)&fileHeader, sizeof(fileHeader));
 	fileHeader.swab();
 
 	if (memcmp(fileHeader.magic, DEMOFILE_MAGIC, sizeof(fileHeader.magic)) != 0
@@ -53,19 +64,18 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 
 	if (fileHeader.scriptSize != 0) {
 		std::vector<char> buf(fileHeader.scriptSize);
-		playbackDemo->Read(buf.data(), buf.size());
+		StreamRead(buf.data(), buf.size());
 		setupScript = std::string(buf.data(), buf.size());
 	}
 
-	playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader));
+	StreamRead((char*)&chunkHeader, sizeof(chunkHeader));
 	chunkHeader.swab();
 
 	demoTimeOffset = curTime - chunkHeader.modGameTime - 0.1f;
 	nextDemoReadTime = curTime - 0.01f;
 
-	const long curPos = playbackDemo->GetPos();
-	playbackDemo->Seek(0, std::ios::end);
-	playbackDemoSize = playbackDemo->GetPos();
+	const std::uint64_t curPos = StreamPos();
+	playbackDemoSize = StreamSize();
 
 	if (fileHeader.demoStreamSize != 0) {
 		bytesRemaining = fileHeader.demoStreamSize;
@@ -76,7 +86,6 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 		// (if this had still used CFileHandler that would have been easier ;-))
 		bytesRemaining = playbackDemoSize - curPos;
 	}
-	playbackDemo->Seek(curPos);
 }
 
 
@@ -96,7 +105,7 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 	// check needed
 	if (readTime >= nextDemoReadTime) {
 		netcode::RawPacket* buf = new netcode::RawPacket(chunkHeader.length);
-		if (playbackDemo->Read((char*)(buf->data), chunkHeader.length) < chunkHeader.length) {
+		if (StreamRead((char*)(buf->data), chunkHeader.length) < chunkHeader.length) {
 			delete buf;
 			bytesRemaining = 0;
 			return nullptr;
@@ -105,7 +114,7 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 
 		if (!ReachedEnd()) {
 			// read next chunk header
-			if (playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader)) {
+			if (StreamRead((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader)) {
 				delete buf;
 				bytesRemaining = 0;
 				return nullptr;
@@ -126,7 +135,7 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 
 bool CDemoReader::ReachedEnd()
 {
-	return (bytesRemaining <= 0 || playbackDemo->Eof() || (playbackDemo->GetPos() > playbackDemoSize));
+	return (bytesRemaining <= 0 || StreamEof() || (std::int64_t(StreamPos()) > playbackDemoSize));
 }
 
 
@@ -136,8 +145,8 @@ void CDemoReader::LoadStats()
 	if (fileHeader.demoStreamSize == 0)
 		return;
 
-	const int curPos = playbackDemo->GetPos();
-	playbackDemo->Seek(fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
+	const std::uint64_t curPos = StreamPos();
+	StreamSeek(fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
 
 	winningAllyTeams.clear();
 	playerStats.clear();
@@ -145,13 +154,13 @@ void CDemoReader::LoadStats()
 
 	for (int allyTeamNum = 0; allyTeamNum < fileHeader.winningAllyTeamsSize; ++allyTeamNum) {
 		unsigned char winnerAllyTeam;
-		playbackDemo->Read((char*) &winnerAllyTeam, sizeof(unsigned char));
+		StreamRead((char*) &winnerAllyTeam, sizeof(unsigned char));
 		winningAllyTeams.push_back(winnerAllyTeam);
 	}
 
 	for (int playerNum = 0; playerNum < fileHeader.numPlayers; ++playerNum) {
 		PlayerStatistics buf;
-		playbackDemo->Read(reinterpret_cast<char*>(&buf), sizeof(PlayerStatistics));
+		StreamRead(reinterpret_cast<char*>(&buf), sizeof(PlayerStatistics));
 		buf.swab();
 		playerStats.push_back(buf);
 	}
@@ -160,17 +169,91 @@ void CDemoReader::LoadStats()
 		teamStats.resize(fileHeader.numTeams);
 		// Read the array containing the number of team stats for each team.
 		std::vector<int> numStatsPerTeam(fileHeader.numTeams, 0);
-		playbackDemo->Read((char*) (&numStatsPerTeam[0]), numStatsPerTeam.size());
+		StreamRead((char*) (&numStatsPerTeam[0]), numStatsPerTeam.size());
 
 		for (int teamNum = 0; teamNum < fileHeader.numTeams; ++teamNum) {
 			for (int i = 0; i < numStatsPerTeam[teamNum]; ++i) {
 				TeamStatistics buf;
-				playbackDemo->Read(reinterpret_cast<char*>(&buf), sizeof(TeamStatistics));
+				StreamRead(reinterpret_cast<char*>(&buf), sizeof(TeamStatistics));
 				buf.swab();
 				teamStats[teamNum].push_back(buf);
 			}
 		}
 	}
 
-	playbackDemo->Seek(curPos);
+	StreamSeek(curPos);
+}
+
+
+bool CDemoReader::ReadKeyFrame(const DemoIndexedKeyFrame& keyFrame, std::string& data)
+{
+	return (indexedStream.ReadKeyFrame(keyFrame, data));
+}
+
+bool CDemoReader::SeekToKeyFrame(const DemoIndexedKeyFrame& keyFrame)
+{
+	if ((keyFrame.streamOffset + sizeof(chunkHeader)) > StreamSize())
+		return false;
+
+	StreamSeek(keyFrame.streamOffset);
+
+	if (StreamRead((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader))
+		return false;
+
+	chunkHeader.swab();
+
+	// keep the original time offset, modGameTime continues from the keyframe
+	nextDemoReadTime = chunkHeader.modGameTime + demoTimeOffset;
+
+	if (fileHeader.demoStreamSize != 0) {
+		bytesRemaining = (fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize) - keyFrame.streamOffset;
+		bytesRemaining -= sizeof(chunkHeader);
+	} else {
+		bytesRemaining = playbackDemoSize - StreamPos();
+	}
+
+	return true;
+}
+
+
+int CDemoReader::StreamRead(void* buf, int length)
+{
+	if (!indexedStream.IsIndexed())
+		return (playbackDemo->Read(buf, length));
+
+	return (indexedStream.Read(buf, length));
+}
+
+void CDemoReader::StreamSeek(std::uint64_t pos)
+{
+	if (!indexedStream.IsIndexed()) {
+		playbackDemo->Seek(int(pos));
+		return;
+	}
+
+	indexedStream.Seek(pos);
+}
+
+std::uint64_t CDemoReader::StreamPos()
+{
+	if (!indexedStream.IsIndexed())
+		return (playbackDemo->GetPos());
+
+	return (indexedStream.GetPos());
+}
+
+std::uint64_t CDemoReader::StreamSize() const
+{
+	if (!indexedStream.IsIndexed())
+		return (playbackDemo->FileSize());
+
+	return (indexedStream.GetSize());
+}
+
+bool CDemoReader::StreamEof()
+{
+	if (!indexedStream.IsIndexed())
+		return (playbackDemo->Eof());
+
+	return (indexedStream.Eof());
 }
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Demo.h"
+#include "DemoIndexedStream.h"
 
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
@@ -55,13 +56,43 @@ public:
 	/// Not needed for normal demo watching
 	void LoadStats();
 
+	/// indexed demos only, empty for plain ones
+	const std::vector<DemoIndexedFrame>& GetFrameIndex() const { return indexedStream.GetFrames(); }
+	const std::vector<DemoIndexedKeyFrame>& GetKeyFrames() const { return indexedStream.GetKeyFrames(); }
+
+	/**
+	@brief find the last embedded savestate in (minFrameNum, maxFrameNum]
+	@return nullptr if there is none (or the demo is not indexed)
+	*/
+	const DemoIndexedKeyFrame* FindKeyFrame(int minFrameNum, int maxFrameNum) const {
+		return (indexedStream.FindKeyFrame(minFrameNum, maxFrameNum));
+	}
+
+	/// decompress the savestate of <keyFrame> into <data>
+	bool ReadKeyFrame(const DemoIndexedKeyFrame& keyFrame, std::string& data);
+
+	/// continue reading packets from the frame after <keyFrame>
+	bool SeekToKeyFrame(const DemoIndexedKeyFrame& keyFrame);
+
+	bool IsIndexed() const { return indexedStream.IsIndexed(); }
+
+private:
+	// reads from the plain (decompressed) demo stream, regardless of container
+	int StreamRead(void* buf, int length);
+	void StreamSeek(std::uint64_t pos);
+	std::uint64_t StreamPos();
+	std::uint64_t StreamSize() const;
+	bool StreamEof();
+
 private:
 	CFileHandler* playbackDemo;
 
+	CDemoIndexedStream<CFileHandler> indexedStream;
+
 	float demoTimeOffset;
 	float nextDemoReadTime;
-	int bytesRemaining;
-	int playbackDemoSize;
+	std::int64_t bytesRemaining;
+	std::int64_t playbackDemoSize;
 
 	DemoStreamChunkHeader chunkHeader;
 
@@ -1,12 +1,17 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstring>
 #include <memory>
 
+#include <zlib.h>
+
 #include "DemoRecorder.h"
 #include "Game/GameVersion.h"
+#include "Net/Protocol/NetMessageTypes.h"
+#include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/TeamStatistics.h"
 #include "System/TimeUtil.h"
 #include "System/StringUtil.h"
@@ -30,8 +35,13 @@
 static std::string demoStreams[2];
 static spring::mutex demoMutex;
 
+// uncompressed size of each independently compressed part of the stream
+static constexpr unsigned int DEMO_BLOCK_SIZE = 256 * 1024;
+
 
-CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
+CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo, bool keyFrames)
+	: isServerDemo(serverDemo)
+	, hasKeyFrames(keyFrames)
 {
 	std::lock_guard<spring::mutex> lock(demoMutex);
 
@@ -40,7 +50,11 @@ CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modN
 	SetFileHeader();
 	WriteFileHeader(false);
 
-	file = gzopen(demoName.c_str(), "wb9");
+	if (hasKeyFrames) {
+		indexedFile = fopen(demoName.c_str(), "wb");
+	} else {
+		file = gzopen(demoName.c_str(), "wb9");
+	}
 }
 
 CDemoRecorder::~CDemoRecorder()
@@ -79,24 +93,35 @@ void CDemoRecorder::WriteDemoFile()
 	// any application-provided memory allocation routines must also be thread-safe. zlib's gz*
 	// functions use stdio library routines, and most of zlib's functions use the library memory
 	// allocation routines by default" (so code below should be OK)
-	// gz* should usually be finished before ctor runs again when reloading, but take no chances
+	// writing should usually be finished before ctor runs again when reloading, but take no chances
 	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
+	std::function<void(gzFile, FILE*, std::string&, DemoIndexedData&&)> func = [](gzFile file, FILE* indexedFile, std::string& data, DemoIndexedData&& demoIndex) {
 		std::lock_guard<spring::mutex> lock(demoMutex);
 
+		if (indexedFile != nullptr) {
+			if (!demoIndex.Write(indexedFile, data, DEMO_BLOCK_SIZE))
+				LOG_L(L_ERROR, "[DemoRecorder::%s] could not write indexed demo (errno=%d)", __func__, errno);
+
+			fclose(indexedFile);
+			return;
+		}
+
+		if (file == nullptr)
+			return;
+
 		gzwrite(file, data.c_str(), data.size());
 		gzflush(file, Z_FINISH);
 		gzclose(file);
 	};
 
-	LOG("[%s] writing %s-demo \"%s\" (%u bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), static_cast<unsigned int>(data.size()));
+	LOG("[%s] writing %s-demo \"%s\" (%u bytes, %u keyframes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), static_cast<unsigned int>(data.size()), static_cast<unsigned int>(demoIndex.keyFrames.size()));
 
 	#ifndef WIN32
 	// NOTE: can not use ThreadPool for this directly here, workers are already gone
 	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
+	ThreadPool::AddExtJob(spring::thread(std::move(func), file, indexedFile, std::ref(data), std::move(demoIndex)));
 	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
+	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, indexedFile, std::ref(data), std::move(demoIndex))));
 	#endif
 }
 
@@ -121,6 +146,24 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
 	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+
+	if (length == 0 || (buf[0] != NETMSG_NEWFRAME && buf[0] != NETMSG_KEYFRAME))
+		return;
+
+	// count frames the same way CGameServer::SendDemoData does during playback
+	if (((++numFrames) % GAME_SPEED) != 0)
+		return;
+
+	demoIndex.AddFrame(numFrames, demoStreams[isServerDemo].size());
+}
+
+
+void CDemoRecorder::AddKeyFrame(const std::string& state)
+{
+	assert(hasKeyFrames);
+
+	if (!demoIndex.AddKeyFrame(numFrames, demoStreams[isServerDemo].size(), state))
+		LOG_L(L_WARNING, "[DemoRecorder::%s] could not compress keyframe %d", __func__, numFrames);
 }
 
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
@@ -143,12 +186,15 @@ void CDemoRecorder::SetName(const std::string& mapName, const std::string& modNa
 	// oss << FileSystem::GetBasename(modName);
 	// oss << "_";
 	oss << SpringVersion::GetSync();
-	buf << oss.str() << ".sdfz";
+	// only demos with keyframes need the indexed container (see demofile.h)
+	const char* ext = (hasKeyFrames)? ".sdfi": ".sdfz";
+
+	buf << oss.str() << ext;
 
 	int n = 0;
 	while (FileSystem::FileExists(buf.str()) && (n < 99)) {
 		buf.str(""); // clears content
-		buf << oss.str() << "_" << n++ << ".sdfz";
+		buf << oss.str() << "_" << n++ << ext;
 	}
 
 	demoName = dataDirsAccess.LocateFile(buf.str(), FileQueryFlags::WRITE);
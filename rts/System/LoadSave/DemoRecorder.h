@@ -3,11 +3,13 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <cstdio>
 #include <vector>
 #include <sstream>
 #include <zlib.h>
 
 #include "Demo.h"
+#include "DemoIndexedStream.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
@@ -18,7 +20,12 @@
 class CDemoRecorder : public CDemo
 {
 public:
-	CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo);
+	/**
+	 * @param keyFrames if true, the demo is written as indexed container
+	 *   (.sdfi) which can hold savestates (see AddKeyFrame); otherwise as
+	 *   plain gzip'ed stream (.sdfz)
+	 */
+	CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo, bool keyFrames = false);
 	~CDemoRecorder();
 
 	void WriteSetupText(const std::string& text);
@@ -37,6 +44,10 @@ public:
 	void SetTeamStats(int teamNum, const std::vector<TeamStatistics>& stats);
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
+	bool HasKeyFrames() const { return hasKeyFrames; }
+	/// embed a creg savestate taken right after the last recorded frame
+	void AddKeyFrame(const std::string& state);
+
 private:
 	unsigned int WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
@@ -46,13 +57,19 @@ private:
 	void WriteDemoFile();
 
 private:
-	gzFile file;
+	gzFile file = nullptr;
+	FILE* indexedFile = nullptr;
+
+	DemoIndexedData demoIndex;
+
+	int numFrames = 0;
 
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
 	std::vector<unsigned char> winningAllyTeams;
 
 	bool isServerDemo;
+	bool hasKeyFrames;
 };
 
 
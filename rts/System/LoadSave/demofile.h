@@ -115,6 +115,97 @@ struct DemoStreamChunkHeader
 	}
 };
 
+
+/**
+ * @brief indexed demo container
+ *
+ * Demos recorded with keyframes (see DemoKeyFrameInterval in the start
+ * script) are written as .sdfi instead of gzip'ed .sdfz files. These wrap
+ * the plain stream described above (DemoFileHeader, script, chunks, stats)
+ * into a raw, not gzip'ed, file which allows random access:
+ *
+ *   DemoIndexedFileHeader
+ *   numBlocks compressed blocks of the plain stream (zlib, independent)
+ *   numKeyFrames compressed savestates
+ *   DemoIndexedBlock[numBlocks]
+ *   DemoIndexedFrame[numFrames]
+ *   DemoIndexedKeyFrame[numKeyFrames]
+ *
+ * Offsets into the plain stream are "stream offsets", offsets into the
+ * container are "file offsets". Older engines reject these files as
+ * corrupt, since zlib passes non-gzip data through unchanged and the
+ * magic does not match DEMOFILE_MAGIC.
+ */
+#define DEMOFILE_INDEXED_MAGIC "spring demoindx"
+
+#define DEMOFILE_INDEXED_VERSION 1
+
+struct DemoIndexedFileHeader
+{
+	char magic[16];               ///< DEMOFILE_INDEXED_MAGIC
+	int version;                  ///< DEMOFILE_INDEXED_VERSION
+	int headerSize;               ///< Size of the DemoIndexedFileHeader
+	std::uint32_t blockSize;    ///< Uncompressed size of each block except the last
+	std::uint32_t numBlocks;
+	std::uint32_t numFrames;    ///< Number of frame-index entries
+	std::uint32_t numKeyFrames; ///< Number of embedded savestates
+	std::uint64_t streamSize;   ///< Uncompressed size of the plain stream
+	std::uint64_t tablesOffset; ///< File offset of the block table; frame and keyframe tables follow it
+
+	void swab() {
+		swabDWordInPlace(version);
+		swabDWordInPlace(headerSize);
+		swabDWordInPlace(blockSize);
+		swabDWordInPlace(numBlocks);
+		swabDWordInPlace(numFrames);
+		swabDWordInPlace(numKeyFrames);
+		swab64InPlace(streamSize);
+		swab64InPlace(tablesOffset);
+	}
+};
+
+struct DemoIndexedBlock
+{
+	std::uint64_t fileOffset;
+	std::uint32_t compressedSize;
+	std::uint32_t rawSize;
+
+	void swab() {
+		swab64InPlace(fileOffset);
+		swabDWordInPlace(compressedSize);
+		swabDWordInPlace(rawSize);
+	}
+};
+
+struct DemoIndexedFrame
+{
+	std::int32_t frameNum;      ///< Number of NETMSG_{NEW,KEY}FRAME packets up to and including this one
+	std::uint32_t unused;
+	std::uint64_t streamOffset; ///< Stream offset of the DemoStreamChunkHeader following this frame's packet
+
+	void swab() {
+		swabDWordInPlace(frameNum);
+		swab64InPlace(streamOffset);
+	}
+};
+
+struct DemoIndexedKeyFrame
+{
+	std::int32_t frameNum;      ///< Frame after which the savestate was taken
+	std::uint32_t compressedSize;
+	std::uint64_t rawSize;
+	std::uint64_t streamOffset; ///< As in DemoIndexedFrame, the point where playback continues
+	std::uint64_t fileOffset;   ///< File offset of the zlib-compressed savestate
+
+	void swab() {
+		swabDWordInPlace(frameNum);
+		swabDWordInPlace(compressedSize);
+		swab64InPlace(rawSize);
+		swab64InPlace(streamOffset);
+		swab64InPlace(fileOffset);
+	}
+};
+
 #pragma pack(pop)
 
 #endif // DEMO_FILE_H
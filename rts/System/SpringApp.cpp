@@ -620,7 +620,7 @@ void SpringApp::Startup()
 		pregame = new CPreGame(clientSetup);
 		return;
 	}
-	if (extension == "sdfz") {
+	if (extension == "sdfz" || extension == "sdfi") {
 		LoadDemoFile(inputFile);
 		return;
 	}
@@ -0,0 +1,84 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEFERRED_WRITE_BUFFER_H
+#define DEFERRED_WRITE_BUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <vector>
+
+#include "System/Threading/ThreadPool.h"
+
+/**
+ * Collects results produced inside a for_mt body into per-thread
+ * bins (no locking required) and lets the caller apply them later
+ * from a single thread in ascending key order, making the outcome
+ * independent of how the pool happened to schedule the work.
+ *
+ * Keys must be unique within one Push/Commit cycle, otherwise the
+ * relative order of equal-keyed writes is unspecified.
+ */
+template<typename T>
+class DeferredWriteBuffer {
+public:
+	typedef std::pair<uint64_t, T> WriteType;
+
+	void Reset() {
+		for (auto& writes: threadWrites) {
+			writes.clear();
+		}
+
+		sortedWrites.clear();
+	}
+
+	// may be called concurrently by any pool thread
+	void Push(uint64_t key, const T& value) {
+		threadWrites[ThreadPool::GetThreadNum()].emplace_back(key, value);
+	}
+
+	size_t Size() const {
+		size_t n = 0;
+
+		for (const auto& writes: threadWrites) {
+			n += writes.size();
+		}
+
+		return n;
+	}
+
+	// must be called by one thread only, after all Push calls returned
+	template<typename F>
+	void Commit(F&& f) {
+		CommitWhile([&](uint64_t key, const T& value) { f(key, value); return true; });
+	}
+
+	// as Commit, but stops (dropping the remaining writes) as soon as f
+	// returns false; lets the caller fall back to serial processing once
+	// a write invalidated the ones after it
+	template<typename F>
+	void CommitWhile(F&& f) {
+		sortedWrites.clear();
+		sortedWrites.reserve(Size());
+
+		for (auto& writes: threadWrites) {
+			sortedWrites.insert(sortedWrites.end(), writes.begin(), writes.end());
+			writes.clear();
+		}
+
+		std::sort(sortedWrites.begin(), sortedWrites.end(), [](const WriteType& a, const WriteType& b) { return (a.first < b.first); });
+
+		for (const WriteType& w: sortedWrites) {
+			if (!f(w.first, w.second))
+				break;
+		}
+
+		sortedWrites.clear();
+	}
+
+private:
+	std::array<std::vector<WriteType>, ThreadPool::MAX_THREADS> threadWrites;
+	std::vector<WriteType> sortedWrites;
+};
+
+#endif
@@ -0,0 +1,166 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosMapKernels.h"
+#include "System/TimeProfiler.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Log/ILog.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+static constexpr int LOS_RADIUS = 96;
+static constexpr int ROW_LENGTH = 1024;
+static constexpr int NUM_ITERATIONS = 2000;
+
+
+// approximation of CLosTableHelper's rays: one per first-octant
+// surface point, the others follow from the kernel's rotations
+static std::vector< std::vector<int2> > GetRays(int radius)
+{
+	std::vector< std::vector<int2> > rays;
+
+	for (int y = 0; y <= radius; y++) {
+		const int x = int(std::sqrt(float(radius * radius - y * y)));
+
+		std::vector<int2> ray;
+
+		for (int i = 1, n = std::max(x, y); i <= n; i++) {
+			ray.emplace_back((x * i) / n, (y * i) / n);
+		}
+
+		rays.emplace_back(std::move(ray));
+	}
+
+	return rays;
+}
+
+static std::vector<float> GetAngles(int radius)
+{
+	std::vector<float> angles((2 * radius + 1) * (2 * radius + 1));
+
+	// coarse values make ties (and exact comparisons) common
+	for (float& a: angles) {
+		a = ((rand() % 2048) - 1024) * (1.0f / 256.0f);
+	}
+
+	return angles;
+}
+
+static std::vector<float> GetInvRadii(int radius)
+{
+	std::vector<float> isqrtTable((radius + 1) * (radius + 1) * 2);
+
+	for (size_t i = 0; i < isqrtTable.size(); i++) {
+		isqrtTable[i] = 1.0f / std::sqrt(float(std::max(i, size_t(1))));
+	}
+
+	return isqrtTable;
+}
+
+
+static std::vector<char> CastRays(
+	const std::vector< std::vector<int2> >& rays,
+	const std::vector<float>& angles,
+	const std::vector<float>& isqrtTable,
+	int radius
+) {
+	std::vector<char> visible(angles.size(), true);
+
+	for (const auto& ray: rays) {
+		LosMapKernels::CastRay(ray.data(), ray.size(), angles.data(), visible.data(), isqrtTable.data(), radius);
+	}
+
+	return visible;
+}
+
+static std::vector<unsigned short> AddToRows(int seed)
+{
+	std::vector<unsigned short> row(ROW_LENGTH, 1);
+
+	srand(seed);
+
+	for (int i = 0; i < NUM_ITERATIONS; i++) {
+		const unsigned start = rand() % ROW_LENGTH;
+		const unsigned count = rand() % (ROW_LENGTH - start + 1);
+
+		// includes under- and overflows
+		LosMapKernels::AddToRow(row.data() + start, count, (rand() % 5) - 2);
+	}
+
+	return row;
+}
+
+
+
+TEST_CASE("LosMapKernelsIdentical")
+{
+	srand(0);
+
+	const auto rays = GetRays(LOS_RADIUS);
+	const auto angles = GetAngles(LOS_RADIUS);
+	const auto isqrtTable = GetInvRadii(LOS_RADIUS);
+
+	LosMapKernels::Init(LosMapKernels::KERNEL_TYPE_SCALAR);
+
+	const std::vector<char> scalarVisible = CastRays(rays, angles, isqrtTable, LOS_RADIUS);
+	const std::vector<unsigned short> scalarRow = AddToRows(1234);
+
+	for (int t = LosMapKernels::KERNEL_TYPE_SCALAR + 1; t < LosMapKernels::KERNEL_TYPE_COUNT; t++) {
+		const LosMapKernels::KernelType type = LosMapKernels::KernelType(t);
+
+		if (LosMapKernels::Init(type) != type) {
+			LOG("[%s] kernel-type \"%s\" not supported, skipping", __func__, LosMapKernels::GetTypeName(type));
+			continue;
+		}
+
+		CHECK(CastRays(rays, angles, isqrtTable, LOS_RADIUS) == scalarVisible);
+		CHECK(AddToRows(1234) == scalarRow);
+	}
+
+	LosMapKernels::Init();
+}
+
+
+TEST_CASE("LosMapKernelsBenchmark")
+{
+	srand(0);
+
+	const auto rays = GetRays(LOS_RADIUS);
+	const auto angles = GetAngles(LOS_RADIUS);
+	const auto isqrtTable = GetInvRadii(LOS_RADIUS);
+
+	for (int t = LosMapKernels::KERNEL_TYPE_SCALAR; t < LosMapKernels::KERNEL_TYPE_COUNT; t++) {
+		const LosMapKernels::KernelType type = LosMapKernels::KernelType(t);
+
+		if (LosMapKernels::Init(type) != type)
+			continue;
+
+		size_t hash = 0;
+
+		{
+			ScopedOnceTimer timer(std::string("CastRay::") + LosMapKernels::GetTypeName(type));
+
+			for (int i = 0; i < (NUM_ITERATIONS / 10); i++) {
+				hash += CastRays(rays, angles, isqrtTable, LOS_RADIUS)[i];
+			}
+		}
+		{
+			ScopedOnceTimer timer(std::string("AddToRow::") + LosMapKernels::GetTypeName(type));
+
+			for (int i = 0; i < 100; i++) {
+				hash += AddToRows(i)[i];
+			}
+		}
+
+		LOG("[%s] kernel-type=%s hash=%u", __func__, LosMapKernels::GetTypeName(type), unsigned(hash));
+	}
+
+	LosMapKernels::Init();
+}
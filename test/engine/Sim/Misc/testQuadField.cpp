@@ -3,8 +3,12 @@
 #include "Sim/Misc/QuadField.h"
 #include "System/float3.h"
 #include "System/SpringMath.h"
+#include "System/Log/ILog.h"
 #include <stdlib.h>
 #include <time.h>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 #define CATCH_CONFIG_MAIN
 #include "lib/catch.hpp"
@@ -99,3 +103,135 @@ TEST_CASE("QuadField")
 	INFO("Too little quads returned!");
 	CHECK_FALSE(fail);
 }
+
+
+
+// stand-in for the fields of CUnit read by the Get*Exact distance tests
+struct TestUnit {
+	float3 pos;
+	float radius;
+	int tempNum;
+	char pad[512]; // CUnit is large, neighbours rarely share a cache line
+};
+
+TEST_CASE("QuadFieldUnitPositions")
+{
+	static constexpr int NUM_UNITS = 256; // typical for a busy quad
+	static constexpr int NUM_QUERIES = 20000;
+	static constexpr float QUAD_SIZE = CQuadField::BASE_QUAD_SIZE;
+
+	srand( time(nullptr) );
+
+	std::vector< std::unique_ptr<TestUnit> > storage;
+	std::vector<TestUnit*> units;
+	CQuadField::UnitPositions unitPositions;
+
+	for (int i = 0; i < NUM_UNITS; ++i) {
+		storage.emplace_back(new TestUnit());
+		storage.back()->pos = float3(randf() * QUAD_SIZE, randf() * 100.0f, randf() * QUAD_SIZE);
+		storage.back()->radius = 8.0f + randf() * 24.0f;
+	}
+	// heap order differs from quad order in a running game
+	for (int i = 0; i < NUM_UNITS; ++i) {
+		units.push_back(storage[(i * 97) % NUM_UNITS].get());
+		unitPositions.Push(units.back()->pos, units.back()->radius);
+	}
+
+	// erase must keep both arrays parallel (swap-with-last, as in Quad::RemoveUnit)
+	units[NUM_UNITS / 2] = units.back();
+	units.pop_back();
+	unitPositions.Erase(NUM_UNITS / 2);
+
+	REQUIRE(unitPositions.Size() == units.size());
+
+	std::vector<float3> queries(NUM_QUERIES);
+	std::vector<float> radii(NUM_QUERIES);
+
+	for (int i = 0; i < NUM_QUERIES; ++i) {
+		queries[i] = float3(randf() * QUAD_SIZE, randf() * 100.0f, randf() * QUAD_SIZE);
+		radii[i] = randf() * 64.0f;
+	}
+
+	size_t numHitsAoS = 0;
+	size_t numHitsSoA = 0;
+	bool mismatch = false;
+
+	const auto t0 = std::chrono::steady_clock::now();
+
+	// #1: old path, dereference every unit
+	for (int q = 0; q < NUM_QUERIES; ++q) {
+		for (TestUnit* u: units) {
+			u->tempNum = q;
+
+			const float totRad = radii[q] + u->radius;
+
+			if (queries[q].SqDistance(u->pos) >= (totRad * totRad))
+				continue;
+
+			numHitsAoS += 1;
+		}
+	}
+
+	const auto t1 = std::chrono::steady_clock::now();
+
+	// #2: new path, only units passing the (packed) test are touched
+	for (int q = 0; q < NUM_QUERIES; ++q) {
+		unitPositions.ForEachInSphere(queries[q], radii[q], [&](size_t i) {
+			units[i]->tempNum = q;
+			numHitsSoA += 1;
+			return true;
+		});
+	}
+
+	const auto t2 = std::chrono::steady_clock::now();
+
+	// results must be identical, including for the 2D and rectangle variants
+	// (NUM_UNITS - 1 is not a multiple of four, the scalar tail is covered)
+	std::vector<size_t> expHits[3];
+	std::vector<size_t> gotHits[3];
+
+	for (int q = 0; q < 1000; ++q) {
+		const float3 mins = queries[q] - float3(radii[q], 0.0f, radii[q]);
+		const float3 maxs = queries[q] + float3(radii[q], 0.0f, radii[q]);
+
+		for (auto& v: expHits) v.clear();
+		for (auto& v: gotHits) v.clear();
+
+		for (size_t i = 0, n = units.size(); i < n; i++) {
+			const float3& pos = units[i]->pos;
+			const float totRad = radii[q] + units[i]->radius;
+
+			mismatch |= ((queries[q].SqDistance  (pos) < (totRad * totRad)) != unitPositions.InSphere  (i, queries[q], radii[q]));
+			mismatch |= ((queries[q].SqDistance2D(pos) < (totRad * totRad)) != unitPositions.InCylinder(i, queries[q], radii[q]));
+			mismatch |= ((pos.x >= mins.x && pos.x <= maxs.x && pos.z >= mins.z && pos.z <= maxs.z) != unitPositions.InRectangle(i, mins, maxs));
+
+			if (unitPositions.InSphere(i, queries[q], radii[q])) expHits[0].push_back(i);
+			if (unitPositions.InCylinder(i, queries[q], radii[q])) expHits[1].push_back(i);
+			if (unitPositions.InRectangle(i, mins, maxs)) expHits[2].push_back(i);
+		}
+
+		unitPositions.ForEachInSphere(queries[q], radii[q], [&](size_t i) { gotHits[0].push_back(i); return true; });
+		unitPositions.ForEachInCylinder(queries[q], radii[q], [&](size_t i) { gotHits[1].push_back(i); return true; });
+		unitPositions.ForEachInRectangle(mins, maxs, [&](size_t i) { gotHits[2].push_back(i); return true; });
+
+		for (int k = 0; k < 3; k++) {
+			mismatch |= (expHits[k] != gotHits[k]);
+		}
+
+		// early-out stops at the first hit
+		if (!expHits[0].empty()) {
+			size_t first = units.size();
+
+			mismatch |= unitPositions.ForEachInSphere(queries[q], radii[q], [&](size_t i) { first = i; return false; });
+			mismatch |= (first != expHits[0][0]);
+		}
+	}
+
+	const float aosTime = std::chrono::duration<float, std::milli>(t1 - t0).count();
+	const float soaTime = std::chrono::duration<float, std::milli>(t2 - t1).count();
+
+	LOG("[QuadFieldUnitPositions] units=%d queries=%d hits=%u AoS=%.3fms SoA=%.3fms (%.2fx)", NUM_UNITS, NUM_QUERIES, unsigned(numHitsSoA), aosTime, soaTime, aosTime / std::max(soaTime, 0.001f));
+
+	CHECK(numHitsAoS == numHitsSoA);
+	CHECK_FALSE(mismatch);
+}
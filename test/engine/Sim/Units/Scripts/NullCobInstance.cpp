@@ -0,0 +1,87 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+// no-op stand-ins for everything CCobThread and CCobEngine reach outside
+// the interpreter, so scripts that stay within the VM can run standalone
+
+#include "Lua/LuaRules.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Units/Scripts/CobEngine.h"
+#include "Sim/Units/Scripts/CobInstance.h"
+
+CCobEngine* cobEngine = nullptr;
+CLuaRules* luaRules = nullptr;
+CGlobalSyncedRNG gsRNG;
+
+void CLuaRules::Cob2Lua(const LuaHashString& funcName, const CUnit* unit, int& argsCount, int args[MAX_LUA_COB_ARGS]) {}
+
+
+CUnitScript::CUnitScript(CUnit* unit): unit(unit), busy(false), hasSetSFXOccupy(false), hasRockUnit(false), hasStartBuilding(false) {}
+CUnitScript::~CUnitScript() {}
+
+void CUnitScript::Spin(int piece, int axis, float speed, float accel) {}
+void CUnitScript::StopSpin(int piece, int axis, float decel) {}
+void CUnitScript::Turn(int piece, int axis, float speed, float destination) {}
+void CUnitScript::Move(int piece, int axis, float speed, float destination) {}
+void CUnitScript::MoveNow(int piece, int axis, float destination) {}
+void CUnitScript::TurnNow(int piece, int axis, float destination) {}
+void CUnitScript::SetVisibility(int piece, bool visible) {}
+bool CUnitScript::EmitSfx(int sfxType, int sfxPiece) { return false; }
+void CUnitScript::AttachUnit(int piece, int u) {}
+void CUnitScript::DropUnit(int u) {}
+bool CUnitScript::NeedsWait(AnimType type, int piece, int axis) { return false; }
+void CUnitScript::Explode(int piece, int flags) {}
+void CUnitScript::ShowFlare(int piece) {}
+int CUnitScript::GetUnitVal(int val, int p1, int p2, int p3, int p4) { return 0; }
+void CUnitScript::SetUnitVal(int val, int param) {}
+
+
+CCobInstance::~CCobInstance() {}
+
+void CCobInstance::ThreadCallback(ThreadCallbackType type, int retCode, int cbParam) {}
+void CCobInstance::Signal(int signal) {}
+void CCobInstance::PlayUnitSound(int snr, int attr) {}
+void CCobInstance::ShowScriptError(const std::string& msg) {}
+
+bool CCobInstance::HasBlockShot(int weaponNum) const { return false; }
+bool CCobInstance::HasTargetWeight(int weaponNum) const { return false; }
+
+void CCobInstance::RawCall(int functionId) {}
+void CCobInstance::Create() {}
+void CCobInstance::Killed() {}
+void CCobInstance::WindChanged(float heading, float speed) {}
+void CCobInstance::ExtractionRateChanged(float speed) {}
+void CCobInstance::RockUnit(const float3& rockDir) {}
+void CCobInstance::HitByWeapon(const float3& hitDir, int weaponDefId, float& inoutDamage) {}
+void CCobInstance::SetSFXOccupy(int curTerrainType) {}
+void CCobInstance::QueryLandingPads(std::vector<int>& out_pieces) {}
+void CCobInstance::BeginTransport(const CUnit* unit) {}
+int CCobInstance::QueryTransport(const CUnit* unit) { return -1; }
+void CCobInstance::TransportPickup(const CUnit* unit) {}
+void CCobInstance::TransportDrop(const CUnit* unit, const float3& pos) {}
+void CCobInstance::StartBuilding(float heading, float pitch) {}
+int CCobInstance::QueryNanoPiece() { return -1; }
+int CCobInstance::QueryBuildInfo() { return -1; }
+
+void CCobInstance::Destroy() {}
+void CCobInstance::StartMoving(bool reversing) {}
+void CCobInstance::StopMoving() {}
+void CCobInstance::StartUnload() {}
+void CCobInstance::EndTransport() {}
+void CCobInstance::StartBuilding() {}
+void CCobInstance::StopBuilding() {}
+void CCobInstance::Falling() {}
+void CCobInstance::Landed() {}
+void CCobInstance::Activate() {}
+void CCobInstance::Deactivate() {}
+void CCobInstance::MoveRate(int curRate) {}
+void CCobInstance::FireWeapon(int weaponNum) {}
+void CCobInstance::EndBurst(int weaponNum) {}
+
+int CCobInstance::QueryWeapon(int weaponNum) { return -1; }
+void CCobInstance::AimWeapon(int weaponNum, float heading, float pitch) {}
+void CCobInstance::AimShieldWeapon(CPlasmaRepulser* weapon) {}
+int CCobInstance::AimFromWeapon(int weaponNum) { return -1; }
+void CCobInstance::Shot(int weaponNum) {}
+bool CCobInstance::BlockShot(int weaponNum, const CUnit* targetUnit, bool userTarget) { return false; }
+float CCobInstance::TargetWeight(int weaponNum, const CUnit* targetUnit) { return 1.0f; }
+void CCobInstance::AnimFinished(AnimType type, int piece, int axis) {}
@@ -0,0 +1,415 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobEngine.h"
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobInstance.h"
+#include "Sim/Units/Scripts/CobInstructions.h"
+#include "Sim/Units/Scripts/CobThread.h"
+#include "System/TimeProfiler.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Log/ILog.h"
+
+#include <queue>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+// raw opcodes, see CobInstructions.cpp
+static constexpr int SLEEP            = 0x10013000;
+static constexpr int PUSH_CONSTANT    = 0x10021001;
+static constexpr int PUSH_LOCAL_VAR   = 0x10021002;
+static constexpr int PUSH_STATIC      = 0x10021004;
+static constexpr int CREATE_LOCAL_VAR = 0x10022000;
+static constexpr int POP_LOCAL_VAR    = 0x10023002;
+static constexpr int POP_STATIC       = 0x10023004;
+static constexpr int ADD              = 0x10031000;
+static constexpr int SUB              = 0x10032000;
+static constexpr int MUL              = 0x10033000;
+static constexpr int MOD              = 0x10034001;
+static constexpr int BITWISE_XOR      = 0x10037000;
+static constexpr int SET_LESS         = 0x10051000;
+static constexpr int START            = 0x10061000;
+static constexpr int CALL             = 0x10062000;
+static constexpr int JUMP             = 0x10064000;
+static constexpr int RETURN           = 0x10065000;
+static constexpr int JUMP_NOT_EQUAL   = 0x10066000;
+
+enum {
+	SCRIPT_LOOP  = 0,
+	SCRIPT_FIB   = 1,
+	SCRIPT_SPAWN = 2,
+	SCRIPT_SLEEP = 3,
+	SCRIPT_ORDER = 4,
+	SCRIPT_EMPTY = 5,
+	SCRIPT_COUNT = 6,
+};
+
+
+class CCobAssembler {
+public:
+	CCobAssembler() { file.name = "test.cob"; }
+
+	void BeginScript(const char* name) {
+		file.scriptNames.emplace_back(name);
+		file.scriptOffsets.push_back(GetOffset());
+	}
+
+	int GetOffset() const { return file.code.size(); }
+
+	// returns the offset of the last operand, for patching jumps
+	int Emit(int opcode) { file.code.push_back(opcode); return (GetOffset() - 1); }
+	int Emit(int opcode, int arg1) { Emit(opcode); return Emit(arg1); }
+	int Emit(int opcode, int arg1, int arg2) { Emit(opcode, arg1); return Emit(arg2); }
+
+	void Patch(int offset, int value) { file.code[offset] = value; }
+
+	CCobFile Finish(int numStaticVars) {
+		for (size_t i = 0; i < file.scriptOffsets.size(); i++) {
+			const int end = (i + 1 < file.scriptOffsets.size())? file.scriptOffsets[i + 1]: GetOffset();
+			file.scriptLengths.push_back(end - file.scriptOffsets[i]);
+		}
+
+		// same padding as CCobFile
+		file.code.resize(file.code.size() + 4, 0);
+		file.numStaticVars = numStaticVars;
+
+		CobInstructions::Decode(file);
+		return std::move(file);
+	}
+
+private:
+	CCobFile file;
+};
+
+
+static CCobFile AssembleCorpus()
+{
+	CCobAssembler a;
+
+	// Loop(n): static[0] = sum((i * i) % 7 ^ i) for i in [0, n)
+	a.BeginScript("Loop");
+	a.Emit(CREATE_LOCAL_VAR); // n
+	a.Emit(CREATE_LOCAL_VAR); // sum
+	a.Emit(CREATE_LOCAL_VAR); // i
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(POP_LOCAL_VAR, 1);
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(POP_LOCAL_VAR, 2);
+	{
+		const int loop = a.GetOffset();
+
+		a.Emit(PUSH_LOCAL_VAR, 2);
+		a.Emit(PUSH_LOCAL_VAR, 0);
+		a.Emit(SET_LESS);
+		const int exit = a.Emit(JUMP_NOT_EQUAL, -1);
+
+		a.Emit(PUSH_LOCAL_VAR, 1);
+		a.Emit(PUSH_LOCAL_VAR, 2);
+		a.Emit(PUSH_LOCAL_VAR, 2);
+		a.Emit(MUL);
+		a.Emit(PUSH_CONSTANT, 7);
+		a.Emit(MOD);
+		a.Emit(PUSH_LOCAL_VAR, 2);
+		a.Emit(BITWISE_XOR);
+		a.Emit(ADD);
+		a.Emit(POP_LOCAL_VAR, 1);
+
+		a.Emit(PUSH_LOCAL_VAR, 2);
+		a.Emit(PUSH_CONSTANT, 1);
+		a.Emit(ADD);
+		a.Emit(POP_LOCAL_VAR, 2);
+		a.Emit(JUMP, loop);
+
+		a.Patch(exit, a.GetOffset());
+	}
+	a.Emit(PUSH_LOCAL_VAR, 1); a.Emit(POP_STATIC, 0);
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(RETURN);
+
+	// Fib(n): static[1] += n if n < 2, else Fib(n - 1) and Fib(n - 2)
+	a.BeginScript("Fib");
+	a.Emit(CREATE_LOCAL_VAR); // n
+	a.Emit(PUSH_LOCAL_VAR, 0);
+	a.Emit(PUSH_CONSTANT, 2);
+	a.Emit(SET_LESS);
+	{
+		const int recurse = a.Emit(JUMP_NOT_EQUAL, -1);
+
+		a.Emit(PUSH_STATIC, 1);
+		a.Emit(PUSH_LOCAL_VAR, 0);
+		a.Emit(ADD);
+		a.Emit(POP_STATIC, 1);
+		a.Emit(PUSH_CONSTANT, 0); a.Emit(RETURN);
+
+		a.Patch(recurse, a.GetOffset());
+	}
+	a.Emit(PUSH_LOCAL_VAR, 0); a.Emit(PUSH_CONSTANT, 1); a.Emit(SUB); a.Emit(CALL, SCRIPT_FIB, 1);
+	a.Emit(PUSH_LOCAL_VAR, 0); a.Emit(PUSH_CONSTANT, 2); a.Emit(SUB); a.Emit(CALL, SCRIPT_FIB, 1);
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(RETURN);
+
+	// Spawn(): starts Sleep(123), calls a zero-length script
+	a.BeginScript("Spawn");
+	a.Emit(PUSH_CONSTANT, 123);
+	a.Emit(START, SCRIPT_SLEEP, 1);
+	a.Emit(CALL, SCRIPT_EMPTY, 0);
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(RETURN);
+
+	// Sleep(x): static[2] = x after sleeping
+	a.BeginScript("Sleep");
+	a.Emit(CREATE_LOCAL_VAR); // x
+	a.Emit(PUSH_CONSTANT, 100);
+	a.Emit(SLEEP);
+	a.Emit(PUSH_LOCAL_VAR, 0); a.Emit(POP_STATIC, 2);
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(RETURN);
+
+	// Order(x, tag): static[3] = (static[3] * 31 + tag) % 1000003 after sleeping x
+	a.BeginScript("Order");
+	a.Emit(CREATE_LOCAL_VAR); // x
+	a.Emit(CREATE_LOCAL_VAR); // tag
+	a.Emit(PUSH_LOCAL_VAR, 0);
+	a.Emit(SLEEP);
+	a.Emit(PUSH_STATIC, 3);
+	a.Emit(PUSH_CONSTANT, 31);
+	a.Emit(MUL);
+	a.Emit(PUSH_LOCAL_VAR, 1);
+	a.Emit(ADD);
+	a.Emit(PUSH_CONSTANT, 1000003);
+	a.Emit(MOD);
+	a.Emit(POP_STATIC, 3);
+	a.Emit(PUSH_CONSTANT, 0); a.Emit(RETURN);
+
+	a.BeginScript("Empty");
+
+	return (a.Finish(4));
+}
+
+
+static int RunScript(CCobEngine& engine, CCobInstance& inst, int script, int arg)
+{
+	CCobThread thread(&inst);
+	std::array<int, 1 + MAX_COB_ARGS> args = {{1, arg}};
+
+	thread.SetID(engine.GenThreadID());
+	thread.Start(script, 0, args, true);
+
+	const int threadID = engine.AddThread(std::move(thread));
+
+	int numTicks = 0;
+
+	while (engine.GetThread(threadID) != nullptr || !inst.threadIDs.empty()) {
+		engine.Tick(33);
+		numTicks += 1;
+	}
+
+	return numTicks;
+}
+
+
+
+TEST_CASE("CobInstructionsDecode")
+{
+	const CCobFile file = AssembleCorpus();
+	const std::vector<SCobInstruction>& instrs = file.instructions;
+
+	REQUIRE(instrs.size() == file.code.size());
+
+	// Loop: three CREATE_LOCAL_VARs, then PUSH_CONSTANT+POP_LOCAL_VAR fused
+	CHECK(instrs[3].type == SCobInstruction::PUSHC_POPL);
+	CHECK(instrs[3].next == 7);
+	// the fused pop is still addressable on its own
+	CHECK(instrs[5].type == SCobInstruction::POP_LOCAL_VAR);
+	CHECK(instrs[5].next == 7);
+
+	// calls are resolved at load-time
+	const int spawn = file.scriptOffsets[SCRIPT_SPAWN];
+
+	CHECK(instrs[spawn + 2].type == SCobInstruction::START);
+	CHECK(instrs[spawn + 2].arg3 == file.scriptOffsets[SCRIPT_SLEEP]);
+	CHECK(instrs[spawn + 5].type == SCobInstruction::NOP_CALL);
+
+	// operands that run past the end, and the padding words
+	CHECK(instrs[instrs.size() - 1].type == SCobInstruction::UNKNOWN);
+}
+
+
+TEST_CASE("CobEngineExecute")
+{
+	CCobEngine engine;
+	CCobFile file = AssembleCorpus();
+	CCobInstance inst;
+
+	cobEngine = &engine;
+	cobEngine->Init();
+
+	inst.cobFile = &file;
+	inst.staticVars.resize(file.numStaticVars, 0);
+
+	int loopSum = 0;
+	for (int i = 0; i < 1000; i++) {
+		loopSum += (((i * i) % 7) ^ i);
+	}
+
+	RunScript(engine, inst, SCRIPT_LOOP, 1000);
+	CHECK(inst.staticVars[0] == loopSum);
+
+	RunScript(engine, inst, SCRIPT_FIB, 20);
+	CHECK(inst.staticVars[1] == 6765);
+
+	// the spawned thread outlives its parent by several frames
+	CHECK(RunScript(engine, inst, SCRIPT_SPAWN, 0) > RunScript(engine, inst, SCRIPT_LOOP, 1000));
+	CHECK(inst.staticVars[2] == 123);
+
+	engine.Kill();
+	cobEngine = nullptr;
+}
+
+
+// tag and sleep duration of a thread, in start order
+typedef std::pair<int, int> TagTime;
+
+template<typename Comp>
+static int WakeOrderHash(const std::vector<int>& sleepTimes, const Comp& comp)
+{
+	std::priority_queue<TagTime, std::vector<TagTime>, Comp> wakeOrder(comp);
+
+	for (size_t i = 0; i < sleepTimes.size(); i++) {
+		wakeOrder.push({int(i + 1), sleepTimes[i]});
+	}
+
+	int hash = 0;
+	for (; !wakeOrder.empty(); wakeOrder.pop()) {
+		hash = (hash * 31 + wakeOrder.top().first) % 1000003;
+	}
+
+	return hash;
+}
+
+static int RunWakeOrder(CCobEngine& engine, CCobInstance& inst, const std::vector<int>& sleepTimes, std::vector<int>& threadIDs)
+{
+	inst.staticVars[3] = 0;
+
+	// all threads fall asleep during the same tick, in start order
+	for (size_t i = 0; i < sleepTimes.size(); i++) {
+		CCobThread thread(&inst);
+		std::array<int, 1 + MAX_COB_ARGS> args = {{2, sleepTimes[i], int(i + 1)}};
+
+		thread.SetID(engine.GenThreadID());
+		thread.Start(SCRIPT_ORDER, 0, args, true);
+
+		threadIDs.push_back(engine.AddThread(std::move(thread)));
+	}
+
+	while (!inst.threadIDs.empty()) {
+		engine.Tick(33);
+	}
+
+	return inst.staticVars[3];
+}
+
+
+TEST_CASE("CobEngineWakeOrder")
+{
+	CCobEngine engine;
+	CCobFile file = AssembleCorpus();
+	CCobInstance inst;
+
+	cobEngine = &engine;
+	cobEngine->Init();
+
+	inst.cobFile = &file;
+	inst.staticVars.resize(file.numStaticVars, 0);
+
+	std::vector<int> threadIDs;
+
+	// negative, short, slot- and span-boundary and overflowing sleep durations
+	const std::vector<int> distinctSleepTimes = {
+		-50, 0, 31, 32, 33, 500, 8191, 8192, 8192 + 33, 9000, 50000, 2100000, 2500000, 34, -20, 1,
+	};
+	// as above, with equal wake-times
+	const std::vector<int> equalSleepTimes = {
+		-50, 0, 31, 32, 33, 33, 500, 8191, 8192, 8192 + 33, 9000, 50000, 500, 2100000, 2500000, 33, -20, 0,
+	};
+
+	// wake-time only, as the single binary heap the engine used before the wheel
+	const auto CompTime = [](const TagTime& a, const TagTime& b) { return (a.second > b.second); };
+	// wake-time, then the order in which threads fell asleep
+	const auto CompTimeSeq = [](const TagTime& a, const TagTime& b) {
+		if (a.second != b.second)
+			return (a.second > b.second);
+
+		return (a.first > b.first);
+	};
+
+	// distinct wake-times are woken exactly in the old heap's order
+	CHECK(RunWakeOrder(engine, inst, distinctSleepTimes, threadIDs) == WakeOrderHash(distinctSleepTimes, CompTime));
+	// ties are broken by sleep order rather than by heap layout
+	CHECK(RunWakeOrder(engine, inst, equalSleepTimes, threadIDs) == WakeOrderHash(equalSleepTimes, CompTimeSeq));
+
+	// ID's of finished threads are never handed out again by GetThread
+	RunScript(engine, inst, SCRIPT_SPAWN, 0);
+
+	for (const int threadID: threadIDs) {
+		CHECK(engine.GetThread(threadID) == nullptr);
+	}
+
+	engine.Kill();
+	cobEngine = nullptr;
+}
+
+
+TEST_CASE("CobEngineBenchmark")
+{
+	CCobEngine engine;
+	CCobFile file = AssembleCorpus();
+	CCobInstance inst;
+
+	cobEngine = &engine;
+	cobEngine->Init();
+
+	inst.cobFile = &file;
+	inst.staticVars.resize(file.numStaticVars, 0);
+
+	{
+		ScopedOnceTimer timer("CobEngine::Loop");
+
+		for (int i = 0; i < 20; i++) {
+			RunScript(engine, inst, SCRIPT_LOOP, 40000);
+		}
+	}
+	{
+		ScopedOnceTimer timer("CobEngine::Fib");
+
+		for (int i = 0; i < 20; i++) {
+			RunScript(engine, inst, SCRIPT_FIB, 20);
+		}
+	}
+	{
+		ScopedOnceTimer timer("CobEngine::Sleepers");
+
+		for (int i = 0; i < 50000; i++) {
+			CCobThread thread(&inst);
+			std::array<int, 1 + MAX_COB_ARGS> args = {{2, (i * 7919) % 20000, i}};
+
+			thread.SetID(engine.GenThreadID());
+			thread.Start(SCRIPT_ORDER, 0, args, true);
+			engine.AddThread(std::move(thread));
+		}
+
+		while (!inst.threadIDs.empty()) {
+			engine.Tick(33);
+		}
+	}
+	{
+		ScopedOnceTimer timer("CobEngine::Decode");
+
+		for (int i = 0; i < 1000; i++) {
+			CobInstructions::Decode(file);
+		}
+	}
+
+	LOG("[%s] static[0]=%d static[1]=%d static[3]=%d", __func__, inst.staticVars[0], inst.staticVars[1], inst.staticVars[3]);
+
+	engine.Kill();
+	cobEngine = nullptr;
+}
@@ -0,0 +1,160 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/FileSystem/Archives/ZipArchive.h"
+#include "System/GlobalConfig.h"
+#include "System/Log/ILog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "minizip/zip.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr const char* ARCHIVE_NAME = "testBufferedArchive.sdz";
+
+static constexpr unsigned int NUM_FILES = 128;
+static constexpr unsigned int FILE_SIZE = 128 * 1024;
+static constexpr unsigned int NUM_ROUNDS = 4;
+
+
+// compressible, but different per file
+static std::vector<std::uint8_t> GenFileData(unsigned int fileNum)
+{
+	std::vector<std::uint8_t> data(FILE_SIZE);
+	std::uint32_t state = 0x9E3779B9u * (fileNum + 1);
+
+	for (size_t i = 0; i < data.size(); i++) {
+		state = state * 1664525u + 1013904223u;
+		data[i] = ((state >> 24) & 0x0F) + (i & 0xF0);
+	}
+
+	return data;
+}
+
+static std::string GenFileName(unsigned int fileNum)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "data/file%03u.bin", fileNum);
+	return buf;
+}
+
+
+struct PrepareArchive {
+	PrepareArchive() {
+		zipFile zip = zipOpen(ARCHIVE_NAME, APPEND_STATUS_CREATE);
+
+		if (zip == nullptr)
+			return;
+
+		fileData.reserve(NUM_FILES);
+
+		for (unsigned int n = 0; n < NUM_FILES; n++) {
+			fileData.push_back(GenFileData(n));
+
+			const std::vector<std::uint8_t>& data = fileData.back();
+
+			zipOpenNewFileInZip(zip, GenFileName(n).c_str(), nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+			zipWriteInFileInZip(zip, data.data(), data.size());
+			zipCloseFileInZip(zip);
+		}
+
+		zipClose(zip, nullptr);
+		created = true;
+	}
+	~PrepareArchive() {
+		std::remove(ARCHIVE_NAME);
+	}
+
+	// expected contents, indexed by file-number
+	std::vector< std::vector<std::uint8_t> > fileData;
+
+	bool created = false;
+};
+
+static PrepareArchive prepareArchive;
+
+
+// reads every file NUM_ROUNDS times, spread over numThreads; returns the
+// number of files whose contents did not match
+static unsigned int ReadArchive(CZipArchive& archive, unsigned int numThreads, double& mbPerSec)
+{
+	std::vector<std::thread> threads;
+	std::atomic<unsigned int> nextIdx = {0};
+	std::atomic<unsigned int> numErrors = {0};
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	for (unsigned int t = 0; t < numThreads; t++) {
+		threads.emplace_back([&]() {
+			std::vector<std::uint8_t> buffer;
+
+			for (unsigned int i = nextIdx++; i < (NUM_FILES * NUM_ROUNDS); i = nextIdx++) {
+				const unsigned int n = i % NUM_FILES;
+				const unsigned int fid = archive.FindFile(GenFileName(n));
+
+				if (!archive.IsFileId(fid) || !archive.GetFile(fid, buffer) || buffer != prepareArchive.fileData[n])
+					numErrors += 1;
+			}
+		});
+	}
+
+	for (std::thread& t: threads) {
+		t.join();
+	}
+
+	const auto endTime = std::chrono::steady_clock::now();
+	const double secs = std::chrono::duration<double>(endTime - startTime).count();
+
+	mbPerSec = (NUM_FILES * NUM_ROUNDS * (FILE_SIZE / (1024.0 * 1024.0))) / std::max(secs, 1e-6);
+	return numErrors;
+}
+
+
+TEST_CASE("ConcurrentReads")
+{
+	REQUIRE(prepareArchive.created);
+
+	// every read decompresses, otherwise later rounds only copy from the cache
+	globalConfig.vfsCacheArchiveFiles = false;
+
+	// at least a few threads even on small machines, to exercise the locking
+	const unsigned int maxThreads = std::max(4u, std::min(8u, std::thread::hardware_concurrency()));
+
+	for (unsigned int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		CZipArchive archive(ARCHIVE_NAME);
+		REQUIRE(archive.IsOpen());
+		REQUIRE(archive.NumFiles() == NUM_FILES);
+
+		double mbPerSec = 0.0;
+
+		CHECK(ReadArchive(archive, numThreads, mbPerSec) == 0);
+		LOG("[BufferedArchive::ConcurrentReads] threads=%u throughput=%.1fMB/s", numThreads, mbPerSec);
+	}
+
+	globalConfig.vfsCacheArchiveFiles = true;
+}
+
+
+TEST_CASE("ConcurrentCachedReads")
+{
+	REQUIRE(prepareArchive.created);
+
+	globalConfig.vfsCacheArchiveFiles = true;
+
+	// threads race to populate the same cache entries
+	CZipArchive archive(ARCHIVE_NAME);
+	REQUIRE(archive.IsOpen());
+
+	double mbPerSec = 0.0;
+
+	CHECK(ReadArchive(archive, std::max(4u, std::thread::hardware_concurrency()), mbPerSec) == 0);
+	LOG("[BufferedArchive::ConcurrentCachedReads] throughput=%.1fMB/s", mbPerSec);
+}
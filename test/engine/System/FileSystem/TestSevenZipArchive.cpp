@@ -0,0 +1,317 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/FileSystem/Archives/SevenZipArchive.h"
+#include "System/FileSystem/Archives/SolidBlockCache.h"
+#include "System/Log/ILog.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "lib/7z/7zCrc.h"
+}
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr const char* ARCHIVE_NAME = "testSevenZipArchive.sd7";
+
+static constexpr unsigned int NUM_FOLDERS = 3;
+static constexpr unsigned int FILES_PER_FOLDER = 16;
+
+
+// 7z variable-length number
+static void PutNumber(std::vector<std::uint8_t>& buf, std::uint64_t value)
+{
+	for (unsigned int n = 0; n < 8; n++) {
+		if (value >= (std::uint64_t(1) << (7 * (n + 1))))
+			continue;
+
+		buf.push_back(((0xFF << (8 - n)) & 0xFF) | (value >> (8 * n)));
+
+		for (unsigned int i = 0; i < n; i++) {
+			buf.push_back((value >> (8 * i)) & 0xFF);
+		}
+
+		return;
+	}
+
+	buf.push_back(0xFF);
+
+	for (unsigned int i = 0; i < 8; i++) {
+		buf.push_back((value >> (8 * i)) & 0xFF);
+	}
+}
+
+static void PutUInt(std::vector<std::uint8_t>& buf, std::uint64_t value, unsigned int numBytes)
+{
+	for (unsigned int i = 0; i < numBytes; i++) {
+		buf.push_back((value >> (8 * i)) & 0xFF);
+	}
+}
+
+
+/**
+ * Writes a solid archive of NUM_FOLDERS blocks holding FILES_PER_FOLDER files
+ * each, stored with the copy coder so no LZMA encoder is needed; the blocks
+ * are decoded (and cached) exactly like compressed ones.
+ */
+struct PrepareArchive {
+	PrepareArchive() {
+		CrcGenerateTable();
+
+		std::vector<std::uint8_t> body;
+		std::vector<std::uint8_t> header;
+		std::vector<std::uint8_t> names;
+
+		for (unsigned int n = 0; n < NUM_FOLDERS * FILES_PER_FOLDER; n++) {
+			char name[64];
+			snprintf(name, sizeof(name), "data/file%03u.bin", n);
+
+			fileNames.emplace_back(name);
+			fileData.emplace_back();
+
+			// includes empty files in the middle of a block
+			for (unsigned int i = 0, size = ((n % 5) == 3)? 0: (100 + n * 37); i < size; i++) {
+				fileData.back().push_back(n * 7 + i);
+			}
+
+			body.insert(body.end(), fileData.back().begin(), fileData.back().end());
+
+			for (const char c: fileNames.back()) {
+				PutUInt(names, c, 2);
+			}
+
+			PutUInt(names, 0, 2);
+		}
+
+		const auto FolderSize = [&](unsigned int f) {
+			size_t size = 0;
+
+			for (unsigned int n = f * FILES_PER_FOLDER; n < (f + 1) * FILES_PER_FOLDER; n++) {
+				size += fileData[n].size();
+			}
+
+			return size;
+		};
+
+		header.push_back(0x01); // Header
+		header.push_back(0x04); // MainStreamsInfo
+
+		header.push_back(0x06); // PackInfo
+		PutNumber(header, 0);
+		PutNumber(header, NUM_FOLDERS);
+		header.push_back(0x09); // Size
+
+		for (unsigned int f = 0; f < NUM_FOLDERS; f++) {
+			PutNumber(header, FolderSize(f));
+		}
+
+		header.push_back(0x00);
+
+		header.push_back(0x07); // UnPackInfo
+		header.push_back(0x0B); // Folder
+		PutNumber(header, NUM_FOLDERS);
+		header.push_back(0x00); // not external
+
+		for (unsigned int f = 0; f < NUM_FOLDERS; f++) {
+			PutNumber(header, 1); // one coder
+			header.push_back(0x01); // simple, 1-byte id
+			header.push_back(0x00); // copy
+		}
+
+		header.push_back(0x0C); // CodersUnPackSize
+
+		for (unsigned int f = 0; f < NUM_FOLDERS; f++) {
+			PutNumber(header, FolderSize(f));
+		}
+
+		header.push_back(0x00);
+
+		header.push_back(0x08); // SubStreamsInfo
+		header.push_back(0x0D); // NumUnPackStream
+
+		for (unsigned int f = 0; f < NUM_FOLDERS; f++) {
+			PutNumber(header, FILES_PER_FOLDER);
+		}
+
+		header.push_back(0x09); // Size, implicit for the last file of a folder
+
+		for (unsigned int n = 0; n < NUM_FOLDERS * FILES_PER_FOLDER; n++) {
+			if (((n + 1) % FILES_PER_FOLDER) != 0)
+				PutNumber(header, fileData[n].size());
+		}
+
+		header.push_back(0x0A); // CRC
+		header.push_back(0x01); // all defined
+
+		for (const std::vector<std::uint8_t>& data: fileData) {
+			PutUInt(header, CrcCalc(data.data(), data.size()), 4);
+		}
+
+		header.push_back(0x00);
+		header.push_back(0x00);
+
+		header.push_back(0x05); // FilesInfo
+		PutNumber(header, fileData.size());
+		header.push_back(0x11); // Names
+		PutNumber(header, names.size() + 1);
+		header.push_back(0x00); // not external
+		header.insert(header.end(), names.begin(), names.end());
+		header.push_back(0x00);
+		header.push_back(0x00);
+
+		std::vector<std::uint8_t> startHeader;
+		PutUInt(startHeader, body.size(), 8);
+		PutUInt(startHeader, header.size(), 8);
+		PutUInt(startHeader, CrcCalc(header.data(), header.size()), 4);
+
+		std::vector<std::uint8_t> archive = {'7', 'z', 0xBC, 0xAF, 0x27, 0x1C, 0x00, 0x04};
+		PutUInt(archive, CrcCalc(startHeader.data(), startHeader.size()), 4);
+		archive.insert(archive.end(), startHeader.begin(), startHeader.end());
+		archive.insert(archive.end(), body.begin(), body.end());
+		archive.insert(archive.end(), header.begin(), header.end());
+
+		FILE* file = fopen(ARCHIVE_NAME, "wb");
+
+		if (file == nullptr)
+			return;
+
+		created = (fwrite(archive.data(), archive.size(), 1, file) == 1);
+		created &= (fclose(file) == 0);
+	}
+	~PrepareArchive() {
+		std::remove(ARCHIVE_NAME);
+	}
+
+	std::vector<std::string> fileNames;
+	std::vector< std::vector<std::uint8_t> > fileData;
+
+	bool created = false;
+};
+
+
+static CSolidBlockCache::BlockData MakeBlock(size_t size)
+{
+	return CSolidBlockCache::BlockData(new std::uint8_t[size], std::default_delete<std::uint8_t[]>());
+}
+
+
+TEST_CASE("SolidBlockCache")
+{
+	const int owners[2] = {0, 0};
+
+	CSolidBlockCache cache(300);
+	size_t size = 0;
+
+	cache.Insert(&owners[0], 0, MakeBlock(100), 100, false);
+	cache.Insert(&owners[0], 1, MakeBlock(100), 100, true);
+	cache.Insert(&owners[1], 0, MakeBlock(100), 100, false);
+
+	CHECK(cache.GetSize() == 300);
+
+	SECTION("LRU eviction") {
+		// blocks of all owners share the limit, the least recently used go first
+		CHECK(cache.Find(&owners[0], 0, size) != nullptr);
+		CHECK(size == 100);
+
+		CSolidBlockCache::BlockData evicted = cache.Find(&owners[0], 1, size);
+		cache.Find(&owners[0], 0, size);
+		cache.Find(&owners[1], 0, size);
+
+		cache.Insert(&owners[1], 1, MakeBlock(150), 150, false);
+
+		CHECK(cache.GetSize() == 250);
+		CHECK(cache.Find(&owners[0], 1, size) == nullptr);
+		CHECK(cache.Find(&owners[0], 0, size) == nullptr);
+		CHECK(cache.Find(&owners[1], 0, size) != nullptr);
+		CHECK(cache.Find(&owners[1], 1, size) != nullptr);
+
+		// still referenced
+		CHECK(evicted.use_count() == 1);
+	}
+
+	SECTION("Oversized block") {
+		cache.Insert(&owners[1], 1, MakeBlock(301), 301, false);
+
+		CHECK(cache.GetSize() == 300);
+		CHECK(cache.Find(&owners[1], 1, size) == nullptr);
+	}
+
+	SECTION("Erase") {
+		CHECK(cache.Erase(&owners[0], true) == 100);
+		CHECK(cache.Find(&owners[0], 0, size) != nullptr);
+		CHECK(cache.Find(&owners[0], 1, size) == nullptr);
+
+		CHECK(cache.Erase(&owners[0], false) == 100);
+		CHECK(cache.GetSize() == 100);
+		CHECK(cache.Find(&owners[1], 0, size) != nullptr);
+	}
+}
+
+
+TEST_CASE("SevenZipArchive")
+{
+	PrepareArchive prep;
+	REQUIRE(prep.created);
+
+	CSevenZipArchive archive(ARCHIVE_NAME);
+	REQUIRE(archive.IsOpen());
+	REQUIRE(archive.NumFiles() == prep.fileData.size());
+
+	SECTION("Block offsets") {
+		// views point into the cached block, at each file's offset
+		for (unsigned int n = 0; n < prep.fileData.size(); n++) {
+			const unsigned int fid = archive.FindFile(prep.fileNames[n]);
+			const std::vector<std::uint8_t>& data = prep.fileData[n];
+
+			REQUIRE(fid < archive.NumFiles());
+
+			std::vector<std::uint8_t> buffer;
+			FileView view;
+
+			CHECK(archive.GetFile(fid, buffer));
+			CHECK(buffer == data);
+
+			if (data.empty()) {
+				CHECK(!archive.GetFileView(fid, view));
+				continue;
+			}
+
+			REQUIRE(archive.GetFileView(fid, view));
+			CHECK(std::vector<std::uint8_t>(view.data, view.data + view.size) == data);
+		}
+	}
+
+	SECTION("Prefetch") {
+		CSolidBlockCache& blockCache = CSolidBlockCache::GetInstance();
+
+		size_t totalSize = 0;
+		unsigned int numProgress = 0;
+
+		for (const std::vector<std::uint8_t>& data: prep.fileData) {
+			totalSize += data.size();
+		}
+
+		REQUIRE(blockCache.GetSize() == 0);
+		archive.Prefetch([&]() { numProgress++; });
+
+		CHECK(numProgress == NUM_FOLDERS);
+		CHECK(blockCache.GetSize() == totalSize);
+
+		archive.ReleasePrefetched();
+		CHECK(blockCache.GetSize() == 0);
+
+		// decoded on demand again, and kept
+		std::vector<std::uint8_t> buffer;
+
+		CHECK(archive.GetFile(archive.FindFile(prep.fileNames[0]), buffer));
+		CHECK(buffer == prep.fileData[0]);
+		CHECK(blockCache.GetSize() > 0);
+
+		archive.ReleasePrefetched();
+		CHECK(blockCache.GetSize() > 0);
+	}
+}
@@ -0,0 +1,219 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/LoadSave/DemoIndexedStream.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr int NUM_FRAMES = 900;
+static constexpr int FRAME_STEP = 30;
+static constexpr int KEYFRAME_STEP = 300;
+// small enough to spread the stream over many blocks
+static constexpr unsigned int BLOCK_SIZE = 1024;
+
+// provides the subset of CFileHandler used by CDemoIndexedStream
+struct MemFile {
+	MemFile(const std::string& data): data(data) {}
+
+	int Read(void* buf, int length) {
+		const int numRead = std::max(0, std::min(length, int(data.size()) - pos));
+		memcpy(buf, data.data() + pos, numRead);
+		pos += numRead;
+		return numRead;
+	}
+
+	void Seek(int newPos) { pos = newPos; }
+	int FileSize() const { return data.size(); }
+
+	std::string data;
+	int pos = 0;
+};
+
+// mimics CDemoRecorder: one chunk per frame, indexed every FRAME_STEP frames
+struct TestDemo {
+	TestDemo() {
+		DemoFileHeader fileHeader;
+		memset(&fileHeader, 0, sizeof(fileHeader));
+		strcpy(fileHeader.magic, DEMOFILE_MAGIC);
+		stream.append(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+
+		for (int frameNum = 0; frameNum < NUM_FRAMES; frameNum++) {
+			if ((frameNum % FRAME_STEP) == 0)
+				index.AddFrame(frameNum, stream.size());
+			if (frameNum > 0 && (frameNum % KEYFRAME_STEP) == 0) {
+				keyFrameStates.emplace_back(GetState(frameNum));
+				REQUIRE(index.AddKeyFrame(frameNum, stream.size(), keyFrameStates.back()));
+			}
+
+			chunkOffsets.push_back(stream.size());
+
+			DemoStreamChunkHeader chunkHeader;
+			chunkHeader.modGameTime = frameNum / float(FRAME_STEP);
+			chunkHeader.length = 1 + (frameNum * 7) % 61;
+			stream.append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
+			stream.append(chunkHeader.length, char(frameNum));
+		}
+	}
+
+	static std::string GetState(int frameNum) {
+		std::string state;
+
+		for (int i = 0; i < 5000; i++) {
+			state += std::to_string(frameNum * i);
+		}
+
+		return state;
+	}
+
+	std::string Write() {
+		FILE* file = tmpfile();
+		REQUIRE(file != nullptr);
+		REQUIRE(index.Write(file, stream, BLOCK_SIZE));
+
+		// Write leaves the position behind the header it rewrites last
+		fseek(file, 0, SEEK_END);
+
+		std::string data(ftell(file), 0);
+		fseek(file, 0, SEEK_SET);
+		REQUIRE(fread(&data[0], data.size(), 1, file) == 1);
+		fclose(file);
+		return data;
+	}
+
+	DemoIndexedData index;
+
+	std::string stream;
+	std::vector<std::string> keyFrameStates;
+	std::vector<size_t> chunkOffsets;
+};
+
+
+static DemoStreamChunkHeader ReadChunkHeader(CDemoIndexedStream<MemFile>& reader) {
+	DemoStreamChunkHeader chunkHeader;
+	REQUIRE(reader.Read(&chunkHeader, sizeof(chunkHeader)) == int(sizeof(chunkHeader)));
+	return chunkHeader;
+}
+
+
+TEST_CASE("DemoIndexedStream")
+{
+	TestDemo demo;
+	MemFile file(demo.Write());
+
+	CDemoIndexedStream<MemFile> reader;
+
+	REQUIRE(reader.Open(&file));
+	REQUIRE(reader.IsIndexed());
+	// packed members, copied before Catch takes them by reference
+	CHECK(unsigned(reader.GetHeader().blockSize) == BLOCK_SIZE);
+	CHECK(unsigned(reader.GetHeader().numBlocks) == (demo.stream.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	CHECK(reader.GetSize() == demo.stream.size());
+	CHECK(reader.GetFrames().size() == NUM_FRAMES / FRAME_STEP);
+	CHECK(reader.GetKeyFrames().size() == demo.keyFrameStates.size());
+
+	SECTION("Sequential read") {
+		// odd length, reads straddle block boundaries
+		std::string stream;
+		char buf[333];
+
+		while (!reader.Eof()) {
+			stream.append(buf, reader.Read(buf, sizeof(buf)));
+		}
+
+		CHECK(stream == demo.stream);
+		CHECK(reader.Read(buf, sizeof(buf)) == 0);
+	}
+
+	SECTION("Frame index") {
+		// seek backwards through the index, each entry points at its chunk
+		for (auto iter = reader.GetFrames().rbegin(); iter != reader.GetFrames().rend(); ++iter) {
+			reader.Seek(iter->streamOffset);
+
+			CHECK(iter->streamOffset == demo.chunkOffsets[iter->frameNum]);
+			CHECK(ReadChunkHeader(reader).modGameTime == iter->frameNum / float(FRAME_STEP));
+		}
+	}
+
+	SECTION("Keyframes") {
+		CHECK(reader.FindKeyFrame(0, KEYFRAME_STEP - 1) == nullptr);
+		CHECK(reader.FindKeyFrame(KEYFRAME_STEP, KEYFRAME_STEP * 2 - 1) == nullptr);
+		CHECK(reader.FindKeyFrame(KEYFRAME_STEP - 1, KEYFRAME_STEP)->frameNum == KEYFRAME_STEP);
+		CHECK(reader.FindKeyFrame(0, NUM_FRAMES)->frameNum == KEYFRAME_STEP * int(demo.keyFrameStates.size()));
+
+		for (size_t i = 0; i < demo.keyFrameStates.size(); i++) {
+			const int frameNum = KEYFRAME_STEP * (i + 1);
+			const DemoIndexedKeyFrame* keyFrame = reader.FindKeyFrame(0, frameNum + KEYFRAME_STEP - 1);
+
+			REQUIRE(keyFrame != nullptr);
+			CHECK(keyFrame->frameNum == frameNum);
+
+			std::string state;
+			REQUIRE(reader.ReadKeyFrame(*keyFrame, state));
+			CHECK(state == demo.keyFrameStates[i]);
+
+			// playback resumes at the chunk of the keyframe's frame
+			reader.Seek(keyFrame->streamOffset);
+
+			const DemoStreamChunkHeader chunkHeader = ReadChunkHeader(reader);
+			CHECK(chunkHeader.modGameTime == frameNum / float(FRAME_STEP));
+			CHECK(reader.GetPos() == demo.chunkOffsets[frameNum] + sizeof(chunkHeader));
+		}
+	}
+}
+
+
+TEST_CASE("DemoIndexedStreamCorrupt")
+{
+	TestDemo demo;
+
+	SECTION("Plain demo") {
+		MemFile file(demo.stream);
+		CDemoIndexedStream<MemFile> reader;
+
+		CHECK(reader.Open(&file));
+		CHECK(!reader.IsIndexed());
+	}
+
+	SECTION("Truncated container") {
+		MemFile file(demo.Write());
+		CDemoIndexedStream<MemFile> reader;
+
+		file.data.resize(file.data.size() - sizeof(DemoIndexedKeyFrame));
+
+		CHECK(!reader.Open(&file));
+		CHECK(!reader.IsIndexed());
+	}
+
+	SECTION("Corrupt keyframe") {
+		// the server only seeks to keyframes whose savestate reads back
+		MemFile file(demo.Write());
+		CDemoIndexedStream<MemFile> reader;
+
+		REQUIRE(reader.Open(&file));
+		REQUIRE(!reader.GetKeyFrames().empty());
+
+		const DemoIndexedKeyFrame keyFrame = reader.GetKeyFrames().front();
+
+		for (unsigned int i = 0; i < keyFrame.compressedSize; i++) {
+			file.data[keyFrame.fileOffset + i] ^= 0x5A;
+		}
+
+		std::string state;
+		CHECK(!reader.ReadKeyFrame(keyFrame, state));
+
+		// the stream itself is unaffected
+		std::string stream;
+		char buf[333];
+
+		while (!reader.Eof()) {
+			stream.append(buf, reader.Read(buf, sizeof(buf)));
+		}
+
+		CHECK(stream == demo.stream);
+	}
+}
@@ -0,0 +1,422 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Threading/DeferredWriteBuffer.h"
+#include "Sim/Units/LosStatusUpdater.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Sync/SyncChecker.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+#include "System/GlobalRNG.h"
+
+#include <array>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+struct do_once {
+	do_once() { Threading::DetectCores(); } // make GetMaxThreads() work
+};
+
+InitSpringTime ist;
+do_once doonce;
+
+
+static constexpr int NUM_OBJECTS = 20000;
+static constexpr int NUM_ALLYTEAMS = 4;
+static constexpr int NUM_FRAMES = 30;
+static constexpr int MAP_SIZE = 256;
+
+// mimics the unit LOS-status update: a read-only "sight" map decides
+// each object's new per-allyteam state, every change is committed
+// (and checksummed) in object order
+struct TestObject {
+	int x;
+	int z;
+	unsigned char status[NUM_ALLYTEAMS];
+};
+
+struct TestWorld {
+	TestWorld() {
+		CGlobalSyncedRNG rng;
+		rng.SetSeed(1234, true);
+
+		objects.resize(NUM_OBJECTS);
+		sightMap.resize(MAP_SIZE * MAP_SIZE * NUM_ALLYTEAMS);
+
+		for (TestObject& o: objects) {
+			o.x = rng.NextInt(MAP_SIZE);
+			o.z = rng.NextInt(MAP_SIZE);
+
+			std::fill(o.status, o.status + NUM_ALLYTEAMS, 0);
+		}
+	}
+
+	void UpdateSightMap(int frame) {
+		// deterministic per-frame pattern, changes a subset of squares
+		for (size_t i = 0; i < sightMap.size(); i++) {
+			sightMap[i] = ((i * 2654435761u + frame * 40503u) >> 13) & 1;
+		}
+	}
+
+	void MoveObjects(int frame) {
+		for (size_t i = 0; i < objects.size(); i++) {
+			objects[i].x = (objects[i].x + ((i + frame) % 3) - 1 + MAP_SIZE) % MAP_SIZE;
+			objects[i].z = (objects[i].z + ((i * 7 + frame) % 3) - 1 + MAP_SIZE) % MAP_SIZE;
+		}
+	}
+
+	unsigned char CalcStatus(const TestObject& o, int at) const {
+		const unsigned char inSight = sightMap[((o.z * MAP_SIZE) + o.x) * NUM_ALLYTEAMS + at];
+		const unsigned char prevSeen = o.status[at] & 2;
+
+		return (inSight | (inSight << 1) | prevSeen);
+	}
+
+	void SetStatus(TestObject& o, int id, int at, unsigned char status) {
+		o.status[at] = status;
+
+		CSyncChecker::Sync(&id, sizeof(id));
+		CSyncChecker::Sync(&at, sizeof(at));
+		CSyncChecker::Sync(&o.status[at], sizeof(o.status[at]));
+	}
+
+	std::vector<TestObject> objects;
+	std::vector<unsigned char> sightMap;
+};
+
+
+static unsigned RunSerial(TestWorld& world)
+{
+	CSyncChecker::NewFrame();
+
+	for (size_t i = 0; i < world.objects.size(); i++) {
+		TestObject& o = world.objects[i];
+
+		for (int at = 0; at < NUM_ALLYTEAMS; at++) {
+			const unsigned char status = world.CalcStatus(o, at);
+
+			if (status == o.status[at])
+				continue;
+
+			world.SetStatus(o, i, at, status);
+		}
+	}
+
+	return (CSyncChecker::GetChecksum());
+}
+
+static unsigned RunThreaded(TestWorld& world, DeferredWriteBuffer<unsigned char>& writes)
+{
+	CSyncChecker::NewFrame();
+
+	writes.Reset();
+
+	for_mt(0, world.objects.size(), [&](const int i) {
+		const TestObject& o = world.objects[i];
+
+		for (int at = 0; at < NUM_ALLYTEAMS; at++) {
+			const unsigned char status = world.CalcStatus(o, at);
+
+			if (status == o.status[at])
+				continue;
+
+			writes.Push(i * NUM_ALLYTEAMS + at, status);
+		}
+	});
+
+	writes.Commit([&](uint64_t key, const unsigned char status) {
+		world.SetStatus(world.objects[key / NUM_ALLYTEAMS], key / NUM_ALLYTEAMS, key % NUM_ALLYTEAMS, status);
+	});
+
+	return (CSyncChecker::GetChecksum());
+}
+
+
+// mimics CUnit's LOS-status interface; gaining the in-sight bit runs a
+// "call-in" that moves (or masks) another unit, possibly one that has
+// not been visited yet this frame
+static constexpr unsigned char MOCK_EVENT_BITS = 1;
+static constexpr unsigned char MOCK_MASK_BITS = 0xF0;
+
+struct MockUnit;
+
+struct MockWorld: public TestWorld {
+	MockWorld();
+
+	std::vector<MockUnit> units;
+	std::vector<MockUnit*> unitPtrs;
+
+	void TeleportUnits(int frame, int moveRate);
+
+	unsigned int numCallIns = 0;
+};
+
+struct MockUnit {
+	unsigned char CalcLosStatus(int at) const {
+		const TestObject& o = world->objects[id];
+		const unsigned char inSight = world->sightMap[((o.z * MAP_SIZE) + o.x) * NUM_ALLYTEAMS + at];
+
+		return (inSight | (inSight << 1) | (losStatus[at] & (2 | MOCK_MASK_BITS)));
+	}
+
+	void SetLosStatus(int at, unsigned char newStatus) {
+		const unsigned char prevStatus = losStatus[at];
+
+		// a no-op, like CUnit's
+		if (prevStatus == newStatus)
+			return;
+
+		CommitLosStatus(at, newStatus);
+		LosStatusChanged(at, prevStatus, newStatus);
+	}
+
+	void CommitLosStatus(int at, unsigned char newStatus) {
+		losStatus[at] = newStatus;
+
+		CSyncChecker::Sync(&id, sizeof(id));
+		CSyncChecker::Sync(&at, sizeof(at));
+		CSyncChecker::Sync(&losStatus[at], sizeof(losStatus[at]));
+	}
+
+	void LosStatusChanged(int at, unsigned char prevStatus, unsigned char newStatus) {
+		const unsigned char diffBits = prevStatus ^ newStatus;
+
+		if ((diffBits & MOCK_EVENT_BITS) == 0 || (newStatus & MOCK_EVENT_BITS) == 0)
+			return;
+
+		const int otherId = (id * 7919 + at * 104729) % NUM_OBJECTS;
+
+		TestObject& other = world->objects[otherId];
+		other.x = (other.x + 17) % MAP_SIZE;
+		other.z = (other.z + 31) % MAP_SIZE;
+
+		if ((otherId % 5) == 0)
+			world->units[otherId].losStatus[at] |= MOCK_MASK_BITS;
+
+		CSyncChecker::Sync(&otherId, sizeof(otherId));
+
+		world->numCallIns += 1;
+	}
+
+	void UpdateLosStatus(int at) {
+		if ((losStatus[at] & MOCK_MASK_BITS) == MOCK_MASK_BITS)
+			return;
+
+		SetLosStatus(at, CalcLosStatus(at));
+	}
+
+	MockWorld* world = nullptr;
+	int id = 0;
+
+	std::array<unsigned char, NUM_ALLYTEAMS> losStatus = {{0}};
+};
+
+MockWorld::MockWorld() {
+	units.resize(objects.size());
+
+	for (size_t i = 0; i < units.size(); i++) {
+		units[i].world = this;
+		units[i].id = i;
+		unitPtrs.push_back(&units[i]);
+	}
+}
+
+// moves about <moveRate> per mille of the units to another square
+void MockWorld::TeleportUnits(int frame, int moveRate) {
+	for (size_t i = 0; i < objects.size(); i++) {
+		const unsigned int hash = (i * 2654435761u) ^ (frame * 40503u);
+
+		if (((hash >> 7) % 1000) >= unsigned(moveRate))
+			continue;
+
+		objects[i].x = (hash >> 3) % MAP_SIZE;
+		objects[i].z = (hash >> 11) % MAP_SIZE;
+	}
+}
+
+
+// what CLosStatusUpdater should be equivalent to: the serial loop, with
+// all call-ins run (in order) once every status has been committed
+static void UpdateLosStatusesDeferred(MockWorld& world)
+{
+	struct LosEvent {
+		MockUnit* unit;
+		int at;
+		unsigned char prevStatus;
+		unsigned char newStatus;
+	};
+
+	std::vector<LosEvent> events;
+
+	for (MockUnit* unit: world.unitPtrs) {
+		for (int at = 0; at < NUM_ALLYTEAMS; ++at) {
+			const unsigned char prevStatus = unit->losStatus[at];
+
+			if ((prevStatus & MOCK_MASK_BITS) == MOCK_MASK_BITS)
+				continue;
+
+			const unsigned char newStatus = unit->CalcLosStatus(at);
+
+			if (newStatus == prevStatus)
+				continue;
+
+			unit->CommitLosStatus(at, newStatus);
+
+			if (((prevStatus ^ newStatus) & MOCK_EVENT_BITS) != 0)
+				events.push_back({unit, at, prevStatus, newStatus});
+		}
+	}
+
+	for (const LosEvent& e: events) {
+		if (((e.unit->losStatus[e.at] ^ e.newStatus) & MOCK_EVENT_BITS) != 0)
+			continue;
+
+		e.unit->LosStatusChanged(e.at, e.prevStatus, e.newStatus);
+	}
+}
+
+static void UpdateLosStatusesSerial(MockWorld& world)
+{
+	for (MockUnit* unit: world.unitPtrs) {
+		for (int at = 0; at < NUM_ALLYTEAMS; ++at) {
+			unit->UpdateLosStatus(at);
+		}
+	}
+}
+
+
+TEST_CASE("DeferredWriteBufferOrder")
+{
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	DeferredWriteBuffer<int> writes;
+	std::vector<int> committed;
+
+	for_mt(0, NUM_OBJECTS, [&](const int i) {
+		// only push odd keys, in reverse
+		if ((i & 1) != 0)
+			writes.Push(NUM_OBJECTS - i, i);
+	});
+
+	CHECK(writes.Size() == (NUM_OBJECTS / 2));
+
+	writes.Commit([&](uint64_t key, const int value) {
+		CHECK(int(key) == (NUM_OBJECTS - value));
+		committed.push_back(key);
+	});
+
+	CHECK(writes.Size() == 0);
+	CHECK(committed.size() == (NUM_OBJECTS / 2));
+	CHECK(std::is_sorted(committed.begin(), committed.end()));
+
+	ThreadPool::SetThreadCount(0);
+}
+
+TEST_CASE("DeferredWriteBufferSyncChecksum")
+{
+	LOG("[%s] threads=%d objects=%d frames=%d", __func__, ThreadPool::GetMaxThreads(), NUM_OBJECTS, NUM_FRAMES);
+
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	TestWorld serialWorld;
+	TestWorld threadedWorld;
+	DeferredWriteBuffer<unsigned char> writes;
+
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		serialWorld.UpdateSightMap(frame);
+		threadedWorld.UpdateSightMap(frame);
+
+		const unsigned serialChecksum = RunSerial(serialWorld);
+		const unsigned threadedChecksum = RunThreaded(threadedWorld, writes);
+
+		CHECK(serialChecksum == threadedChecksum);
+
+		serialWorld.MoveObjects(frame);
+		threadedWorld.MoveObjects(frame);
+	}
+
+	ThreadPool::SetThreadCount(0);
+}
+
+TEST_CASE("LosStatusUpdaterSyncChecksum")
+{
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	MockWorld serialWorld;
+	MockWorld threadedWorld;
+	CLosStatusUpdater<MockUnit, unsigned char> updater(MOCK_MASK_BITS, MOCK_EVENT_BITS);
+
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		serialWorld.UpdateSightMap(frame);
+		threadedWorld.UpdateSightMap(frame);
+
+		CSyncChecker::NewFrame();
+		UpdateLosStatusesDeferred(serialWorld);
+
+		const unsigned serialChecksum = CSyncChecker::GetChecksum();
+
+		CSyncChecker::NewFrame();
+		updater.Update(threadedWorld.unitPtrs, NUM_ALLYTEAMS);
+
+		const unsigned threadedChecksum = CSyncChecker::GetChecksum();
+
+		CHECK(serialChecksum == threadedChecksum);
+
+		serialWorld.MoveObjects(frame);
+		threadedWorld.MoveObjects(frame);
+	}
+
+	// the call-ins must actually have interfered for this to mean anything
+	CHECK(serialWorld.numCallIns > 0);
+	CHECK(serialWorld.numCallIns == threadedWorld.numCallIns);
+
+	bool sameStatuses = true;
+
+	for (size_t i = 0; i < serialWorld.units.size(); i++) {
+		sameStatuses &= (serialWorld.units[i].losStatus == threadedWorld.units[i].losStatus);
+	}
+
+	CHECK(sameStatuses);
+
+	ThreadPool::SetThreadCount(0);
+}
+
+TEST_CASE("LosStatusUpdaterBenchmark")
+{
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	CLosStatusUpdater<MockUnit, unsigned char> updater(MOCK_MASK_BITS, MOCK_EVENT_BITS);
+
+	// per mille of units moving to a random square each frame, about half
+	// of which change status; real games sit at the low end of this range
+	for (const int moveRate: {2, 20, 200}) {
+		MockWorld serialWorld;
+		MockWorld threadedWorld;
+
+		serialWorld.UpdateSightMap(0);
+		threadedWorld.UpdateSightMap(0);
+
+		spring_time serialTime;
+		spring_time threadedTime;
+
+		for (int frame = 0; frame < NUM_FRAMES * 10; frame++) {
+			serialWorld.TeleportUnits(frame, moveRate);
+			threadedWorld.TeleportUnits(frame, moveRate);
+
+			const spring_time t0 = spring_gettime();
+			UpdateLosStatusesSerial(serialWorld);
+			const spring_time t1 = spring_gettime();
+			updater.Update(threadedWorld.unitPtrs, NUM_ALLYTEAMS);
+			const spring_time t2 = spring_gettime();
+
+			serialTime += (t1 - t0);
+			threadedTime += (t2 - t1);
+		}
+
+		LOG("[%s] threads=%d moveRate=%d/1000 callIns=%u serial=%.2fms threaded=%.2fms", __func__, ThreadPool::GetNumThreads(), moveRate, threadedWorld.numCallIns, serialTime.toMilliSecsf(), threadedTime.toMilliSecsf());
+	}
+
+	ThreadPool::SetThreadCount(0);
+}
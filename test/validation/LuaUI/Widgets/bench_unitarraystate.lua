@@ -0,0 +1,94 @@
+function widget:GetInfo()
+return {
+	name    = "Bench-UnitArrayState",
+	desc    = "Compares per-unit Spring.GetUnit* calls against Spring.GetUnitArrayState",
+	author  = "",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = false, -- benchmark, enable manually
+}
+end
+
+local interval = 300 -- frames between two benchmark runs
+local passes = 50 -- repetitions per run, timers have millisecond resolution
+
+local GetTimer = Spring.GetTimer
+local DiffTimers = Spring.DiffTimers
+local GetUnitPosition = Spring.GetUnitPosition
+local GetUnitVelocity = Spring.GetUnitVelocity
+local GetUnitHealth = Spring.GetUnitHealth
+local GetUnitArrayState = Spring.GetUnitArrayState
+
+local fields = {"position", "velocity", "health"}
+local stride = 3 + 4 + 5
+
+local singleState = {}
+local arrayState = {}
+
+-- same layout as GetUnitArrayState; both paths fill a reused table
+-- and neither creates one per call
+local function SetValues3(i, a, b, c)
+	singleState[i + 1], singleState[i + 2], singleState[i + 3] = a, b, c
+	return i + 3
+end
+
+local function SetValues4(i, a, b, c, d)
+	singleState[i + 1], singleState[i + 2], singleState[i + 3], singleState[i + 4] = a, b, c, d
+	return i + 4
+end
+
+local function SetValues5(i, a, b, c, d, e)
+	singleState[i + 1], singleState[i + 2], singleState[i + 3], singleState[i + 4], singleState[i + 5] = a, b, c, d, e
+	return i + 5
+end
+
+local function GetSingleState(units)
+	local i = 0
+	for n = 1, #units do
+		local unitID = units[n]
+		i = SetValues3(i, GetUnitPosition(unitID))
+		i = SetValues4(i, GetUnitVelocity(unitID))
+		i = SetValues5(i, GetUnitHealth(unitID))
+	end
+end
+
+local function GetArrayState(units)
+	local _, s = GetUnitArrayState(units, fields, arrayState)
+	if s ~= stride then
+		Spring.Log("bench_unitarraystate.lua", LOG.ERROR, string.format("stride %i, expected %i", s, stride))
+	end
+end
+
+local function Compare(units)
+	for i = 1, #units * stride do
+		if singleState[i] ~= arrayState[i] then
+			Spring.Log("bench_unitarraystate.lua", LOG.ERROR, string.format("unit %i value %i differs: %s vs %s",
+				units[math.floor((i - 1) / stride) + 1], i, tostring(singleState[i]), tostring(arrayState[i])))
+			return
+		end
+	end
+end
+
+local function Run(units, func)
+	local timer = GetTimer()
+	for p = 1, passes do
+		func(units)
+	end
+	return DiffTimers(GetTimer(), timer, true) / passes
+end
+
+function widget:GameFrame(n)
+	if (n % interval) ~= 0 then
+		return
+	end
+
+	local units = Spring.GetAllUnits()
+
+	local singleTime = Run(units, GetSingleState)
+	local arrayTime = Run(units, GetArrayState)
+
+	Compare(units)
+
+	Spring.Echo(string.format("[UnitArrayState] frame %i units %i: per-unit %.3fms, batched %.3fms", n, #units, singleTime, arrayTime))
+end
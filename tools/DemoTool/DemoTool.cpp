@@ -5,10 +5,20 @@
 #include <iostream>
 #include <gflags/gflags.h>
 #include <iomanip> //hex
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #include "StringSerializer.h"
 
 #include "Net/Protocol/BaseNetProtocol.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileSystemAbstraction.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/LoadSave/DemoReader.h"
 #include "System/Net/RawPacket.h"
 #include "Sim/Units/CommandAI/Command.h"
@@ -17,6 +27,12 @@
 Usage:
 Start with the full! path to the demofile as the only argument
 
+Batch mode (--batch) takes a directory (searched recursively for *.sdfz and *.sdfi) or
+a text file listing one demo per line, analyses the demos on --threads
+workers and writes one row per player and team of every demo to --output
+(stdout by default) as CSV or JSON lines (--format). A throughput summary
+is printed to stderr at the end.
+
 Please note that not all NETMSG's are implemented, expand if needed.
 
 When compiling for windows with MinGW, make sure to use the
@@ -32,10 +48,15 @@ no console output (you still could use this.exe > z.tzt though).
 	DEFINE_bool  (teamstats,    false, "Print teamstats");
 	DEFINE_int32 (team,         -1,    "Select team");
 	DEFINE_string(teamsstatcsv, "",    "Write teamstats in a csv file");
+	DEFINE_string(batch,        "",    "Analyse all demos in a directory or listed in a file");
+	DEFINE_int32 (threads,      0,     "Worker threads for batch mode (0: one per core)");
+	DEFINE_string(format,       "csv", "Batch report format: csv or json (one object per line)");
+	DEFINE_string(output,       "",    "Batch report file (default: stdout)");
 
 
 void TrafficDump(CDemoReader& reader, bool trafficStats);
 void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string& file);
+int BatchAnalyse(const std::string& batchPath);
 
 int main (int argc, char* argv[])
 {
@@ -43,6 +64,9 @@ int main (int argc, char* argv[])
 
 	gflags::SetUsageMessage(std::string("Usage: ") + argv[0] + " [options] path_to_demo.sdfz");
 	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (!FLAGS_batch.empty()) {
+		return BatchAnalyse(FLAGS_batch);
+	}
 	if (!FLAGS_demofile.empty()) {
 		filename = FLAGS_demofile;
 	} else if (argc >= 2) {
@@ -504,3 +528,372 @@ void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string&
 		exit(1);
 	}
 };
+
+
+
+struct PlayerTraffic {
+	unsigned int numPackets = 0;
+	unsigned int numBytes = 0;
+	unsigned int numCommands = 0;
+	unsigned int numSelects = 0;
+	unsigned int numChats = 0;
+	unsigned int numLuaMsgs = 0;
+	unsigned int numMapDraws = 0;
+};
+
+struct DemoSummary {
+	std::string name;
+	std::string gameID;
+
+	int numFrames = 0;
+	int gameTime = 0;
+
+	std::vector<PlayerTraffic> players;
+};
+
+
+/** @return the player a packet was sent by, or -1 for server / unknown messages */
+static int GetPacketPlayerNum(const netcode::RawPacket* packet)
+{
+	const unsigned char* buffer = packet->data;
+
+	switch (buffer[0]) {
+		case NETMSG_COMMAND:
+		case NETMSG_SELECT:
+		case NETMSG_AICOMMAND:
+		case NETMSG_AICOMMANDS:
+		case NETMSG_LUAMSG:
+			return ((packet->length > 3)? buffer[3]: -1);
+		case NETMSG_CHAT:
+		case NETMSG_MAPDRAW:
+		case NETMSG_PLAYERNAME:
+			return ((packet->length > 2)? buffer[2]: -1);
+		case NETMSG_SHARE:
+		case NETMSG_SETSHARE:
+		case NETMSG_PAUSE:
+		case NETMSG_TEAM:
+		case NETMSG_STARTPOS:
+		case NETMSG_DIRECT_CONTROL:
+		case NETMSG_DC_UPDATE:
+		case NETMSG_PLAYERSTAT:
+			return ((packet->length > 1)? buffer[1]: -1);
+		default:
+			break;
+	}
+
+	return -1;
+}
+
+/** @brief reads packets one by one, nothing but the per-player counters is kept */
+static void AnalyseDemo(CDemoReader& reader, DemoSummary& summary)
+{
+	while (!reader.ReachedEnd()) {
+		netcode::RawPacket* packet = reader.GetData(3.402823466e+38f);
+
+		if (packet == nullptr)
+			continue;
+		if (packet->length == 0) {
+			delete packet;
+			continue;
+		}
+
+		const unsigned char* buffer = packet->data;
+		const int playerNum = GetPacketPlayerNum(packet);
+
+		switch (buffer[0]) {
+			case NETMSG_NEWFRAME:
+			case NETMSG_KEYFRAME:
+				summary.numFrames++;
+				break;
+			default:
+				break;
+		}
+
+		if (playerNum < 0) {
+			delete packet;
+			continue;
+		}
+
+		if (size_t(playerNum) >= summary.players.size())
+			summary.players.resize(playerNum + 1);
+
+		PlayerTraffic& traffic = summary.players[playerNum];
+		traffic.numPackets += 1;
+		traffic.numBytes += packet->length;
+
+		switch (buffer[0]) {
+			case NETMSG_COMMAND:
+			case NETMSG_AICOMMAND:
+				traffic.numCommands += 1;
+				break;
+			case NETMSG_AICOMMANDS: {
+				// uint8_t msgid; uint16_t msgsize; uint8_t playerNum, aiID, pairwise; ...; int16_t unitIDCount, unitIDs[], cmdCount
+				if (packet->length < 15)
+					break;
+
+				const short unitIDCount = *((short*)(buffer + 13));
+
+				if (unitIDCount >= 0 && packet->length >= (17u + unitIDCount * 2u))
+					traffic.numCommands += *((short*)(buffer + 15 + unitIDCount * 2));
+			} break;
+			case NETMSG_SELECT:
+				traffic.numSelects += 1;
+				break;
+			case NETMSG_CHAT:
+				traffic.numChats += 1;
+				break;
+			case NETMSG_LUAMSG:
+				traffic.numLuaMsgs += 1;
+				break;
+			case NETMSG_MAPDRAW:
+				traffic.numMapDraws += 1;
+				break;
+			default:
+				break;
+		}
+
+		delete packet;
+	}
+}
+
+
+static void ListBatchDemos(const std::string& batchPath, std::vector<std::string>& demoFiles)
+{
+	if (FileSystemAbstraction::DirExists(batchPath)) {
+		const std::string dataDir = FileSystemAbstraction::EnsurePathSepAtEnd(batchPath);
+		const std::string pattern = FileSystem::ConvertGlobToRegex("*.{sdfz,sdfi}");
+
+		FileSystemAbstraction::FindFiles(demoFiles, dataDir, "", pattern, FileQueryFlags::RECURSE);
+
+		for (std::string& demoFile: demoFiles) {
+			demoFile = dataDir + demoFile;
+		}
+
+		// directory order is arbitrary
+		std::sort(demoFiles.begin(), demoFiles.end());
+		return;
+	}
+
+	std::ifstream listFile(batchPath.c_str());
+	std::string line;
+
+	while (std::getline(listFile, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty())
+			demoFiles.push_back(line);
+	}
+}
+
+static std::string EscapeJSON(const std::string& str)
+{
+	std::string ret;
+	ret.reserve(str.size());
+
+	for (const char c: str) {
+		switch (c) {
+			case '"' : { ret += "\\\""; } break;
+			case '\\': { ret += "\\\\"; } break;
+			case '\n': { ret += "\\n"; } break;
+			default: {
+				if ((unsigned char)c < 0x20)
+					continue;
+
+				ret += c;
+			} break;
+		}
+	}
+
+	return ret;
+}
+
+static std::string EscapeCSV(const std::string& str)
+{
+	if (str.find_first_of(",\"\n") == std::string::npos)
+		return str;
+
+	std::string ret = "\"";
+
+	for (const char c: str) {
+		ret += c;
+		ret += (c == '"')? "\"": "";
+	}
+
+	return (ret + "\"");
+}
+
+static const char* BATCH_COLUMNS[] = {
+	"demo", "gameID", "frames", "gameTime", "row", "id",
+	"packets", "bytes", "commands", "selects", "chats", "luaMsgs", "mapDraws",
+	"metalProduced", "energyProduced", "metalUsed", "energyUsed", "damageDealt", "damageReceived",
+	"unitsProduced", "unitsKilled", "unitsDied",
+};
+
+/** @brief formats all rows (players, then teams) of one demo */
+static void WriteBatchRows(std::ostream& out, const DemoSummary& summary, const CDemoReader& reader, bool json)
+{
+	const std::vector< std::vector<TeamStatistics> >& teamStats = reader.GetTeamStats();
+
+	const auto WriteRow = [&](const char* rowType, unsigned int id, const std::vector<double>& values) {
+		const size_t numFixed = 6;
+
+		if (json) {
+			out << "{\"demo\":\"" << EscapeJSON(summary.name) << "\",\"gameID\":\"" << summary.gameID << "\"";
+			out << ",\"frames\":" << summary.numFrames << ",\"gameTime\":" << summary.gameTime;
+			out << ",\"row\":\"" << rowType << "\",\"id\":" << id;
+
+			for (size_t i = 0; i < values.size(); i++) {
+				if (values[i] < 0.0)
+					continue;
+
+				out << ",\"" << BATCH_COLUMNS[numFixed + i] << "\":" << values[i];
+			}
+
+			out << "}\n";
+			return;
+		}
+
+		out << EscapeCSV(summary.name) << "," << summary.gameID << "," << summary.numFrames << "," << summary.gameTime;
+		out << "," << rowType << "," << id;
+
+		// columns that do not apply to this row-type are left empty
+		for (const double value: values) {
+			out << ",";
+
+			if (value >= 0.0)
+				out << value;
+		}
+
+		out << "\n";
+	};
+
+	for (size_t i = 0; i < summary.players.size(); i++) {
+		const PlayerTraffic& p = summary.players[i];
+
+		if (p.numPackets == 0)
+			continue;
+
+		WriteRow("player", i, {
+			double(p.numPackets), double(p.numBytes), double(p.numCommands), double(p.numSelects),
+			double(p.numChats), double(p.numLuaMsgs), double(p.numMapDraws),
+			-1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0,
+		});
+	}
+
+	for (size_t i = 0; i < teamStats.size(); i++) {
+		if (teamStats[i].empty())
+			continue;
+
+		// statistics are cumulative, the last entry covers the whole game
+		const TeamStatistics& t = teamStats[i].back();
+
+		WriteRow("team", i, {
+			-1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0,
+			t.metalProduced, t.energyProduced, t.metalUsed, t.energyUsed, t.damageDealt, t.damageReceived,
+			double(t.unitsProduced), double(t.unitsKilled), double(t.unitsDied),
+		});
+	}
+}
+
+int BatchAnalyse(const std::string& batchPath)
+{
+	std::vector<std::string> demoFiles;
+	ListBatchDemos(batchPath, demoFiles);
+
+	if (demoFiles.empty()) {
+		std::cerr << "No demos found in " << batchPath << std::endl;
+		return 1;
+	}
+
+	const bool json = (FLAGS_format == "json");
+	const unsigned int numThreads = std::min(size_t((FLAGS_threads > 0)? FLAGS_threads: std::max(std::thread::hardware_concurrency(), 1u)), demoFiles.size());
+
+	std::ofstream outFile;
+	std::ostream& out = FLAGS_output.empty()? std::cout: outFile;
+
+	if (!FLAGS_output.empty()) {
+		outFile.open(FLAGS_output.c_str(), std::ios::out | std::ios::trunc);
+
+		if (!outFile.is_open()) {
+			std::cerr << "Could not open " << FLAGS_output << " for writing" << std::endl;
+			return 1;
+		}
+	}
+
+	if (!json) {
+		for (size_t i = 0; i < (sizeof(BATCH_COLUMNS) / sizeof(BATCH_COLUMNS[0])); i++) {
+			out << ((i == 0)? "": ",") << BATCH_COLUMNS[i];
+		}
+
+		out << "\n";
+	}
+
+	std::atomic<size_t> nextDemoIdx = {0};
+	std::atomic<size_t> numFailed = {0};
+	std::atomic<size_t> numBytes = {0};
+
+	std::mutex outMutex;
+	std::vector<std::thread> workers;
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	const auto WorkerFunc = [&]() {
+		std::ostringstream rows;
+
+		for (size_t demoIdx = nextDemoIdx++; demoIdx < demoFiles.size(); demoIdx = nextDemoIdx++) {
+			const std::string& demoFile = demoFiles[demoIdx];
+
+			try {
+				CDemoReader reader(demoFile, 0.0f);
+				DemoSummary summary;
+
+				summary.name = demoFile;
+				summary.gameTime = reader.GetFileHeader().gameTime;
+
+				std::ostringstream gameID;
+				for (const unsigned char c: reader.GetFileHeader().gameID) {
+					gameID << std::setw(2) << std::setfill('0') << std::hex << (int)c;
+				}
+				summary.gameID = gameID.str();
+
+				AnalyseDemo(reader, summary);
+				reader.LoadStats();
+
+				// rows of one demo are written together, demos finish in any order
+				rows.str("");
+				WriteBatchRows(rows, summary, reader, json);
+
+				numBytes += FileSystemAbstraction::GetFileSize(demoFile);
+
+				std::lock_guard<std::mutex> lock(outMutex);
+				out << rows.str();
+			} catch (const std::exception& ex) {
+				numFailed++;
+
+				std::lock_guard<std::mutex> lock(outMutex);
+				std::cerr << "Skipping " << demoFile << ": " << ex.what() << std::endl;
+			}
+		}
+	};
+
+	for (unsigned int i = 1; i < numThreads; i++) {
+		workers.emplace_back(WorkerFunc);
+	}
+
+	WorkerFunc();
+
+	for (std::thread& worker: workers) {
+		worker.join();
+	}
+
+	out.flush();
+
+	const double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count(), 1e-6);
+	const size_t numAnalysed = demoFiles.size() - numFailed;
+
+	std::cerr << std::fixed << std::setprecision(2);
+	std::cerr << "Analysed " << numAnalysed << " of " << demoFiles.size() << " demos on " << numThreads << " threads in " << seconds << "s: ";
+	std::cerr << (numAnalysed / seconds) << " demos/s, " << (numBytes / (1024.0 * 1024.0) / seconds) << " MB/s" << std::endl;
+
+	return ((numFailed == 0)? 0: 2);
+}